@@ -1,11 +1,13 @@
 HEADERS += \
     $$PWD/acquisitionmanager.h \
+    $$PWD/shotqueue.h \
     $$PWD/batch/batchmanager.h \
     $$PWD/batch/batchsequence.h \
     $$PWD/batch/batchsingle.h
 
 SOURCES += \
     $$PWD/acquisitionmanager.cpp \
+    $$PWD/shotqueue.cpp \
     $$PWD/batch/batchmanager.cpp \
     $$PWD/batch/batchsequence.cpp \
     $$PWD/batch/batchsingle.cpp
@@ -6,6 +6,10 @@
 
 AcquisitionManager::AcquisitionManager(QObject *parent) : QObject(parent), d_state(Idle)
 {
+    ps_ftmwShotQueue = std::make_shared<ShotQueue>();
+    ps_ftmwShotQueue->setNotifier([this](){
+        QMetaObject::invokeMethod(this,&AcquisitionManager::processFtmwShotQueue,Qt::QueuedConnection);
+    });
 }
 
 AcquisitionManager::~AcquisitionManager()
@@ -19,11 +23,48 @@ void AcquisitionManager::beginExperiment(std::shared_ptr<Experiment> exp)
     d_state = Acquiring;
     emit statusMessage(QString("Acquiring"));
 
+    d_storageTiming.clear();
+    d_deadTiming.clear();
+    d_transitionTimer.invalidate();
+#ifdef BC_LIF
+    d_lifStorageTiming.clear();
+    d_lifDeadTiming.clear();
+    d_lifTransitionTimer.invalidate();
+#endif
+    d_ingestShots = 0;
+    d_ingestBatches = 0;
+    d_ingestNs = 0;
+    d_ingestClock.start();
+
+    if(ps_currentExperiment->ftmwEnabled())
+    {
+        using namespace BC::Key::ShotQueue;
+        SettingsStorage s(key);
+        auto ftmw = ps_currentExperiment->ftmwConfig();
+        auto p = static_cast<ShotQueue::Policy>(s.get<int>(policy,ShotQueue::Block));
+#ifdef BC_CUDA
+        //the GPU keeps its own running sum, so shots cannot be merged outside of it
+        if(p == ShotQueue::Coalesce)
+            p = ShotQueue::DropOldest;
+#endif
+        auto ep = ShotQueue::effectivePolicy(p,ftmw->d_chirpScoringEnabled,ftmw->d_phaseCorrectionEnabled);
+        if(ep != p)
+        {
+            emit logMessage(QString("Shot queue cannot coalesce shots when chirp scoring or phase correction is enabled. Dropping the oldest shot on overflow instead."),LogHandler::Warning);
+            p = ep;
+        }
+        ps_ftmwShotQueue->reset(ftmw->d_scopeConfig,ftmw->bitShift(),s.get<int>(capacity,16),p);
+        d_batchLatencyMs = s.get<int>(batchLatencyMs,50);
+    }
+
     if(ps_currentExperiment->d_timeDataInterval > 0)
     {
         if(ps_currentExperiment->ftmwEnabled())
         {
             ps_currentExperiment->auxData()->registerKey(QString("Ftmw"),QString("Shots"));
+            ps_currentExperiment->auxData()->registerKey(QString("Ftmw"),QString("DroppedShots"));
+            if(ps_ftmwShotQueue->policy() == ShotQueue::Coalesce)
+                ps_currentExperiment->auxData()->registerKey(QString("Ftmw"),QString("CoalescedShots"));
             if(ps_currentExperiment->ftmwConfig()->d_phaseCorrectionEnabled)
             {
                 ps_currentExperiment->auxData()->registerKey(QString("Ftmw"),QString("ChirpPhaseScore"));
@@ -47,35 +88,159 @@ void AcquisitionManager::beginExperiment(std::shared_ptr<Experiment> exp)
 
 void AcquisitionManager::processFtmwScopeShot(const QByteArray b)
 {
-    if(d_state == Acquiring
-            && ps_currentExperiment->ftmwEnabled()
-            && !ps_currentExperiment->ftmwConfig()->isComplete()
-            && !ps_currentExperiment->ftmwConfig()->d_processingPaused)
+    if(ftmwReady())
+    {
+        QElapsedTimer t;
+        t.start();
+        ftmwShotProcessed(ps_currentExperiment->ftmwConfig()->addFids(b));
+        if(d_state == Idle)
+            return;
+
+        ftmwBatchProcessed();
+        recordIngest(1,t.nsecsElapsed());
+    }
+
+    checkComplete();
+}
+
+void AcquisitionManager::processFtmwShotQueue()
+{
+    //acknowledge first so that any shot pushed from here on generates a new notification
+    ps_ftmwShotQueue->acknowledge();
+
+    if(d_batchLatencyMs > 0)
+        ingestFtmwBatch();
+    else
     {
+        //handle at most one queue's worth of shots before returning to the event loop
+        //so that pause/abort/clock events are not starved
+        for(int i=0; i<ps_ftmwShotQueue->capacity(); ++i)
+        {
+            if(!ps_ftmwShotQueue->pop(d_ftmwShotBuffer))
+                break;
 
-        bool success = ps_currentExperiment->ftmwConfig()->addFids(b);
-        auto errStr = ps_currentExperiment->ftmwConfig()->d_errorString;
+            processFtmwScopeShot(d_ftmwShotBuffer);
+            if(d_state == Idle)
+                return;
+        }
+    }
 
-        if(!success)
+    if(d_state == Idle)
+        return;
+
+    FidList coalesced;
+    if(ps_ftmwShotQueue->takeCoalesced(coalesced))
+    {
+        if(ftmwReady())
         {
-            emit logMessage("Error processing FID data.",LogHandler::Error);
-            abort();
-            return;
+            ftmwShotProcessed(ps_currentExperiment->ftmwConfig()->addFids(coalesced));
+            if(d_state == Idle)
+                return;
+            ftmwBatchProcessed();
         }
-        else if(!errStr.isEmpty())
-            emit logMessage(errStr,LogHandler::Warning);
+        checkComplete();
+    }
+
+    if(d_state != Idle && ps_ftmwShotQueue->size() > 0)
+        QMetaObject::invokeMethod(this,&AcquisitionManager::processFtmwShotQueue,Qt::QueuedConnection);
+}
+
+void AcquisitionManager::ingestFtmwBatch()
+{
+    //add each queued shot to the running sum as it is popped, and do the per-batch bookkeeping
+    //(autosave, progress, backup and completion checks) once at the end. The batch ends early
+    //at a segment boundary or when the objective is met, and after d_batchLatencyMs so that
+    //pause/abort/clock events and the progress display are not held up
+    QElapsedTimer t;
+    t.start();
+    int n = 0;
+    while(t.elapsed() < d_batchLatencyMs && ps_ftmwShotQueue->pop(d_ftmwShotBuffer))
+    {
+        //shots that arrive while paused or retuning are discarded, as for single shots
+        if(!ftmwReady())
+            continue;
 
-        bool advanceSegment = ps_currentExperiment->ftmwConfig()->advance();
+        n++;
+        if(ftmwShotProcessed(ps_currentExperiment->ftmwConfig()->addFids(d_ftmwShotBuffer)))
+            break;
+    }
 
-        if(advanceSegment)
-            emit newClockSettings(ps_currentExperiment->ftmwConfig()->d_rfConfig.getClocks());
+    if(d_state == Idle)
+        return;
 
-        emit ftmwUpdateProgress(ps_currentExperiment->ftmwConfig()->perMilComplete());
+    if(n > 0)
+    {
+        ftmwBatchProcessed();
+        recordIngest(n,t.nsecsElapsed());
     }
 
     checkComplete();
 }
 
+bool AcquisitionManager::ftmwReady() const
+{
+    return d_state == Acquiring
+            && ps_currentExperiment->ftmwEnabled()
+            && !ps_currentExperiment->ftmwConfig()->isComplete()
+            && !ps_currentExperiment->ftmwConfig()->d_processingPaused;
+}
+
+bool AcquisitionManager::ftmwShotProcessed(bool success)
+{
+    //returns true if no more shots should be added before the bookkeeping is done
+    auto errStr = ps_currentExperiment->ftmwConfig()->d_errorString;
+
+    if(!success)
+    {
+        emit logMessage("Error processing FID data.",LogHandler::Error);
+        if(!errStr.isEmpty())
+            emit logMessage(errStr,LogHandler::Error);
+        abort();
+        return true;
+    }
+    else if(!errStr.isEmpty())
+        emit logMessage(errStr,LogHandler::Warning);
+
+    auto ftmw = ps_currentExperiment->ftmwConfig();
+    if(ftmw->beginSegmentTransition())
+    {
+        //start retuning before saving the outgoing segment and loading the incoming one,
+        //so that the clocks settle while storage is busy
+        d_transitionTimer.start();
+        bool next = !ftmw->isComplete();
+        if(next)
+            emit newClockSettings(ftmw->d_rfConfig.getClocks());
+
+        QElapsedTimer st;
+        st.start();
+        ftmw->finishSegmentTransition();
+        auto ms = st.nsecsElapsed()/1e6;
+        d_storageTiming.add(ms);
+        emit logMessage(QString("Segment storage step: %1 ms").arg(ms,0,'f',1),LogHandler::Debug);
+
+        if(!next)
+            d_transitionTimer.invalidate();
+
+        return true;
+    }
+
+    return ftmw->isComplete();
+}
+
+void AcquisitionManager::ftmwBatchProcessed()
+{
+    auto ftmw = ps_currentExperiment->ftmwConfig();
+    ftmw->autosave();
+    emit ftmwUpdateProgress(ftmw->perMilComplete());
+}
+
+void AcquisitionManager::recordIngest(int shots, qint64 ns)
+{
+    d_ingestShots += shots;
+    d_ingestBatches++;
+    d_ingestNs += ns;
+}
+
 #ifdef BC_LIF
 void AcquisitionManager::processLifScopeShot(const QVector<qint8> b)
 {
@@ -85,9 +250,22 @@ void AcquisitionManager::processLifScopeShot(const QVector<qint8> b)
     {
         ps_currentExperiment->lifConfig()->addWaveform(b);
         emit lifPointUpdate();
-        if(ps_currentExperiment->lifConfig()->advance() && !ps_currentExperiment->isComplete())
-            emit nextLifPoint(ps_currentExperiment->lifConfig()->currentDelay(),
-                              ps_currentExperiment->lifConfig()->currentLaserPos());
+
+        //the completed trace is handed to a background writer inside advance(), so the move to
+        //the next point is requested as soon as the point finishes. The dead time runs until
+        //the hardware reports that the new delay and laser position are set.
+        QElapsedTimer st;
+        st.start();
+        if(ps_currentExperiment->lifConfig()->advance())
+        {
+            d_lifStorageTiming.add(st.nsecsElapsed()/1e6);
+            if(!ps_currentExperiment->isComplete())
+            {
+                d_lifTransitionTimer.start();
+                emit nextLifPoint(ps_currentExperiment->lifConfig()->currentDelay(),
+                                  ps_currentExperiment->lifConfig()->currentLaserPos());
+            }
+        }
 
         emit lifShotAcquired(ps_currentExperiment->lifConfig()->perMilComplete());
 
@@ -108,7 +286,17 @@ void AcquisitionManager::lifHardwareReady(bool success)
                 abort();
             }
             else
+            {
                 ps_currentExperiment->lifConfig()->hwReady();
+
+                if(d_lifTransitionTimer.isValid())
+                {
+                    auto ms = d_lifTransitionTimer.nsecsElapsed()/1e6;
+                    d_lifDeadTiming.add(ms);
+                    d_lifTransitionTimer.invalidate();
+                    emit logMessage(QString("LIF point dead time: %1 ms").arg(ms,0,'f',1),LogHandler::Debug);
+                }
+            }
         }
     }
 }
@@ -145,6 +333,14 @@ void AcquisitionManager::clockSettingsComplete(const QHash<RfConfig::ClockType,
     {
         ps_currentExperiment->ftmwConfig()->d_rfConfig.setCurrentClocks(clocks);
         ps_currentExperiment->ftmwConfig()->hwReady();
+
+        if(d_transitionTimer.isValid())
+        {
+            auto ms = d_transitionTimer.nsecsElapsed()/1e6;
+            d_deadTiming.add(ms);
+            d_transitionTimer.invalidate();
+            emit logMessage(QString("Segment transition dead time: %1 ms").arg(ms,0,'f',1),LogHandler::Debug);
+        }
     }
 }
 
@@ -183,6 +379,11 @@ void AcquisitionManager::auxDataTick()
         AuxDataStorage::AuxDataMap m;
         m.emplace(AuxDataStorage::makeKey("Ftmw","Shots"),
                   ps_currentExperiment->ftmwConfig()->completedShots());
+        m.emplace(AuxDataStorage::makeKey("Ftmw","DroppedShots"),
+                  ps_ftmwShotQueue->droppedShots());
+        if(ps_ftmwShotQueue->policy() == ShotQueue::Coalesce)
+            m.emplace(AuxDataStorage::makeKey("Ftmw","CoalescedShots"),
+                      ps_ftmwShotQueue->coalescedShots());
         if(ps_currentExperiment->ftmwConfig()->d_chirpScoringEnabled)
             m.emplace(AuxDataStorage::makeKey("Ftmw","ChirpRMS"),
                       ps_currentExperiment->ftmwConfig()->chirpRMS());
@@ -217,9 +418,34 @@ void AcquisitionManager::checkComplete()
 
 void AcquisitionManager::finishAcquisition()
 {
+    //release a scope thread that may be blocked on a full queue
+    ps_ftmwShotQueue->close();
     emit endAcquisition();
     d_state = Idle;
 
+    if(d_ingestShots > 0)
+    {
+        auto sec = d_ingestClock.nsecsElapsed()/1e9;
+        emit logMessage(QString("FTMW shots processed: %1 in %2 batches (%3 shots/batch), %4 shots/s, %5 us/shot")
+                        .arg(d_ingestShots).arg(d_ingestBatches)
+                        .arg(static_cast<double>(d_ingestShots)/d_ingestBatches,0,'f',1)
+                        .arg(sec > 0.0 ? d_ingestShots/sec : 0.0,0,'f',1)
+                        .arg(d_ingestNs/1e3/d_ingestShots,0,'f',1));
+    }
+
+    if(d_deadTiming.count() > 0)
+    {
+        emit logMessage(d_deadTiming.summary());
+        emit logMessage(d_storageTiming.summary());
+    }
+
+#ifdef BC_LIF
+    if(d_lifDeadTiming.count() > 0)
+    {
+        emit logMessage(d_lifDeadTiming.summary());
+        emit logMessage(d_lifStorageTiming.summary());
+    }
+#endif
 
     if(!ps_currentExperiment->isDummy())
     {
@@ -6,9 +6,13 @@
 #include <QTime>
 #include <QTimer>
 #include <QThread>
+#include <QElapsedTimer>
+#include <memory>
 
 #include <data/loghandler.h>
 #include <data/experiment/experiment.h>
+#include <data/analysis/timinghistogram.h>
+#include <acquisition/shotqueue.h>
 
 class AcquisitionManager : public QObject
 {
@@ -24,6 +28,8 @@ public:
         Paused
     };
 
+    std::shared_ptr<ShotQueue> ftmwShotQueue() const { return ps_ftmwShotQueue; }
+
 signals:
     void logMessage(QString,LogHandler::MessageCode = LogHandler::Normal);
     void statusMessage(QString,int=0);
@@ -49,6 +55,7 @@ signals:
 public slots:
     void beginExperiment(std::shared_ptr<Experiment> exp);
     void processFtmwScopeShot(const QByteArray b);
+    void processFtmwShotQueue();
     void processAuxData(AuxDataStorage::AuxDataMap m);
     void processValidationData(AuxDataStorage::AuxDataMap m);
     void clockSettingsComplete(const QHash<RfConfig::ClockType,RfConfig::ClockFreq> clocks);
@@ -65,7 +72,29 @@ private:
     std::shared_ptr<Experiment> ps_currentExperiment;
     AcquisitionState d_state;
     int d_auxTimerId;
+    std::shared_ptr<ShotQueue> ps_ftmwShotQueue;
+    QByteArray d_ftmwShotBuffer;
+
+    QElapsedTimer d_transitionTimer;
+    TimingHistogram d_storageTiming{"Segment storage"};
+    TimingHistogram d_deadTiming{"Segment transition dead time"};
+#ifdef BC_LIF
+    QElapsedTimer d_lifTransitionTimer;
+    TimingHistogram d_lifStorageTiming{"LIF point storage"};
+    TimingHistogram d_lifDeadTiming{"LIF point dead time"};
+#endif
+
+    int d_batchLatencyMs{0};
+    QElapsedTimer d_ingestClock;
+    quint64 d_ingestShots{0};
+    quint64 d_ingestBatches{0};
+    qint64 d_ingestNs{0};
 
+    bool ftmwReady() const;
+    void ingestFtmwBatch();
+    bool ftmwShotProcessed(bool success);
+    void ftmwBatchProcessed();
+    void recordIngest(int shots, qint64 ns);
     void auxDataTick();
     void checkComplete();
     void finishAcquisition();
@@ -0,0 +1,231 @@
+#include "shotqueue.h"
+
+#include <cstring>
+
+#include <data/experiment/digitizerconfig.h>
+#include <data/analysis/cpuaverager.h>
+
+ShotQueue::ShotQueue()
+{
+}
+
+ShotQueue::~ShotQueue()
+{
+    close();
+}
+
+ShotQueue::Policy ShotQueue::effectivePolicy(ShotQueue::Policy p, bool chirpScoring, bool phaseCorrection)
+{
+    //a coalesced sum is never scored or shifted, so it could carry rejected shots into the
+    //average or push it past the shot target
+    if(p == Coalesce && (chirpScoring || phaseCorrection))
+        return DropOldest;
+
+    return p;
+}
+
+bool ShotQueue::reset(const DigitizerConfig &cfg, quint8 bitShift, int capacity, ShotQueue::Policy p)
+{
+    //wake a blocked producer, then wait for any push in progress to return
+    close();
+    QMutexLocker pl(&d_pushMutex);
+
+    d_capacity = qMax(capacity,2);
+    d_shotBytes = cfg.d_numRecords*cfg.d_recordLength*cfg.d_bytesPerPoint;
+    d_policy = p;
+
+    pu_slots = std::make_unique<Slot[]>(d_capacity);
+    for(int i=0; i<d_capacity; ++i)
+    {
+        pu_slots[i].seq.store(i,std::memory_order_relaxed);
+        pu_slots[i].data = QByteArray(d_shotBytes,'\0');
+    }
+
+    d_enqueuePos.store(0);
+    d_dequeuePos.store(0);
+    d_dropped.store(0);
+    d_coalesced.store(0);
+    d_notified.store(false);
+
+    {
+        QMutexLocker l(&d_coalesceMutex);
+        d_coalescedList.clear();
+        pu_coalescer.reset();
+        if(d_policy == Coalesce)
+        {
+            pu_coalescer = std::make_unique<CpuAverager>();
+            if(!pu_coalescer->initialize(cfg,bitShift))
+            {
+                pu_coalescer.reset();
+                d_policy = DropOldest;
+            }
+        }
+    }
+
+    d_open.store(true);
+    return true;
+}
+
+void ShotQueue::close()
+{
+    d_open.store(false);
+    QMutexLocker l(&d_waitMutex);
+    d_slotFreed.wakeAll();
+}
+
+bool ShotQueue::push(const QByteArray &b)
+{
+    return push(b.constData(),b.size());
+}
+
+bool ShotQueue::push(const char *data, int size)
+{
+    QMutexLocker pl(&d_pushMutex);
+    if(!d_open.load(std::memory_order_acquire) || size != d_shotBytes)
+        return false;
+
+    if(!tryPush(data,size))
+    {
+        switch(d_policy) {
+        case Block:
+        {
+            QMutexLocker l(&d_waitMutex);
+            d_producerWaiting.store(true);
+            while(!tryPush(data,size))
+            {
+                if(!d_open.load(std::memory_order_acquire))
+                {
+                    d_producerWaiting.store(false);
+                    return false;
+                }
+                //the timeout guards against a wakeup that raced with d_producerWaiting
+                d_slotFreed.wait(&d_waitMutex,10);
+            }
+            d_producerWaiting.store(false);
+            break;
+        }
+        case DropOldest:
+            while(!tryPush(data,size))
+            {
+                if(tryPop(nullptr))
+                    d_dropped.fetch_add(1,std::memory_order_relaxed);
+            }
+            break;
+        case Coalesce:
+            coalesce(data,size);
+            break;
+        }
+    }
+
+    notify();
+    return true;
+}
+
+void ShotQueue::acknowledge()
+{
+    d_notified.store(false,std::memory_order_release);
+}
+
+bool ShotQueue::pop(QByteArray &out)
+{
+    if(!tryPop(&out))
+        return false;
+
+    if(d_producerWaiting.load(std::memory_order_acquire))
+    {
+        QMutexLocker l(&d_waitMutex);
+        d_slotFreed.wakeAll();
+    }
+
+    return true;
+}
+
+bool ShotQueue::takeCoalesced(FidList &out)
+{
+    if(d_policy != Coalesce)
+        return false;
+
+    QMutexLocker l(&d_coalesceMutex);
+    if(d_coalescedList.isEmpty())
+        return false;
+
+    out.swap(d_coalescedList);
+    d_coalescedList.clear();
+    return true;
+}
+
+int ShotQueue::size() const
+{
+    auto e = d_enqueuePos.load(std::memory_order_acquire);
+    auto d = d_dequeuePos.load(std::memory_order_acquire);
+    return e > d ? static_cast<int>(e-d) : 0;
+}
+
+bool ShotQueue::tryPush(const char *data, int size)
+{
+    if(!pu_slots)
+        return false;
+
+    //there is only one producer, so the enqueue position does not need a CAS
+    auto pos = d_enqueuePos.load(std::memory_order_relaxed);
+    auto &slot = pu_slots[pos % d_capacity];
+    auto seq = slot.seq.load(std::memory_order_acquire);
+    if(seq != pos)
+        return false;
+
+    //the slot's buffer may have been swapped in from the consumer
+    if(slot.data.size() != size)
+        slot.data.resize(size);
+    memcpy(slot.data.data(),data,size);
+
+    slot.seq.store(pos+1,std::memory_order_release);
+    d_enqueuePos.store(pos+1,std::memory_order_release);
+    return true;
+}
+
+bool ShotQueue::tryPop(QByteArray *out)
+{
+    if(!pu_slots)
+        return false;
+
+    //the producer may also dequeue (to drop the oldest shot), so claim with a CAS
+    auto pos = d_dequeuePos.load(std::memory_order_relaxed);
+    Slot *slot = nullptr;
+    while(true)
+    {
+        slot = &pu_slots[pos % d_capacity];
+        auto seq = slot->seq.load(std::memory_order_acquire);
+        auto diff = static_cast<qint64>(seq - (pos+1));
+        if(diff == 0)
+        {
+            if(d_dequeuePos.compare_exchange_weak(pos,pos+1,std::memory_order_relaxed))
+                break;
+        }
+        else if(diff < 0)
+            return false;
+        else
+            pos = d_dequeuePos.load(std::memory_order_relaxed);
+    }
+
+    //hand the filled buffer to the consumer and keep its old buffer for reuse
+    if(out)
+        out->swap(slot->data);
+
+    slot->seq.store(pos+d_capacity,std::memory_order_release);
+    return true;
+}
+
+void ShotQueue::coalesce(const char *data, int size)
+{
+    QMutexLocker l(&d_coalesceMutex);
+    if(pu_coalescer && pu_coalescer->parseAndAdd(data,size,d_coalescedList,Fid()))
+        d_coalesced.fetch_add(1,std::memory_order_relaxed);
+    else
+        d_dropped.fetch_add(1,std::memory_order_relaxed);
+}
+
+void ShotQueue::notify()
+{
+    if(d_notify && !d_notified.exchange(true,std::memory_order_acq_rel))
+        d_notify();
+}
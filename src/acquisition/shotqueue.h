@@ -0,0 +1,118 @@
+#ifndef SHOTQUEUE_H
+#define SHOTQUEUE_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <QWaitCondition>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include <data/experiment/fid.h>
+
+class DigitizerConfig;
+class CpuAverager;
+
+namespace BC::Key::ShotQueue {
+static const QString key{"FtmwShotQueue"};
+static const QString capacity{"capacity"};
+static const QString policy{"policy"};
+static const QString batchLatencyMs{"batchLatencyMs"};
+}
+
+/*!
+ * \brief Bounded queue that carries FTMW shots from the scope thread to the AcquisitionManager
+ *
+ * The queue contains a fixed number of slots whose buffers are allocated in reset(). The scope
+ * thread copies each shot into a free slot with push(), and the AcquisitionManager thread
+ * swaps filled buffers out with pop(). Slot ownership is handed off with per-slot sequence
+ * numbers (a bounded Vyukov-style ring), so the two sides never wait on each other on the normal
+ * path. push() holds an otherwise uncontended producer lock, which reset() takes before replacing
+ * the slots; a push in progress therefore finishes (or, if blocked, gives up) first. reset() must
+ * be called from the consumer thread.
+ *
+ * Only one notification is outstanding at a time: push() calls the notifier only if the consumer
+ * has acknowledged the previous one, so the Qt event queue no longer grows with the shot rate.
+ *
+ * When the queue is full, the Policy determines what happens to the incoming shot:
+ *  - Block: the producer waits until the consumer frees a slot (or the queue is closed).
+ *  - DropOldest: the oldest queued shot is discarded.
+ *  - Coalesce: the shot is decoded and summed into an overflow FidList, which the consumer
+ *    retrieves with takeCoalesced(). No shots are lost, but coalesced shots bypass chirp
+ *    scoring and phase correction, so effectivePolicy() replaces Coalesce with DropOldest when
+ *    either is enabled.
+ *
+ * Dropped and coalesced shots are counted and reported as aux data.
+ */
+class ShotQueue
+{
+public:
+    enum Policy {
+        Block,
+        DropOldest,
+        Coalesce
+    };
+
+    ShotQueue();
+    ~ShotQueue();
+
+    static Policy effectivePolicy(Policy p, bool chirpScoring, bool phaseCorrection);
+
+    bool reset(const DigitizerConfig &cfg, quint8 bitShift, int capacity, Policy p);
+    void close();
+    void setNotifier(std::function<void()> f) { d_notify = f; }
+
+    //producer
+    bool push(const QByteArray &b);
+    bool push(const char *data, int size);
+
+    //consumer
+    void acknowledge();
+    bool pop(QByteArray &out);
+    bool takeCoalesced(FidList &out);
+
+    int capacity() const { return d_capacity; }
+    Policy policy() const { return d_policy; }
+    int size() const;
+    quint64 droppedShots() const { return d_dropped.load(std::memory_order_relaxed); }
+    quint64 coalescedShots() const { return d_coalesced.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<quint64> seq{0};
+        QByteArray data;
+    };
+
+    std::unique_ptr<Slot[]> pu_slots;
+    int d_capacity{0};
+    int d_shotBytes{0};
+    Policy d_policy{Block};
+    std::function<void()> d_notify;
+
+    std::atomic<quint64> d_enqueuePos{0};
+    std::atomic<quint64> d_dequeuePos{0};
+    std::atomic<bool> d_open{false};
+    std::atomic<bool> d_notified{false};
+    std::atomic<quint64> d_dropped{0};
+    std::atomic<quint64> d_coalesced{0};
+
+    //held by push(); keeps reset() from replacing the slots under a producer
+    QMutex d_pushMutex;
+
+    //only used when the producer has to wait (Block)
+    std::atomic<bool> d_producerWaiting{false};
+    QMutex d_waitMutex;
+    QWaitCondition d_slotFreed;
+
+    //only used when the queue overflows in Coalesce mode
+    std::unique_ptr<CpuAverager> pu_coalescer;
+    QMutex d_coalesceMutex;
+    FidList d_coalescedList;
+
+    bool tryPush(const char *data, int size);
+    bool tryPop(QByteArray *out);
+    void coalesce(const char *data, int size);
+    void notify();
+};
+
+#endif // SHOTQUEUE_H
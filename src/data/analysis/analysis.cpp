@@ -1,6 +1,12 @@
 #include <data/analysis/analysis.h>
 
 #include <QtAlgorithms>
+#include <QThreadPool>
+#include <QMutex>
+#include <QWaitCondition>
+#include <map>
+#include <memory>
+#include <atomic>
 #include <math.h>
 
 quint32 Analysis::nextPowerOf2(quint32 n)
@@ -204,6 +210,28 @@ QVector<double> Analysis::savGolSmooth(const Eigen::MatrixXd coefs, int derivati
 
 }
 
+QVector<double> Analysis::savGolKernel(int winSize, int polyOrder)
+{
+    //the SVD is far more expensive than applying the kernel, and only a few
+    //window/order combinations are ever used
+    static QMutex mutex;
+    static std::map<std::pair<int,int>,QVector<double>> cache;
+
+    QMutexLocker l(&mutex);
+    auto key = std::make_pair(winSize,polyOrder);
+    auto it = cache.find(key);
+    if(it != cache.end())
+        return it->second;
+
+    auto coefs = calcSavGolCoefs(winSize,polyOrder);
+    QVector<double> out(coefs.rows());
+    for(int i=0; i<out.size(); ++i)
+        out[i] = coefs(i,0);
+
+    cache.emplace(key,out);
+    return out;
+}
+
 int Analysis::factorial(int x)
 {
     if(x>10)
@@ -241,3 +269,82 @@ double Analysis::savGolSmoothPoint(int i, const Eigen::MatrixXd coefs, int deriv
     return pf*out;
 
 }
+
+QThreadPool *Analysis::workerPool()
+{
+    //kept separate from the global pool so that FT and backup jobs
+    //do not starve shot processing (and vice versa)
+    static QThreadPool pool;
+    return &pool;
+}
+
+void Analysis::parallelFor(int n, const std::function<void (int)> &f, QThreadPool *pool)
+{
+    if(!pool)
+        pool = workerPool();
+    int helpers = qMin(n,pool->maxThreadCount()+1) - 1;
+    if(helpers < 1)
+    {
+        for(int i=0; i<n; ++i)
+            f(i);
+        return;
+    }
+
+    //work items are claimed one at a time from a shared counter, so threads that finish
+    //early pick up the remaining items. The calling thread participates as well and then
+    //waits only for helpers that have already started: a helper that is still queued when
+    //the caller finishes finds the loop closed and exits without touching f. This way the
+    //caller never depends on a pool thread becoming available, which would deadlock if
+    //every pool thread were blocked on a lock held by the caller.
+    struct State {
+        std::atomic<int> next{0};
+        QMutex mutex;
+        QWaitCondition idle;
+        int running{0};
+        bool closed{false};
+    };
+    auto state = std::make_shared<State>();
+    auto fp = &f;
+
+    auto work = [n,fp](State *s){
+        int i = 0;
+        while((i = s->next.fetch_add(1,std::memory_order_relaxed)) < n)
+            (*fp)(i);
+    };
+
+    for(int t=0; t<helpers; ++t)
+    {
+        pool->start([state,work](){
+            QMutexLocker l(&state->mutex);
+            if(state->closed)
+                return;
+            ++state->running;
+            l.unlock();
+
+            work(state.get());
+
+            l.relock();
+            if(--state->running == 0)
+                state->idle.wakeAll();
+        });
+    }
+
+    work(state.get());
+
+    QMutexLocker l(&state->mutex);
+    state->closed = true;
+    while(state->running > 0)
+        state->idle.wait(&state->mutex);
+}
+
+static std::atomic<quint64> s_payloadCopies{0};
+
+void Analysis::countPayloadCopy()
+{
+    s_payloadCopies.fetch_add(1,std::memory_order_relaxed);
+}
+
+quint64 Analysis::payloadCopies()
+{
+    return s_payloadCopies.load(std::memory_order_relaxed);
+}
@@ -7,9 +7,12 @@
 #include <QStringList>
 #include <QPair>
 #include <QVector>
+#include <functional>
 
 #include <eigen3/Eigen/SVD>
 
+class QThreadPool;
+
 namespace Analysis {
 
 quint32 nextPowerOf2(quint32 n);
@@ -22,6 +25,54 @@ Eigen::MatrixXd calcSavGolCoefs(int winSize, int polyOrder);
 QVector<double> savGolSmooth(const Eigen::MatrixXd coefs, int derivativeOrder, QVector<double> d, double dx = 1.0);
 double savGolSmoothPoint(int i, const Eigen::MatrixXd coefs, int derivativeOrder, QVector<double> d, double dx = 1.0);
 
+//smoothing (zeroth derivative) Savitzky-Golay kernel; computed once per window and order, then cached
+QVector<double> savGolKernel(int winSize, int polyOrder);
+
+/*!
+ * \brief Exact intRoundClosest(n,d) for many numerators sharing the same d
+ *
+ * The quotient is estimated with a multiplication by 1/d and then corrected by at most one step
+ * using the integer remainder, so the result is identical to intRoundClosest without a 64-bit
+ * division per call. Numerators too large for the estimate fall back to a division.
+ */
+class RoundClosestDivider
+{
+public:
+    explicit RoundClosestDivider(qint64 d) : d_d(d), d_half(d/2), d_inv(d > 0 ? 1.0/static_cast<double>(d) : 0.0) {}
+
+    inline qint64 operator()(qint64 n) const {
+        if(d_d <= 0)
+            return intRoundClosest(n,d_d);
+
+        qint64 m = n < 0 ? n - d_half : n + d_half;
+        if(m > s_limit || m < -s_limit)
+            return m/d_d;
+
+        //truncation toward zero, as in integer division
+        qint64 q = static_cast<qint64>(static_cast<double>(m)*d_inv);
+        qint64 r = m - q*d_d;
+        if(m >= 0)
+            q += (r >= d_d) - (r < 0);
+        else
+            q += (r > 0) - (r <= -d_d);
+        return q;
+    }
+
+private:
+    qint64 d_d, d_half;
+    double d_inv;
+    static constexpr qint64 s_limit{Q_INT64_C(1) << 50};
+};
+
+//workerPool is reserved for short, non-blocking chunks of shot processing. Long or
+//blocking jobs (FTs, disk reads) go to QThreadPool::globalInstance() instead.
+QThreadPool *workerPool();
+void parallelFor(int n, const std::function<void(int)> &f, QThreadPool *pool = nullptr);
+
+//counts conversions (e.g., Fid::toVector) that allocate a new copy of a Fid or Ft payload
+void countPayloadCopy();
+quint64 payloadCopies();
+
 }
 
 #endif // ANALYSIS_H
@@ -0,0 +1,450 @@
+#include "cpuaverager.h"
+
+#include <limits>
+#include <QVarLengthArray>
+
+#include <data/experiment/digitizerconfig.h>
+#include <data/analysis/analysis.h>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define BC_CPUAVG_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+/*
+ * Each kernel adds n decoded samples from src into dst, multiplying by mult.
+ * Callers have already applied any shift to the src and dst pointers.
+ */
+
+qint64 decodeSample(const char *src, int bpp, bool bigEndian)
+{
+    auto u = reinterpret_cast<const quint8*>(src);
+    if(bpp == 1)
+        return static_cast<qint64>(static_cast<qint8>(u[0]));
+    else if(bpp == 2)
+    {
+        quint16 y = bigEndian ? static_cast<quint16>((u[0] << 8) | u[1])
+                              : static_cast<quint16>((u[1] << 8) | u[0]);
+        return static_cast<qint64>(static_cast<qint16>(y));
+    }
+
+    quint32 y = bigEndian ? (static_cast<quint32>(u[0]) << 24) | (static_cast<quint32>(u[1]) << 16) | (static_cast<quint32>(u[2]) << 8) | u[3]
+                          : (static_cast<quint32>(u[3]) << 24) | (static_cast<quint32>(u[2]) << 16) | (static_cast<quint32>(u[1]) << 8) | u[0];
+    return static_cast<qint64>(static_cast<qint32>(y));
+}
+
+void addScalar(qint64 *dst, const char *src, int n, int bpp, bool bigEndian, qint64 mult)
+{
+    if(mult == 1)
+    {
+        for(int i=0; i<n; ++i)
+            dst[i] += decodeSample(src + i*bpp,bpp,bigEndian);
+    }
+    else
+    {
+        for(int i=0; i<n; ++i)
+            dst[i] += decodeSample(src + i*bpp,bpp,bigEndian)*mult;
+    }
+}
+
+#ifdef BC_CPUAVG_X86
+
+//_mm_mul_epi32 multiplies the sign-extended low 32 bits of each lane, which is exact
+//because all decoded samples and the multiplier fit in 32 bits
+template<int bpp>
+__attribute__((target("sse4.1")))
+void addSse41(qint64 *dst, const char *src, int n, bool bigEndian, qint64 mult)
+{
+    const __m128i m = _mm_set1_epi64x(mult);
+    const bool doMult = (mult != 1);
+    const __m128i swap = (bpp == 2) ? _mm_setr_epi8(1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14)
+                                    : _mm_setr_epi8(3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12);
+    constexpr int step = 16/bpp;
+    constexpr int nv = step/2;
+
+    int i = 0;
+    for(; i + step <= n; i += step)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i*bpp));
+        if(bpp > 1 && bigEndian)
+            v = _mm_shuffle_epi8(v,swap);
+
+        __m128i x[nv];
+        if constexpr (bpp == 1)
+        {
+            x[0] = _mm_cvtepi8_epi64(v);
+            x[1] = _mm_cvtepi8_epi64(_mm_srli_si128(v,2));
+            x[2] = _mm_cvtepi8_epi64(_mm_srli_si128(v,4));
+            x[3] = _mm_cvtepi8_epi64(_mm_srli_si128(v,6));
+            x[4] = _mm_cvtepi8_epi64(_mm_srli_si128(v,8));
+            x[5] = _mm_cvtepi8_epi64(_mm_srli_si128(v,10));
+            x[6] = _mm_cvtepi8_epi64(_mm_srli_si128(v,12));
+            x[7] = _mm_cvtepi8_epi64(_mm_srli_si128(v,14));
+        }
+        else if constexpr (bpp == 2)
+        {
+            x[0] = _mm_cvtepi16_epi64(v);
+            x[1] = _mm_cvtepi16_epi64(_mm_srli_si128(v,4));
+            x[2] = _mm_cvtepi16_epi64(_mm_srli_si128(v,8));
+            x[3] = _mm_cvtepi16_epi64(_mm_srli_si128(v,12));
+        }
+        else
+        {
+            x[0] = _mm_cvtepi32_epi64(v);
+            x[1] = _mm_cvtepi32_epi64(_mm_srli_si128(v,8));
+        }
+
+        for(int k=0; k<nv; ++k)
+        {
+            if(doMult)
+                x[k] = _mm_mul_epi32(x[k],m);
+            auto d = reinterpret_cast<__m128i*>(dst + i + 2*k);
+            _mm_storeu_si128(d,_mm_add_epi64(_mm_loadu_si128(d),x[k]));
+        }
+    }
+
+    if(i < n)
+        addScalar(dst + i,src + i*bpp,n-i,bpp,bigEndian,mult);
+}
+
+template<int bpp>
+__attribute__((target("avx2")))
+void addAvx2(qint64 *dst, const char *src, int n, bool bigEndian, qint64 mult)
+{
+    const __m256i m = _mm256_set1_epi64x(mult);
+    const bool doMult = (mult != 1);
+    const __m128i swap = (bpp == 2) ? _mm_setr_epi8(1,0,3,2,5,4,7,6,9,8,11,10,13,12,15,14)
+                                    : _mm_setr_epi8(3,2,1,0,7,6,5,4,11,10,9,8,15,14,13,12);
+    constexpr int step = 16/bpp;
+    constexpr int nv = step/4;
+
+    int i = 0;
+    for(; i + step <= n; i += step)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i*bpp));
+        if(bpp > 1 && bigEndian)
+            v = _mm_shuffle_epi8(v,swap);
+
+        __m256i x[nv];
+        if constexpr (bpp == 1)
+        {
+            x[0] = _mm256_cvtepi8_epi64(v);
+            x[1] = _mm256_cvtepi8_epi64(_mm_srli_si128(v,4));
+            x[2] = _mm256_cvtepi8_epi64(_mm_srli_si128(v,8));
+            x[3] = _mm256_cvtepi8_epi64(_mm_srli_si128(v,12));
+        }
+        else if constexpr (bpp == 2)
+        {
+            x[0] = _mm256_cvtepi16_epi64(v);
+            x[1] = _mm256_cvtepi16_epi64(_mm_srli_si128(v,8));
+        }
+        else
+            x[0] = _mm256_cvtepi32_epi64(v);
+
+        for(int k=0; k<nv; ++k)
+        {
+            if(doMult)
+                x[k] = _mm256_mul_epi32(x[k],m);
+            auto d = reinterpret_cast<__m256i*>(dst + i + 4*k);
+            _mm256_storeu_si256(d,_mm256_add_epi64(_mm256_loadu_si256(d),x[k]));
+        }
+    }
+
+    if(i < n)
+        addScalar(dst + i,src + i*bpp,n-i,bpp,bigEndian,mult);
+}
+
+#endif
+
+void addSamples(CpuAverager::Backend b, qint64 *dst, const char *src, int n, int bpp, bool bigEndian, qint64 mult)
+{
+#ifdef BC_CPUAVG_X86
+    if(b == CpuAverager::AVX2)
+    {
+        switch(bpp) {
+        case 1:
+            addAvx2<1>(dst,src,n,bigEndian,mult);
+            return;
+        case 2:
+            addAvx2<2>(dst,src,n,bigEndian,mult);
+            return;
+        default:
+            addAvx2<4>(dst,src,n,bigEndian,mult);
+            return;
+        }
+    }
+    else if(b == CpuAverager::SSE41)
+    {
+        switch(bpp) {
+        case 1:
+            addSse41<1>(dst,src,n,bigEndian,mult);
+            return;
+        case 2:
+            addSse41<2>(dst,src,n,bigEndian,mult);
+            return;
+        default:
+            addSse41<4>(dst,src,n,bigEndian,mult);
+            return;
+        }
+    }
+#else
+    Q_UNUSED(b)
+#endif
+
+    addScalar(dst,src,n,bpp,bigEndian,mult);
+}
+
+}
+
+CpuAverager::CpuAverager()
+{
+}
+
+bool CpuAverager::initialize(const DigitizerConfig &cfg, quint8 bitShift, Backend b)
+{
+    quint64 inc = 1;
+    if(cfg.d_blockAverage)
+        inc *= cfg.d_numAverages;
+
+    return initialize(cfg.d_numRecords,cfg.d_recordLength,cfg.d_bytesPerPoint,
+                      cfg.d_byteOrder == DigitizerConfig::BigEndian,inc,bitShift,b);
+}
+
+bool CpuAverager::initialize(int numRecords, int recordLength, int bytesPerPoint, bool bigEndian, quint64 shotIncrement, quint8 bitShift, Backend b)
+{
+    d_isInitialized = false;
+    d_errorMsg.clear();
+
+    if(numRecords < 1 || recordLength < 1)
+    {
+        d_errorMsg = QString("Cannot initialize averager with %1 records of %2 points.").arg(numRecords).arg(recordLength);
+        return false;
+    }
+
+    if(bytesPerPoint != 1 && bytesPerPoint != 2 && bytesPerPoint != 4)
+    {
+        d_errorMsg = QString("Cannot average data with %1 bytes per point.").arg(bytesPerPoint);
+        return false;
+    }
+
+    d_numRecords = numRecords;
+    d_recordLength = recordLength;
+    d_bytesPerPoint = bytesPerPoint;
+    d_bigEndian = bigEndian && bytesPerPoint > 1;
+    d_shotIncrement = qMax(shotIncrement,Q_UINT64_C(1));
+
+    //"undo" averaging done by the device and add any padding bits in one step
+    d_multiplier = static_cast<qint64>(d_shotIncrement) << bitShift;
+
+    if(b == Auto || !isAvailable(b))
+        b = bestAvailable();
+    if(d_multiplier > std::numeric_limits<qint32>::max())
+        b = Scalar;
+    d_backend = b;
+
+    makeChunks();
+    d_isInitialized = true;
+    return true;
+}
+
+bool CpuAverager::parseAndAdd(const char *newDataIn, qint64 bytes, FidList &sum, const Fid &fidTemplate, const int shift) const
+{
+    //as in FidStorageBase::addFids, the first shot is not shifted
+    int s = sum.isEmpty() ? 0 : shift;
+    if(!prepareSum(bytes,sum,fidTemplate))
+        return false;
+
+    //detach all records on this thread before any work is distributed
+    QVarLengthArray<qint64*,128> ptrs(sum.size());
+    for(int i=0; i<sum.size(); ++i)
+    {
+        auto &f = sum[i];
+        ptrs[i] = f.rawDataPtr();
+        f.setShots(f.shots() + d_shotIncrement);
+    }
+
+    runChunks([&](int i){
+        auto &c = d_chunks.at(i);
+        parseRange(newDataIn,ptrs[c.record],c,s);
+    });
+
+    return true;
+}
+
+bool CpuAverager::parseAndRollAvg(const char *newDataIn, qint64 bytes, FidList &sum, const Fid &fidTemplate, const quint64 targetShots, const int shift) const
+{
+    int s = sum.isEmpty() ? 0 : shift;
+    if(!prepareSum(bytes,sum,fidTemplate))
+        return false;
+
+    //totals[i] is nonzero if record i needs to be rescaled to targetShots
+    QVarLengthArray<qint64*,128> ptrs(sum.size());
+    QVarLengthArray<qint64,128> totals(sum.size());
+    for(int i=0; i<sum.size(); ++i)
+    {
+        auto &f = sum[i];
+        ptrs[i] = f.rawDataPtr();
+
+        quint64 totalShots = f.shots() + d_shotIncrement;
+        if(totalShots <= targetShots)
+        {
+            f.setShots(totalShots);
+            totals[i] = 0;
+        }
+        else
+        {
+            f.setShots(targetShots);
+            totals[i] = static_cast<qint64>(totalShots);
+        }
+    }
+
+    auto ts = static_cast<qint64>(targetShots);
+    runChunks([&](int i){
+        auto &c = d_chunks.at(i);
+        auto dat = ptrs[c.record];
+        parseRange(newDataIn,dat,c,s);
+
+        //same rounding as Fid::rollingAverage
+        auto tot = totals[c.record];
+        if(tot > 0)
+        {
+            for(int j=c.first; j<c.first+c.count; ++j)
+                dat[j] = Analysis::intRoundClosest(ts*dat[j],tot);
+        }
+    });
+
+    return true;
+}
+
+void CpuAverager::parseRecord(const char *newDataIn, qint64 *sum, int record, const int shift) const
+{
+    parseRange(newDataIn,sum,{record,0,d_recordLength},shift);
+}
+
+void CpuAverager::setChunkPoints(int n)
+{
+    d_chunkPoints = qMax(n,1);
+    if(d_isInitialized)
+        makeChunks();
+}
+
+bool CpuAverager::isAvailable(Backend b)
+{
+    switch(b) {
+    case Auto:
+    case Scalar:
+        return true;
+#ifdef BC_CPUAVG_X86
+    case SSE41:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse4.1");
+    case AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+CpuAverager::Backend CpuAverager::bestAvailable()
+{
+    if(isAvailable(AVX2))
+        return AVX2;
+    if(isAvailable(SSE41))
+        return SSE41;
+
+    return Scalar;
+}
+
+QString CpuAverager::backendName(Backend b)
+{
+    switch(b) {
+    case Auto:
+        return QString("Auto");
+    case Scalar:
+        return QString("Scalar");
+    case SSE41:
+        return QString("SSE4.1");
+    case AVX2:
+        return QString("AVX2");
+    }
+
+    return QString();
+}
+
+void CpuAverager::makeChunks()
+{
+    d_chunks.clear();
+    int perRecord = qMax(1,(d_recordLength + d_chunkPoints - 1)/d_chunkPoints);
+    int size = (d_recordLength + perRecord - 1)/perRecord;
+    d_chunks.reserve(d_numRecords*perRecord);
+    for(int r=0; r<d_numRecords; ++r)
+    {
+        for(int first=0; first<d_recordLength; first += size)
+            d_chunks.push_back({r,first,qMin(size,d_recordLength-first)});
+    }
+}
+
+void CpuAverager::runChunks(const std::function<void (int)> &f) const
+{
+    //small shots are not worth the cost of waking up the pool
+    auto n = static_cast<int>(d_chunks.size());
+    if(n > 1 && static_cast<qint64>(d_numRecords)*d_recordLength >= 2*d_chunkPoints)
+        Analysis::parallelFor(n,f);
+    else
+    {
+        for(int i=0; i<n; ++i)
+            f(i);
+    }
+}
+
+bool CpuAverager::prepareSum(qint64 bytes, FidList &sum, const Fid &fidTemplate) const
+{
+    if(!d_isInitialized)
+    {
+        d_errorMsg = QString("Cannot process scope data because averager was not initialized successfully.");
+        return false;
+    }
+
+    if(bytes < static_cast<qint64>(d_numRecords)*d_recordLength*d_bytesPerPoint)
+    {
+        d_errorMsg = QString("Scope data too short (%1 bytes, expected %2).").arg(bytes)
+                .arg(static_cast<qint64>(d_numRecords)*d_recordLength*d_bytesPerPoint);
+        return false;
+    }
+
+    if(sum.isEmpty())
+    {
+        sum.reserve(d_numRecords);
+        for(int i=0; i<d_numRecords; ++i)
+        {
+            Fid f = fidTemplate;
+            f.setData(QVector<qint64>(d_recordLength));
+            f.setShots(0);
+            sum.append(f);
+        }
+    }
+    else if(sum.size() != d_numRecords || sum.constFirst().size() != d_recordLength)
+    {
+        d_errorMsg = QString("Scope data does not match the current FID list.");
+        return false;
+    }
+
+    return true;
+}
+
+void CpuAverager::parseRange(const char *newDataIn, qint64 *sum, const Chunk &c, const int shift) const
+{
+    //sum[i] += data[i-shift], matching Fid::add. Only points for which i-shift
+    //falls inside the record are touched.
+    int first = qMax(c.first,shift);
+    int last = qMin(c.first+c.count,d_recordLength+shift);
+    if(last <= first)
+        return;
+
+    auto src = newDataIn + (static_cast<qint64>(c.record)*d_recordLength + first - shift)*d_bytesPerPoint;
+    addSamples(d_backend,sum+first,src,last-first,d_bytesPerPoint,d_bigEndian,d_multiplier);
+}
@@ -0,0 +1,89 @@
+#ifndef CPUAVERAGER_H
+#define CPUAVERAGER_H
+
+#include <QString>
+#include <vector>
+#include <functional>
+
+#include <data/experiment/fid.h>
+
+class DigitizerConfig;
+
+namespace BC::Key::CpuAvg {
+static const QString key{"CpuAverager"};
+static const QString backend{"backend"};
+}
+
+/*!
+ * \brief CPU equivalent of GpuAverager
+ *
+ * The CpuAverager decodes raw digitizer bytes (1, 2, or 4 bytes per point, little or big endian)
+ * and adds them directly into the running qint64 sums stored in a FidList. The multiplication by
+ * the number of block averages performed by the digitizer and the padding bit shift used in
+ * peak up mode are folded into a single multiplier, and the phase correction shift is applied
+ * by offsetting the source and destination pointers, so each sample is touched exactly once.
+ *
+ * The inner loop is dispatched at runtime to an AVX2, SSE4.1, or scalar implementation. Auto
+ * selects the best implementation supported by the CPU; the SIMD paths require the combined
+ * multiplier to fit in a signed 32-bit integer, and the scalar path is used if it does not.
+ *
+ * When there is enough data (multiple records and/or long records), each record is split into
+ * chunks of roughly d_chunkPoints points, and the chunks are processed in parallel on the
+ * Analysis::workerPool() threads.
+ */
+class CpuAverager
+{
+public:
+    enum Backend {
+        Auto,
+        Scalar,
+        SSE41,
+        AVX2
+    };
+
+    CpuAverager();
+
+    bool initialize(const DigitizerConfig &cfg, quint8 bitShift = 0, Backend b = Auto);
+    bool initialize(int numRecords, int recordLength, int bytesPerPoint, bool bigEndian,
+                    quint64 shotIncrement, quint8 bitShift = 0, Backend b = Auto);
+
+    bool parseAndAdd(const char *newDataIn, qint64 bytes, FidList &sum, const Fid &fidTemplate, const int shift = 0) const;
+    bool parseAndRollAvg(const char *newDataIn, qint64 bytes, FidList &sum, const Fid &fidTemplate, const quint64 targetShots, const int shift = 0) const;
+    void parseRecord(const char *newDataIn, qint64 *sum, int record, const int shift = 0) const;
+
+    Backend backend() const { return d_backend; }
+    quint64 shotIncrement() const { return d_shotIncrement; }
+    QString getErrorString() const { return d_errorMsg; }
+
+    void setChunkPoints(int n);
+
+    static bool isAvailable(Backend b);
+    static Backend bestAvailable();
+    static QString backendName(Backend b);
+
+private:
+    int d_numRecords{0};
+    int d_recordLength{0};
+    int d_bytesPerPoint{0};
+    bool d_bigEndian{false};
+    quint64 d_shotIncrement{1};
+    qint64 d_multiplier{1};
+    Backend d_backend{Scalar};
+    bool d_isInitialized{false};
+    int d_chunkPoints{1 << 16};
+    mutable QString d_errorMsg;
+
+    struct Chunk {
+        int record;
+        int first;
+        int count;
+    };
+    std::vector<Chunk> d_chunks;
+
+    void makeChunks();
+    void runChunks(const std::function<void(int)> &f) const;
+    bool prepareSum(qint64 bytes, FidList &sum, const Fid &fidTemplate) const;
+    void parseRange(const char *newDataIn, qint64 *sum, const Chunk &c, const int shift) const;
+};
+
+#endif // CPUAVERAGER_H
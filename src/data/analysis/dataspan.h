@@ -0,0 +1,30 @@
+#ifndef DATASPAN_H
+#define DATASPAN_H
+
+/*!
+ * \brief Read-only view of a contiguous array owned by another object
+ *
+ * Fid and Ft hand out DataSpans over their implicitly shared storage so that analysis code can
+ * read the data without making a QVector copy. A span does not hold a reference to the data: it
+ * is valid only while the object it came from is alive and is not modified.
+ */
+template<typename T>
+class DataSpan
+{
+public:
+    DataSpan() = default;
+    DataSpan(const T *d, int n) : p_data(d), d_size(n) {}
+
+    const T *data() const { return p_data; }
+    int size() const { return d_size; }
+    bool isEmpty() const { return d_size == 0; }
+    const T &operator[](int i) const { return p_data[i]; }
+    const T *begin() const { return p_data; }
+    const T *end() const { return p_data + d_size; }
+
+private:
+    const T *p_data{nullptr};
+    int d_size{0};
+};
+
+#endif // DATASPAN_H
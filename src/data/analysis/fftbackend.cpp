@@ -0,0 +1,159 @@
+#include "fftbackend.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <list>
+#include <functional>
+#include <memory>
+#include <complex>
+#include <vector>
+
+#include <gsl/gsl_fft_real.h>
+
+#ifdef BC_FFTW
+#include <fftw3.h>
+#endif
+
+namespace {
+
+/*!
+ * \brief Small LRU map from transform size to a shared, immutable plan object
+ *
+ * Entries are held by shared_ptr, so an entry evicted while another thread is still using it
+ * is only destroyed when that thread is done with it.
+ */
+template<typename T>
+class PlanCache
+{
+public:
+    std::shared_ptr<T> get(int n, const std::function<std::shared_ptr<T>(int)> &make)
+    {
+        QMutexLocker l(&d_mutex);
+        for(auto it = d_entries.begin(); it != d_entries.end(); ++it)
+        {
+            if(it->first == n)
+            {
+                d_entries.splice(d_entries.begin(),d_entries,it);
+                return it->second;
+            }
+        }
+
+        auto p = make(n);
+        d_entries.emplace_front(n,p);
+        if(d_entries.size() > static_cast<std::size_t>(FftBackend::maxCachedSizes))
+            d_entries.pop_back();
+
+        return p;
+    }
+
+private:
+    QMutex d_mutex;
+    std::list<std::pair<int,std::shared_ptr<T>>> d_entries;
+};
+
+void gslForward(double *data, int n)
+{
+    static PlanCache<gsl_fft_real_wavetable> cache;
+    auto wt = cache.get(n,[](int n){
+        return std::shared_ptr<gsl_fft_real_wavetable>(gsl_fft_real_wavetable_alloc(n),
+                                                       gsl_fft_real_wavetable_free);
+    });
+
+    //the workspace is scratch memory, so each thread gets its own
+    thread_local std::unique_ptr<gsl_fft_real_workspace,void(*)(gsl_fft_real_workspace*)>
+            work(nullptr,gsl_fft_real_workspace_free);
+    if(!work || work->n != static_cast<std::size_t>(n))
+        work.reset(gsl_fft_real_workspace_alloc(n));
+
+    gsl_fft_real_transform(data,1,n,wt.get(),work.get());
+}
+
+#ifdef BC_FFTW
+//the FFTW planner is not thread-safe, but executing an existing plan is
+QMutex s_fftwPlannerMutex;
+
+struct FftwPlan {
+    fftw_plan plan;
+    ~FftwPlan() {
+        QMutexLocker l(&s_fftwPlannerMutex);
+        fftw_destroy_plan(plan);
+    }
+};
+
+void fftwForward(double *data, int n)
+{
+    static PlanCache<FftwPlan> cache;
+    auto p = cache.get(n,[](int n){
+        QMutexLocker l(&s_fftwPlannerMutex);
+        static bool threadsInit = fftw_init_threads() != 0;
+        if(threadsInit)
+            fftw_plan_with_nthreads(n >= FftBackend::threadThreshold ? QThread::idealThreadCount() : 1);
+
+        //FFTW_ESTIMATE does not touch the arrays, but they must exist
+        auto in = fftw_alloc_real(n);
+        auto out = fftw_alloc_complex(n/2+1);
+        auto out_p = std::make_shared<FftwPlan>();
+        out_p->plan = fftw_plan_dft_r2c_1d(n,in,out,FFTW_ESTIMATE | FFTW_UNALIGNED);
+        fftw_free(in);
+        fftw_free(out);
+        return out_p;
+    });
+
+    thread_local std::vector<std::complex<double>> scratch;
+    scratch.resize(n/2+1);
+    fftw_execute_dft_r2c(p->plan,data,reinterpret_cast<fftw_complex*>(scratch.data()));
+
+    //rearrange into GSL halfcomplex order
+    data[0] = scratch[0].real();
+    int i;
+    for(i=1; i<n-i; ++i)
+    {
+        data[2*i-1] = scratch[i].real();
+        data[2*i] = scratch[i].imag();
+    }
+    if(i == n-i)
+        data[n-1] = scratch[i].real();
+}
+#endif
+
+}
+
+bool FftBackend::isAvailable(FftBackend::Type t)
+{
+    switch(t) {
+    case Gsl:
+        return true;
+    case Fftw:
+#ifdef BC_FFTW
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    return false;
+}
+
+FftBackend::Type FftBackend::bestAvailable()
+{
+    return isAvailable(Fftw) ? Fftw : Gsl;
+}
+
+void FftBackend::forwardReal(FftBackend::Type t, double *data, int n)
+{
+    if(n < 2)
+        return;
+
+#ifdef BC_FFTW
+    if(t == Fftw)
+    {
+        fftwForward(data,n);
+        return;
+    }
+#else
+    Q_UNUSED(t)
+#endif
+
+    gslForward(data,n);
+}
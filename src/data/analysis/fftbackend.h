@@ -0,0 +1,44 @@
+#ifndef FFTBACKEND_H
+#define FFTBACKEND_H
+
+#include <QObject>
+
+/*!
+ * \brief Real-to-halfcomplex FFT with per-size plan caching
+ *
+ * FftBackend performs a forward FFT of real data in place, leaving the result in the GSL
+ * halfcomplex layout (see gsl_fft_real_transform) regardless of the implementation used.
+ *
+ * Two implementations are available:
+ *  - Gsl: GSL mixed-radix FFT. Wavetables are cached per transform size and shared between
+ *    threads (they are read-only during a transform), and each thread keeps its own workspace,
+ *    so concurrent transforms never wait on one another.
+ *  - Fftw: FFTW3 real-to-complex FFT (only when built with CONFIG += fftw). Plans are created
+ *    with FFTW_ESTIMATE | FFTW_UNALIGNED and cached per size; executing a cached plan on new
+ *    arrays is thread-safe. Transforms of at least threadThreshold points are planned to use
+ *    multiple threads, which helps for multi-million-point zero-padded FIDs.
+ *
+ * The caches hold at most maxCachedSizes entries; the least recently used entry is released when
+ * a new size is needed. Only cache lookups are guarded by a mutex.
+ */
+class FftBackend
+{
+    Q_GADGET
+public:
+    enum Type {
+        Gsl,
+        Fftw
+    };
+    Q_ENUM(Type)
+
+    static constexpr int threadThreshold{1 << 20};
+    static constexpr int maxCachedSizes{8};
+
+    static bool isAvailable(Type t);
+    static Type bestAvailable();
+    static void forwardReal(Type t, double *data, int n);
+};
+
+Q_DECLARE_METATYPE(FftBackend::Type)
+
+#endif // FFTBACKEND_H
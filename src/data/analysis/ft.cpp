@@ -1,5 +1,7 @@
 #include <data/analysis/ft.h>
 
+#include <data/analysis/analysis.h>
+
 class FtData : public QSharedData
 {
 public:
@@ -247,6 +249,7 @@ double Ft::yMax() const
 
 QVector<double> Ft::xData() const
 {
+    Analysis::countPayloadCopy();
     QVector<double> out;
     auto s = data->ftData.size();
     out.reserve(s);
@@ -261,8 +264,14 @@ QVector<double> Ft::yData() const
     return data->ftData;
 }
 
+DataSpan<double> Ft::ySpan() const
+{
+    return {data->ftData.constData(),data->ftData.size()};
+}
+
 QVector<QPointF> Ft::toVector() const
 {
+    Analysis::countPayloadCopy();
     QVector<QPointF> out;
     auto s = data->ftData.size();
     out.reserve(s);
@@ -6,6 +6,8 @@
 #include <QVector>
 #include <QPointF>
 
+#include <data/analysis/dataspan.h>
+
 class FtData;
 
 class Ft
@@ -47,6 +49,7 @@ public:
     double yMax() const;
     QVector<double> xData() const;
     QVector<double> yData() const;
+    DataSpan<double> ySpan() const;
     QVector<QPointF> toVector() const;
     quint64 shots() const;
 
@@ -4,32 +4,157 @@
 #include <QReadWriteLock>
 #include <QReadLocker>
 #include <QWriteLocker>
+#include <QMutexLocker>
+#include <QThreadPool>
 
 #include <gsl/gsl_const.h>
 #include <gsl/gsl_sf.h>
 
+#include <algorithm>
+#include <atomic>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+/*!
+ * \brief Converts a GSL halfcomplex array of length n into scaled magnitudes, in place
+ *
+ * On return, data[0] = 0 (DC is blocked) and data[i] = scf*|X_i| for 0 < i <= n/2.
+ */
+void halfComplexMagnitudes(double *data, int n, double scf)
+{
+    int i = 1;
+#ifdef __SSE2__
+    //two bins per iteration: the (re,im) pairs for bins i and i+1 are contiguous starting at data[2i-1]
+    auto sc = _mm_set1_pd(scf);
+    for(; i+1 < n-i-1; i+=2)
+    {
+        auto a = _mm_loadu_pd(data+2*i-1);
+        auto b = _mm_loadu_pd(data+2*i+1);
+        auto re = _mm_unpacklo_pd(a,b);
+        auto im = _mm_unpackhi_pd(a,b);
+        auto m = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(re,re),_mm_mul_pd(im,im)));
+        _mm_storeu_pd(data+i,_mm_mul_pd(m,sc));
+    }
+#endif
+    for(; i<n-i; i++)
+    {
+        double re = data[2*i-1];
+        double im = data[2*i];
+        data[i] = sqrt(re*re + im*im)*scf;
+    }
+    if(i == n-i)
+        data[i] = qAbs(data[n-1])*scf;
+
+    data[0] = 0.0;
+}
+
+/*!
+ * \brief Per-bin partial sums for merging sideband segments on a common frequency grid
+ *
+ * Each bin keeps the number of contributing segments along with the sum of their logarithms
+ * and of their values. The merged value is the geometric mean of the contributions, or the
+ * arithmetic mean if any contribution is not positive. Because only sums are stored, partial
+ * results can be merged in any order.
+ */
+struct SidebandAccumulator
+{
+    int first{0};
+    quint64 shots{0};
+    QVector<int> count;
+    QVector<int> nonPositive;
+    QVector<double> logSum;
+    QVector<double> linSum;
+
+    SidebandAccumulator() {}
+    SidebandAccumulator(const QVector<double> &y, int firstIndex, quint64 numShots) :
+        first(firstIndex), shots(numShots), count(y.size(),1), nonPositive(y.size()),
+        logSum(y.size()), linSum(y)
+    {
+        for(int i=0; i<y.size(); ++i)
+        {
+            if(y.at(i) > 0.0)
+                logSum[i] = log(y.at(i));
+            else
+                nonPositive[i] = 1;
+        }
+    }
+
+    bool isEmpty() const { return count.isEmpty(); }
+    int end() const { return first + count.size(); }
+
+    void merge(const SidebandAccumulator &other)
+    {
+        if(other.isEmpty())
+            return;
+        if(isEmpty())
+        {
+            *this = other;
+            return;
+        }
+
+        //grow to cover both ranges if needed
+        int lo = qMin(first,other.first);
+        int hi = qMax(end(),other.end());
+        if(lo != first || hi != end())
+        {
+            int n = hi - lo;
+            int shift = first - lo;
+            QVector<int> c(n), np(n);
+            QVector<double> ls(n), lin(n);
+            std::copy(count.cbegin(),count.cend(),c.begin()+shift);
+            std::copy(nonPositive.cbegin(),nonPositive.cend(),np.begin()+shift);
+            std::copy(logSum.cbegin(),logSum.cend(),ls.begin()+shift);
+            std::copy(linSum.cbegin(),linSum.cend(),lin.begin()+shift);
+            count.swap(c);
+            nonPositive.swap(np);
+            logSum.swap(ls);
+            linSum.swap(lin);
+            first = lo;
+        }
+
+        int offset = other.first - first;
+        for(int i=0; i<other.count.size(); ++i)
+        {
+            count[offset+i] += other.count.at(i);
+            nonPositive[offset+i] += other.nonPositive.at(i);
+            logSum[offset+i] += other.logSum.at(i);
+            linSum[offset+i] += other.linSum.at(i);
+        }
+        shots += other.shots;
+    }
+
+    QVector<double> result(double &yMin, double &yMax) const
+    {
+        QVector<double> out(count.size());
+        for(int i=0; i<count.size(); ++i)
+        {
+            if(count.at(i) == 0)
+                continue;
+
+            double n = static_cast<double>(count.at(i));
+            out[i] = nonPositive.at(i) > 0 ? linSum.at(i)/n : exp(logSum.at(i)/n);
+            yMin = qMin(out.at(i),yMin);
+            yMax = qMax(out.at(i),yMax);
+        }
+        return out;
+    }
+};
+
+}
+
 FtWorker::FtWorker(QObject *parent) :
-    QObject(parent), real(NULL), work(NULL), d_numPnts(0), p_spline(nullptr),
-    p_accel(nullptr), d_numSplinePoints(0)
-{    
-    pu_fftLock = std::make_unique<QReadWriteLock>();
-    pu_splineLock = std::make_unique<QReadWriteLock>();
+    QObject(parent)
+{
     pu_winfLock = std::make_unique<QReadWriteLock>();
+    pu_ftCacheLock = std::make_unique<QMutex>();
 }
 
 FtWorker::~FtWorker()
 {
-    QWriteLocker l(pu_splineLock.get());
-    QWriteLocker l2(pu_fftLock.get());
-    if(p_spline != nullptr)
-        gsl_spline_free(p_spline);
-    if(p_accel != nullptr)
-        gsl_interp_accel_free(p_accel);
-    if(real != nullptr)
-    {
-        gsl_fft_real_wavetable_free(real);
-        gsl_fft_real_workspace_free(work);
-    }
 }
 
 Ft FtWorker::doFT(const Fid fid, const FidProcessingSettings &settings, int id, bool doubleSideband)
@@ -44,16 +169,75 @@ Ft FtWorker::doFT(const Fid fid, const FidProcessingSettings &settings, int id,
         return Ft();
     }
 
-    double rawSize = static_cast<double>(fid.size());
-
     //first, apply any filtering that needs to be done
     auto fidResult = filterFid(fid,settings);
     if(id > -1)
         emit fidDone(fidResult.fid,fid.spacing()*1e6,fidResult.min,fidResult.max,id);
-    auto fftData = fidResult.fid;
-    auto s = fftData.size();
 
+    //take over the filtered buffer; the FFT is done in place without another copy
+    auto fftData = std::move(fidResult.fid);
+
+    //do the FT. Plans are cached per size inside FftBackend, and concurrent transforms do not block one another
+    FftBackend::forwardReal(settings.fftBackend,fftData.data(),fftData.size());
 
+    double scf = pow(10.,static_cast<double>(settings.units))/static_cast<double>(fid.size());
+    auto spectrum = makeSpectrum(fftData,fid,scf,settings,doubleSideband);
+
+    //the signal is used for asynchronous purposes (in UI classes), and the return value for synchronous (in non-UI classes)
+    if(id>-1)
+        emit ftDone(spectrum,id);
+
+    return spectrum;
+}
+
+Ft FtWorker::cachedFT(const Fid fid, const FidProcessingSettings &settings, int id)
+{
+    if(fid.size() < 2)
+        return doFT(fid,settings,id);
+
+    QMutexLocker ml(pu_ftCacheLock.get());
+    auto &ps = d_cachedFts[id];
+    if(!ps)
+        ps = std::make_shared<CachedFtState>();
+    auto ps_state = ps;
+    ml.unlock();
+
+    //callers process each id serially, so the state itself does not need a lock
+    auto &st = *ps_state;
+
+    bool same = !st.ft.isEmpty() && st.fid.shots() == fid.shots() && st.fid.size() == fid.size()
+            && qFuzzyCompare(st.fid.spacing(),fid.spacing()) && qFuzzyCompare(st.fid.probeFreq(),fid.probeFreq())
+            && qFuzzyCompare(st.fid.vMult(),fid.vMult()) && st.fid.sideband() == fid.sideband()
+            && settingsEqual(st.settings,settings) && st.fid.rawData() == fid.rawData();
+
+    if(!same)
+    {
+        st.ft = doFT(fid,settings,id);
+        st.fid = fid;
+        st.settings = settings;
+        return st.ft;
+    }
+
+    //nothing has changed since the last call; only the (inexpensive) filtered Fid is redone
+    auto fidResult = filterFid(fid,settings);
+    emit fidDone(fidResult.fid,fid.spacing()*1e6,fidResult.min,fidResult.max,id);
+    emit ftDone(st.ft,id);
+
+    return st.ft;
+}
+
+void FtWorker::resetCachedFT(int id)
+{
+    QMutexLocker ml(pu_ftCacheLock.get());
+    if(id < 0)
+        d_cachedFts.clear();
+    else
+        d_cachedFts.erase(id);
+}
+
+Ft FtWorker::makeSpectrum(QVector<double> &fftData, const Fid &fid, double scf, const FidProcessingSettings &settings, bool doubleSideband)
+{
+    auto s = fftData.size();
     auto spacing = fid.spacing()*1.0e6;
     auto probe = fid.probeFreq();
     double ftSpacing = 1.0/static_cast<double>(s)/spacing;
@@ -62,96 +246,71 @@ Ft FtWorker::doFT(const Fid fid, const FidProcessingSettings &settings, int id,
         spectrumSize = s;
 
     double bandwidth = (spectrumSize-1)*ftSpacing;
-    Ft spectrum;
+    double f0 = probe-bandwidth;
     if(doubleSideband)
-        spectrum = Ft(spectrumSize,probe-bandwidth/2.0,ftSpacing,probe);
+        f0 = probe-bandwidth/2.0;
     else if(fid.sideband() == RfConfig::UpperSideband)
-        spectrum = Ft(spectrumSize,probe,ftSpacing,probe);
-    else
-        spectrum = Ft(spectrumSize,probe-bandwidth,ftSpacing,probe);
-
-    //might need to allocate or reallocate workspace and wavetable
-    QWriteLocker l(pu_fftLock.get());
-    if(s != d_numPnts)
-    {
-        //free memory if this is a reallocation
-        //this should be very infrequent
-        d_numPnts = s;
-        if(real)
-        {
-            gsl_fft_real_wavetable_free(real);
-            gsl_fft_real_workspace_free(work);
-        }
-
-        real = gsl_fft_real_wavetable_alloc(d_numPnts);
-        work = gsl_fft_real_workspace_alloc(d_numPnts);
-    }
-
-    //do the FT. See GNU Scientific Library documentation for details
-    gsl_fft_real_transform (fftData.data(), 1, d_numPnts, real, work);
-    l.unlock();
-
-
-
+        f0 = probe;
 
     //convert fourier coefficients into magnitudes. the coefficients are stored in half-complex format
     //see http://www.gnu.org/software/gsl/manual/html_node/Mixed_002dradix-FFT-routines-for-real-data.html
     //first point is DC; block it!
+    //the magnitudes overwrite the front of the FFT buffer (mag[i] only depends on entries >= 2i-1),
+    //so no additional scratch memory is needed
+    int numMags = s/2 + 1;
+    auto mag = fftData.data();
+    halfComplexMagnitudes(mag,s,scf);
+
     //always make sure that data go from low to high frequency
+    QVector<double> ftData(spectrumSize);
+    auto out = ftData.data();
     if(doubleSideband)
-        spectrum.setPoint(spectrumSize/2,0.0,settings.autoScaleIgnoreMHz);
-    else if(fid.sideband() == RfConfig::UpperSideband)
-        spectrum.setPoint(0,0.0,settings.autoScaleIgnoreMHz);
-    else
-        spectrum.setPoint(spectrumSize-1,0.0,settings.autoScaleIgnoreMHz);
-
-    int i;
-    double scf = pow(10.,static_cast<double>(settings.units))/rawSize;
-    for(i=1; i<s-i; i++)
     {
-
-        //calculate real and imaginary coefficients
-        double coef_real = fftData.at(2*i-1);
-        double coef_imag = fftData.at(2*i);
-
-        //calculate magnitude and update max
-        //note: Normalize output, and convert to mV
-        double coef_mag = sqrt(coef_real*coef_real + coef_imag*coef_imag)*scf;
-
-        if(doubleSideband)
+        int c = spectrumSize/2;
+        for(int i=1; i<numMags; i++)
         {
-            spectrum.setPoint(spectrumSize/2+i,coef_mag,settings.autoScaleIgnoreMHz);
-            spectrum.setPoint(spectrumSize/2-i,coef_mag,settings.autoScaleIgnoreMHz);
+            if(c+i < spectrumSize)
+                out[c+i] = mag[i];
+            out[c-i] = mag[i];
         }
-        else if(fid.sideband() == RfConfig::UpperSideband)
-            spectrum.setPoint(i,coef_mag,settings.autoScaleIgnoreMHz);
-        else
-            spectrum.setPoint(spectrumSize-1-i,coef_mag,settings.autoScaleIgnoreMHz);
     }
-    if(i==s-i)
-    {
-        double d = sqrt(fftData.at(s-1)*fftData.at(s-1))*scf;
+    else if(fid.sideband() == RfConfig::UpperSideband)
+        std::copy(mag+1,mag+numMags,out+1);
+    else
+        std::reverse_copy(mag+1,mag+numMags,out);
 
-        if(doubleSideband)
+    //autoscale range, skipping points within autoScaleIgnoreMHz of the LO
+    double yMin = 0.0, yMax = 0.0;
+    for(int i=0; i<spectrumSize; i++)
+    {
+        if(qAbs(f0 + i*ftSpacing - probe) > settings.autoScaleIgnoreMHz)
         {
-            spectrum.setPoint(spectrumSize/2+i,d,settings.autoScaleIgnoreMHz);
-            spectrum.setPoint(spectrumSize/2-i,d,settings.autoScaleIgnoreMHz);
+            yMin = qMin(out[i],yMin);
+            yMax = qMax(out[i],yMax);
         }
-        if(fid.sideband() == RfConfig::UpperSideband)
-            spectrum.setPoint(i,d,settings.autoScaleIgnoreMHz);
-        else
-            spectrum.setPoint(spectrumSize-1-i,d,settings.autoScaleIgnoreMHz);
     }
 
+    Ft spectrum(0,f0,ftSpacing,probe);
+    spectrum.setData(ftData,yMin,yMax);
     spectrum.setNumShots(fid.shots());
 
-    //the signal is used for asynchronous purposes (in UI classes), and the return value for synchronous (in non-UI classes)
-    if(id>-1)
-        emit ftDone(spectrum,id);
-
     return spectrum;
 }
 
+bool FtWorker::preFftSettingsEqual(const FidProcessingSettings &a, const FidProcessingSettings &b)
+{
+    //units and autoScaleIgnoreMHz are applied after the FT
+    return qFuzzyCompare(1.0+a.startUs,1.0+b.startUs) && qFuzzyCompare(1.0+a.endUs,1.0+b.endUs)
+            && a.zeroPadFactor == b.zeroPadFactor && a.removeDC == b.removeDC
+            && a.windowFunction == b.windowFunction && a.fftBackend == b.fftBackend;
+}
+
+bool FtWorker::settingsEqual(const FidProcessingSettings &a, const FidProcessingSettings &b)
+{
+    return preFftSettingsEqual(a,b) && a.units == b.units
+            && qFuzzyCompare(1.0+a.autoScaleIgnoreMHz,1.0+b.autoScaleIgnoreMHz);
+}
+
 void FtWorker::doFtDiff(const Fid ref, const Fid diff, const FidProcessingSettings &settings)
 {
     if(ref.size() != diff.size() || ref.sideband() != diff.sideband())
@@ -178,7 +337,6 @@ void FtWorker::doFtDiff(const Fid ref, const Fid diff, const FidProcessingSettin
     else
     {
         auto [drs,f0] = resample(r.minFreqMHz(),r.xSpacing(),d);
-        clearSplineMemory();
 
         out.setX0(qMin(r.minFreqMHz(),f0));
 
@@ -200,251 +358,143 @@ void FtWorker::doFtDiff(const Fid ref, const Fid diff, const FidProcessingSettin
 
 }
 
-void FtWorker::processSideband(const FtWorker::SidebandProcessingData &d, const FtWorker::FidProcessingSettings &settings)
+Ft FtWorker::processSidebands(const FtWorker::SidebandProcessingData &d, const FtWorker::FidProcessingSettings &settings, const std::function<Fid (int)> &loadFid)
 {
-    if(d.currentIndex >= d.totalFids)
-        return;
+    auto cancelled = [&d](){ return d.cancel && d.cancel->load(); };
+    std::atomic<int> done{0};
 
-    if(d.currentIndex == 0)
-    {
-        d_workingSidebandFt = Ft();
-        d_sidebandIndices.clear();
-        clearSplineMemory();
-    }
+    //load, transform, and trim one segment
+    auto makeFt = [&](int i) -> Ft {
+        if(cancelled())
+            return Ft();
 
-    auto fid = d.fid;
-    if(!d.doubleSideband)
-        fid.setSideband(d.sideband);
+        auto fid = loadFid(i);
+        if(fid.isEmpty())
+            return Ft();
+
+        if(!d.doubleSideband)
+            fid.setSideband(d.sideband);
 
-    if(!fid.isEmpty())
-    {
         auto ft = doFT(fid,settings,-1,d.doubleSideband);
         if(d.minOffset > 0.0 || d.maxOffset < (ft.maxFreqMHz()-ft.minFreqMHz()))
             ft.trim(d.minOffset,d.maxOffset);
 
-        if(d.currentIndex == 0)
+        return ft;
+    };
+
+    //the first nonempty segment defines the frequency grid; everything else is resampled onto it
+    SidebandAccumulator total;
+    double x0 = 0.0, spacing = 0.0, lo = 0.0;
+    int next = 0;
+    while(next < d.totalFids && total.isEmpty() && !cancelled())
+    {
+        auto ft = makeFt(next++);
+        if(!ft.isEmpty())
         {
-            d_workingSidebandFt = ft;
-            d_sidebandIndices.emplace(0,1);
-            d_sidebandIndices.emplace(ft.size()-1,-1);
+            x0 = ft.xFirst();
+            spacing = ft.xSpacing();
+            lo = ft.loFreqMHz();
+            total = SidebandAccumulator(ft.yData(),0,ft.shots());
         }
-        else
-        {
-            auto [rhs,f0] = resample(d_workingSidebandFt.xFirst(),d_workingSidebandFt.xSpacing(),ft);
-                    int offset = static_cast<int>((f0-d_workingSidebandFt.minFreqMHz())/d_workingSidebandFt.xSpacing());
-
-                    //compute size of new working FT
-                    int leftIndex = qMin(offset,0);
-                    int rightIndex = qMax(offset+rhs.size()-1,d_workingSidebandFt.size()-1);
-                    int newSize = rightIndex - leftIndex + 1;
-
-                    QVector<double> lhs = d_workingSidebandFt.yData();
-                    QVector<double> newData;
-                    newData.reserve(newSize);
-                    bool origlhs = true;
-
-                    if(offset < 0)
-            {
-                //need to rebuild working Ft with new minimum frequency
-                //adjust indices to new reference
-                auto copy = d_sidebandIndices;
-                d_sidebandIndices.clear();
-                for(auto &[key,val] : copy)
-                    d_sidebandIndices.emplace(key-offset,val);
-
-                d_sidebandIndices.emplace(0,1);
-                d_sidebandIndices.emplace(ft.size()-1,-1);
-
-                d_workingSidebandFt.setX0(f0);
-                qSwap(lhs,rhs);
-                offset = -offset;
-                origlhs = false;
-            }
-            else
-            {
-                d_sidebandIndices.emplace(offset,1);
-                d_sidebandIndices.emplace(offset+ft.size()-1,-1);
-            }
-
-            //at this point, the first point in lhs is index 0, and the first point in rhs is index offset.
-            //using the working sideband indices, create a data structure with current counts (0 where data will be new)
-            int currentCount = 0;
-
-            //loop over new points. If count is 0, append lhs if count is < offet, rhs if count > offset
-            //If count is 1 or greater, do geometric mean if lhs and rhs are both > 0; arithmetic mean otherwise
-            //use the counts structure to determine the current count
-            double yMin = 0.0;
-            double yMax = 0.0;
-            int i = 0;
-
-            //this loop is structured to make effective use of branch prediction
-            //most of the if statements in the while statements will evaluate the same way
-            //in each iteration of the outer for loop. The exception is the code that
-            //detects if either point is a 0, but that condition should be rare.
-            for(auto it = d_sidebandIndices.cbegin(); it != d_sidebandIndices.cend(); ++it)
-            {
-                //possible that there are duplicate indices if ane segment starts when another stops
-                while(i > it->first && it != d_sidebandIndices.cend())
-                {
-                    currentCount += it->second;
-                    ++it;
-                }
-
-
-                double thisCount = currentCount;
-                double totalCount = thisCount+1.0;
-                double ratio = thisCount/totalCount;
-                if(it == d_sidebandIndices.cend())
-                {
-                    while(i < newSize-1)
-                    {
-                        auto d = rhs.at(i+offset);
-                        yMin = qMin(yMin,d);
-                        yMax = qMax(yMax,d);
-                        newData.append(d);
-                        ++i;
-                    }
-                    break;
-                }
-
-                while(i < it->first)
-                {
-                    if(i >= lhs.size())
-                    {
-                        auto val = rhs.value(i-offset);
-                        yMin = qMin(yMin,val);
-                        yMax = qMax(yMax,val);
-                        newData.append(val);
-                        ++i;
-                    }
-                    else
-                    {
-                        auto d = lhs.at(i);
-                        if(it->second == 0 || i < offset)
-                        {
-                            //no points yet at this index; store the current value and move on
-                            yMin = qMin(yMin,d);
-                            yMax = qMax(yMax,d);
-                            newData.append(d);
-                            ++i;
-                        }
-                        else
-                        {
-                            auto d2 = rhs.at(i-offset);
-                            if(d <= 0.0 || d2 <=0.0)
-                            {
-                                //compute arithmetic mean
-                                double val;
-                                if(origlhs)
-                                    val = ratio*d + ratio/totalCount;
-                                else
-                                    val = d/totalCount + ratio*d2;
-                                yMin = qMin(yMin,val);
-                                yMax = qMax(yMax,val);
-                                newData.append(val);
-                                ++i;
-                            }
-                            else
-                            {
-                                //compute geometric mean
-                                double val;
-                                if(origlhs)
-                                    val = pow(10.0,ratio*log10(d) + log10(d2)/totalCount);
-                                else
-                                    val = pow(10.0,log10(d)/totalCount + ratio*log10(d2));
-                                yMin = qMin(yMin,val);
-                                yMax = qMax(yMax,val);
-                                newData.append(val);
-                                ++i;
-                            }
-                        }
-                    }
-                }
-
-                currentCount += it->second;
-            }
+        emit sidebandProgress(++done,d.totalFids);
+    }
 
-            //if points remain, fill them in
-            while(i < newSize-1)
+    //remaining segments are processed in chunks to bound the number of spectra held in memory.
+    //The loads and FTs are long and may block on disk, so they run on the global pool rather
+    //than on Analysis::workerPool(), which is reserved for shot processing.
+    auto pool = QThreadPool::globalInstance();
+    int chunk = 2*(pool->maxThreadCount()+1);
+    while(next < d.totalFids && !cancelled())
+    {
+        int n = qMin(chunk,d.totalFids-next);
+        QVector<SidebandAccumulator> parts(n);
+        auto pp = parts.data();
+        Analysis::parallelFor(n,[&](int i){
+            auto ft = makeFt(next+i);
+            if(!ft.isEmpty())
             {
-                auto d = rhs.at(i+offset);
-                yMin = qMin(yMin,d);
-                yMax = qMax(yMax,d);
-                newData.append(d);
-                ++i;
+                auto [y,f0] = resample(x0,spacing,ft);
+                pp[i] = SidebandAccumulator(y,qRound((f0-x0)/spacing),ft.shots());
             }
+            emit sidebandProgress(++done,d.totalFids);
+        },pool);
+        next += n;
 
-            d_workingSidebandFt.setData(newData,yMin,yMax);
-            d_workingSidebandFt.setNumShots(d_workingSidebandFt.shots() + ft.shots());
+        //pairwise tree reduction of the chunk, then fold it into the total
+        for(int stride = 1; stride < n; stride *= 2)
+        {
+            Analysis::parallelFor((n+2*stride-1)/(2*stride),[pp,stride,n](int p){
+                int a = 2*p*stride;
+                if(a+stride < n)
+                    pp[a].merge(pp[a+stride]);
+            },pool);
         }
+        total.merge(parts.constFirst());
     }
 
-    if(d.currentIndex + 1 >= d.totalFids)
-    {
-        emit sidebandDone(d_workingSidebandFt);
-        d_workingSidebandFt = Ft();
-        clearSplineMemory();
-        d_sidebandIndices.clear();
-    }
+    if(cancelled() || total.isEmpty())
+        return Ft();
+
+    double yMin = 0.0, yMax = 0.0;
+    auto y = total.result(yMin,yMax);
+    Ft out(0,x0 + total.first*spacing,spacing,lo);
+    out.setData(y,yMin,yMax);
+    out.setNumShots(total.shots);
 
+    emit sidebandDone(out);
+    return out;
 }
 
 FtWorker::FilterResult FtWorker::filterFid(const Fid fid, const FidProcessingSettings &settings)
 {
+    //work directly from the raw sums: y = raw*vMult/shots
+    auto raw = fid.rawSpan();
+    double scale = fid.vMult();
+    if(fid.shots() > 1)
+        scale /= static_cast<double>(fid.shots());
 
-    QVector<double> out(fid.size());
-    QVector<double> data = fid.toVector();
-
-    bool fStart = (settings.startUs > 0.001);
-    bool fEnd = (settings.endUs > 0.001);
+    return filterRaw(raw.data(),raw.size(),fid.spacing(),scale,settings);
+}
 
-    int si = qBound(0, static_cast<int>(floor(settings.startUs*1e-6/fid.spacing())), fid.size()-1);
-    int ei = qBound(0,static_cast<int>(ceil(settings.endUs*1e-6/fid.spacing())), fid.size()-1);
-    if(!fStart || si - ei >= 0)
+FtWorker::FilterResult FtWorker::filterRaw(const qint64 *raw, int size, double spacing, double scale, const FidProcessingSettings &settings)
+{
+    int si = qBound(0, static_cast<int>(floor(settings.startUs*1e-6/spacing)), size-1);
+    int ei = qBound(0,static_cast<int>(ceil(settings.endUs*1e-6/spacing)), size-1);
+    if(settings.startUs <= 0.001 || si - ei >= 0)
         si = 0;
-    if(!fEnd || ei <= si)
-        ei = fid.size()-1;
+    if(settings.endUs <= 0.001 || ei <= si)
+        ei = size-1;
 
     int n = ei - si + 1;
 
+    //allocate the (zero-padded) output once; points outside the FT range stay 0
+    int outSize = size;
+    if(settings.zeroPadFactor > 0 && settings.zeroPadFactor <= 2)
+        outSize = Analysis::nextPowerOf2(size * (1 << settings.zeroPadFactor));
+    QVector<double> out(outSize);
+
+    auto src = raw + si;
+
+    double avg = 0.0;
     if(settings.removeDC)
     {
-        //calculate average of samples in the FT range, then subtract that from each point
+        //calculate average of samples in the FT range in raw units, then subtract that from each point
         //use Kahan summation
         double sum = 0.0;
         double c = 0.0;
-        for(int i=0; i<data.size(); i++)
+        for(int i=0; i<n; i++)
         {
-            if(i < si)
-                continue;
-
-            if(i > ei)
-                break;
-
-            float y = data.at(i) - c;
-            float t = sum + y;
+            double y = static_cast<double>(src[i]) - c;
+            double t = sum + y;
             c = (t-sum) - y;
             sum = t;
         }
 
-        double avg = sum/static_cast<double>(n);
-        for(int i=0; i<data.size(); i++)
-        {
-            if(i < si)
-                continue;
-
-            if(i > ei)
-                break;
-
-            data[i] -= avg;
-        }
-
+        avg = sum/static_cast<double>(n);
     }
 
-    double min = data.at(si);
-    double max = min;
     QReadLocker l(pu_winfLock.get());
-    if(settings.windowFunction != d_lastWinf || d_lastWinSize != n)
+    if(settings.windowFunction != None && (settings.windowFunction != d_lastWinf || d_lastWinSize != n))
     {
         l.unlock();
         QWriteLocker l2(pu_winfLock.get());
@@ -452,29 +502,28 @@ FtWorker::FilterResult FtWorker::filterFid(const Fid fid, const FidProcessingSet
         l2.unlock();
         l.relock();
     }
-    for(int i=0; i<data.size(); i++)
-    {
-        if(i < si)
-            continue;
 
-        if(i > ei)
-            break;
-
-
-        double d = data.at(i);
-        if(settings.windowFunction != None)
-            d*=d_winf.at(i-si);
-
-        out[i] = d;
-        min = qMin(d,min);
-        max = qMax(d,max);
+    //single pass: scale, remove DC, and apply window
+    auto dst = out.data() + si;
+    if(settings.windowFunction != None)
+    {
+        auto w = d_winf.constData();
+        for(int i=0; i<n; i++)
+            dst[i] = (static_cast<double>(src[i]) - avg)*scale*w[i];
+    }
+    else
+    {
+        for(int i=0; i<n; i++)
+            dst[i] = (static_cast<double>(src[i]) - avg)*scale;
     }
+    l.unlock();
 
-    if(settings.zeroPadFactor > 0 && settings.zeroPadFactor <= 2)
+    double min = dst[0];
+    double max = min;
+    for(int i=1; i<n; i++)
     {
-        int filledSize = Analysis::nextPowerOf2(data.size() * (1 << settings.zeroPadFactor));
-        if(out.size() != filledSize)
-            out.resize(filledSize);
+        min = qMin(dst[i],min);
+        max = qMax(dst[i],max);
     }
 
     return {out,min,max};
@@ -487,7 +536,7 @@ QPair<QVector<double>,double> FtWorker::resample(double f0, double spacing, cons
         return {};
 
     if(qFuzzyCompare(f0,ft.xFirst()) && qFuzzyCompare(spacing,ft.xSpacing()))
-        return {};
+        return {ft.yData(),ft.xFirst()};
 
 
     double minF = ft.minFreqMHz();
@@ -497,45 +546,23 @@ QPair<QVector<double>,double> FtWorker::resample(double f0, double spacing, cons
 
     int numPoints = ft.size();
 
-    //set up spline object with FT data
+    //set up spline object with FT data. GSL needs an explicit x array, but y can be read in place
     auto xd = ft.xData();
-    auto yd = ft.yData();
-
-    //allocate or reallocate gsl_spline object
-    QReadLocker l(pu_splineLock.get());
-    if(ft.size() != d_numSplinePoints)
-    {
-        l.unlock();
-        QWriteLocker l2(pu_splineLock.get());
-        d_numSplinePoints = ft.size();
-
-        if(p_spline != nullptr)
-            gsl_spline_free(p_spline);
-
-        p_spline = gsl_spline_alloc(gsl_interp_cspline,d_numSplinePoints);
-
-        if(p_accel != nullptr)
-        {
-            gsl_interp_accel_free(p_accel);
-            p_accel = gsl_interp_accel_alloc();
-        }
-        l2.unlock();
-        l.relock();
-    }
+    auto yd = ft.ySpan();
 
+    //each call gets its own spline so that segments can be resampled concurrently
+    std::unique_ptr<gsl_spline,void(*)(gsl_spline*)> spline(gsl_spline_alloc(gsl_interp_cspline,numPoints),gsl_spline_free);
+    std::unique_ptr<gsl_interp_accel,void(*)(gsl_interp_accel*)> accel(gsl_interp_accel_alloc(),gsl_interp_accel_free);
+    gsl_spline_init(spline.get(),xd.constData(),yd.data(),numPoints);
 
-    gsl_spline_init(p_spline,xd.constData(),yd.constData(),d_numSplinePoints);
-
-    QVector<double> out;
-    out.reserve(numPoints);
-
+    QVector<double> out(numPoints);
     for(int i=0; i<numPoints; ++i)
     {
         double x = firstPt + static_cast<double>(i)*spacing;
-        double y = gsl_spline_eval(p_spline,x,p_accel);
+        double y = gsl_spline_eval(spline.get(),x,accel.get());
         if(isnan(y))
             y = 0.0;
-        out.append(y);
+        out[i] = y;
     }
 
     return {out,firstPt};
@@ -649,13 +676,3 @@ void FtWorker::winKaiserBessel(int n, double beta)
     }
 }
 
-void FtWorker::clearSplineMemory()
-{
-    QWriteLocker l(pu_splineLock.get());
-    gsl_spline_free(p_spline);
-    gsl_interp_accel_free(p_accel);
-    p_spline = nullptr;
-    p_accel = nullptr;
-
-    d_numSplinePoints = -1;
-}
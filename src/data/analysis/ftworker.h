@@ -6,22 +6,25 @@
 #include <QPointF>
 #include <QPair>
 #include <memory>
+#include <atomic>
+#include <functional>
 
-#include <gsl/gsl_fft_real.h>
 #include <gsl/gsl_interp.h>
 #include <gsl/gsl_spline.h>
 
 #include <data/analysis/analysis.h>
 #include <data/analysis/ft.h>
+#include <data/analysis/fftbackend.h>
 #include <data/experiment/fid.h>
 
 class QReadWriteLock;
+class QMutex;
 
 /*!
  \brief Class that handles processing of FIDs
 
- This class uses algorithms from the GNU Scientific library to perform Fast Fourier Transforms on Fid objects.
- The FFT algorithms are based on a mixed-radix approach that is particularly efficient when the Fid length can be factored many times into multiples of 2, 3, and 5.
+ This class performs Fast Fourier Transforms on Fid objects through FftBackend, using either the GNU Scientific Library or FFTW (if available) as selected in FidProcessingSettings.
+ The GSL algorithms are based on a mixed-radix approach that is particularly efficient when the Fid length can be factored many times into multiples of 2, 3, and 5.
  Further details about the algorithm can be found at http://www.gnu.org/software/gsl/manual/html_node/Mixed_002dradix-FFT-routines-for-real-data.html.
  In addition, an Fid can be processed by high pass filtering, exponential filtering, and truncation.
 
@@ -62,6 +65,7 @@ public:
         FtUnits units;
         double autoScaleIgnoreMHz;
         FtWindowFunction windowFunction;
+        FftBackend::Type fftBackend{FftBackend::Gsl};
     };
 
     struct FilterResult {
@@ -71,13 +75,12 @@ public:
     };
 
     struct SidebandProcessingData {
-        Fid fid;
         int totalFids{0};
-        int currentIndex{0};
         double minOffset{-1.0};
         double maxOffset{-1.0};
         RfConfig::Sideband sideband{RfConfig::UpperSideband};
         bool doubleSideband{false};
+        std::shared_ptr<std::atomic<bool>> cancel;
     };
 
     /*!
@@ -103,6 +106,7 @@ signals:
     void ftDiffDone(Ft);
 
     void sidebandDone(Ft);
+    void sidebandProgress(int done, int total);
 
 public slots:
     /*!
@@ -112,11 +116,46 @@ public slots:
      \return QPair<QVector<QPointF>, double> Resulting FT magnitude spectrum in XY format and maximum Y value
     */
     Ft doFT(const Fid fid, const FtWorker::FidProcessingSettings &settings, int id = -1, bool doubleSideband=false);
+
+    /*!
+     \brief Performs doFT, memoizing the last result for each id
+
+     The spectrum is always computed from the whole Fid; nothing is updated incrementally.
+     The last Fid, settings, and spectrum are kept per id. If the raw data, shots, metadata,
+     and settings all match the kept input, the stored spectrum is emitted again without an
+     FFT. Otherwise doFT runs and its result replaces the stored one.
+
+     Emits fidDone and ftDone like doFT. Calls for a given id must not overlap.
+
+     \param fid Fid to analyze
+     \param id Identifier of the cache (and of the emitted results)
+     \return Ft Magnitude spectrum
+    */
+    Ft cachedFT(const Fid fid, const FtWorker::FidProcessingSettings &settings, int id);
+
+    /*!
+     \brief Discards the spectrum cached by cachedFT for id, or all of them if id < 0
+    */
+    void resetCachedFT(int id = -1);
     void doFtDiff(const Fid ref, const Fid diff, const FtWorker::FidProcessingSettings &settings);
-//    Ft processSideband(const FidList fl, const FtWorker::FidProcessingSettings &settings, RfConfig::Sideband sb, double minFreq = 0.0, double maxFreq = -1.0);
-//    void processBothSidebands(const FidList fl, const FtWorker::FidProcessingSettings &settings, double minFreq = 0.0, double maxFreq = -1.0);
 
-    void processSideband(const SidebandProcessingData &d, const FidProcessingSettings &settings);
+    /*!
+     \brief Merges the spectra of an LO scan into a single sideband spectrum
+
+     Segments are loaded and transformed concurrently on the global thread pool, each is
+     resampled onto the frequency grid of the first nonempty segment, and overlapping bins
+     are combined with a tree reduction of per-bin partial sums (see SidebandAccumulator in
+     ftworker.cpp). The result is the geometric mean of the overlapping segments at each
+     bin. At most a few chunks of segments are held in memory at once.
+
+     sidebandProgress is emitted as each segment finishes, and sidebandDone is emitted with
+     the result unless d.cancel is set during processing.
+
+     \param d Sideband options and an optional cancellation flag
+     \param loadFid Returns the Fid for segment i; called concurrently from several threads
+     \return Ft The merged spectrum, or an empty Ft if cancelled
+    */
+    Ft processSidebands(const SidebandProcessingData &d, const FidProcessingSettings &settings, const std::function<Fid(int)> &loadFid);
 
     /*!
      \brief Perform truncation, high-pass, and exponential filtering on an Fid
@@ -127,21 +166,12 @@ public slots:
     FilterResult filterFid(const Fid fid, const FtWorker::FidProcessingSettings &settings);
 
 private:
-    std::unique_ptr<QReadWriteLock> pu_fftLock, pu_splineLock, pu_winfLock;
-    gsl_fft_real_wavetable *real; /*!< Wavetable for GNU Scientific Library FFT operations */
-    gsl_fft_real_workspace *work; /*!< Memory for GNU Scientific Library FFT operations */
-    int d_numPnts; /*!< Number of points used to allocate last wavetable and workspace */
-
-    gsl_spline *p_spline;
-    gsl_interp_accel *p_accel;
-    int d_numSplinePoints;
+    std::unique_ptr<QReadWriteLock> pu_winfLock;
+    std::unique_ptr<QMutex> pu_ftCacheLock;
 
     FtWindowFunction d_lastWinf{None};
     int d_lastWinSize{0};
 
-    Ft d_workingSidebandFt;
-    std::map<int,int> d_sidebandIndices;
-
     QList<Ft> makeSidebandList(const FidList fl, const FtWorker::FidProcessingSettings &settings, RfConfig::Sideband sb, double minFreq = 0.0, double maxFreq = -1.0);
     QPair<QVector<double>, double> resample(double f0, double spacing, const Ft ft);
 
@@ -156,7 +186,17 @@ private:
     void winHanning(int n);
     void winKaiserBessel(int n, double beta);
 
-    void clearSplineMemory();
+    FilterResult filterRaw(const qint64 *raw, int size, double spacing, double scale, const FtWorker::FidProcessingSettings &settings);
+    Ft makeSpectrum(QVector<double> &fftData, const Fid &fid, double scf, const FtWorker::FidProcessingSettings &settings, bool doubleSideband);
+    static bool preFftSettingsEqual(const FtWorker::FidProcessingSettings &a, const FtWorker::FidProcessingSettings &b);
+    static bool settingsEqual(const FtWorker::FidProcessingSettings &a, const FtWorker::FidProcessingSettings &b);
+
+    struct CachedFtState {
+        Fid fid;
+        FidProcessingSettings settings;
+        Ft ft;
+    };
+    std::map<int,std::shared_ptr<CachedFtState>> d_cachedFts;
 
 };
 
@@ -0,0 +1,57 @@
+#include "timinghistogram.h"
+
+#include <QStringList>
+#include <cmath>
+
+TimingHistogram::TimingHistogram(const QString name) : d_name(name)
+{
+}
+
+void TimingHistogram::add(double ms)
+{
+    ms = qMax(0.0,ms);
+    int bin = 0;
+    if(ms >= 1.0)
+        bin = qMin(numBins-1,static_cast<int>(std::floor(std::log2(ms)))+1);
+
+    d_bins[bin]++;
+    d_count++;
+    d_sum += ms;
+    d_max = qMax(d_max,ms);
+}
+
+void TimingHistogram::clear()
+{
+    d_bins.fill(0);
+    d_count = 0;
+    d_sum = 0.0;
+    d_max = 0.0;
+}
+
+double TimingHistogram::mean() const
+{
+    return d_count > 0 ? d_sum/static_cast<double>(d_count) : 0.0;
+}
+
+QString TimingHistogram::summary() const
+{
+    QStringList bins;
+    for(int i=0; i<numBins; ++i)
+    {
+        if(d_bins.at(i) == 0)
+            continue;
+
+        QString range;
+        if(i == 0)
+            range = QString("<1");
+        else if(i == numBins-1)
+            range = QString(">=%1").arg(1 << (i-1));
+        else
+            range = QString("%1-%2").arg(1 << (i-1)).arg(1 << i);
+
+        bins << QString("%1 ms: %2").arg(range).arg(d_bins.at(i));
+    }
+
+    return QString("%1: %2 samples, mean %3 ms, max %4 ms (%5)").arg(d_name).arg(d_count)
+            .arg(mean(),0,'f',1).arg(d_max,0,'f',1).arg(bins.join(", "));
+}
@@ -0,0 +1,42 @@
+#ifndef TIMINGHISTOGRAM_H
+#define TIMINGHISTOGRAM_H
+
+#include <QString>
+#include <array>
+
+/*!
+ * \brief Histogram of durations with power-of-2 millisecond bins
+ *
+ * Bin 0 holds durations shorter than 1 ms, and bin i holds durations from 2^(i-1) to 2^i ms. The
+ * last bin also holds everything longer. The mean and maximum are tracked exactly.
+ */
+class TimingHistogram
+{
+public:
+    static constexpr int numBins{20};
+
+    explicit TimingHistogram(const QString name = QString(""));
+
+    void add(double ms);
+    void clear();
+
+    quint64 count() const { return d_count; }
+    quint64 binCount(int i) const { return d_bins.at(i); }
+    double mean() const;
+    double max() const { return d_max; }
+
+    /*!
+     * \brief One-line description: count, mean, max, and the nonempty bins
+     * \return QString Summary
+     */
+    QString summary() const;
+
+private:
+    QString d_name;
+    std::array<quint64,numBins> d_bins{};
+    quint64 d_count{0};
+    double d_sum{0.0};
+    double d_max{0.0};
+};
+
+#endif // TIMINGHISTOGRAM_H
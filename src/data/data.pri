@@ -1,8 +1,11 @@
 SOURCES += $$PWD/loghandler.cpp \
     $$PWD/analysis/analysis.cpp \
+    $$PWD/analysis/cpuaverager.cpp \
+    $$PWD/analysis/fftbackend.cpp \
     $$PWD/analysis/ft.cpp \
     $$PWD/analysis/ftworker.cpp \
     $$PWD/analysis/peakfinder.cpp \
+    $$PWD/analysis/timinghistogram.cpp \
     $$PWD/experiment/chirpconfig.cpp \
     $$PWD/experiment/digitizerconfig.cpp \
     $$PWD/experiment/experiment.cpp \
@@ -21,6 +24,9 @@ SOURCES += $$PWD/loghandler.cpp \
     $$PWD/storage/auxdatastorage.cpp \
     $$PWD/storage/blackchirpcsv.cpp \
     $$PWD/storage/datastoragebase.cpp \
+    $$PWD/storage/fidbinaryfile.cpp \
+    $$PWD/storage/fidindexfile.cpp \
+    $$PWD/storage/fidwriter.cpp \
    $$PWD/storage/fidmultistorage.cpp \
     $$PWD/storage/fidpeakupstorage.cpp \
     $$PWD/storage/fidsinglestorage.cpp \
@@ -31,9 +37,13 @@ SOURCES += $$PWD/loghandler.cpp \
 
 HEADERS += $$PWD/loghandler.h \
     $$PWD/analysis/analysis.h \
+    $$PWD/analysis/cpuaverager.h \
+    $$PWD/analysis/dataspan.h \
+    $$PWD/analysis/fftbackend.h \
     $$PWD/analysis/ft.h \
     $$PWD/analysis/ftworker.h \
     $$PWD/analysis/peakfinder.h \
+    $$PWD/analysis/timinghistogram.h \
     $$PWD/experiment/chirpconfig.h \
     $$PWD/experiment/digitizerconfig.h \
     $$PWD/experiment/experiment.h \
@@ -52,6 +62,9 @@ HEADERS += $$PWD/loghandler.h \
     $$PWD/storage/auxdatastorage.h \
     $$PWD/storage/blackchirpcsv.h \
     $$PWD/storage/datastoragebase.h \
+    $$PWD/storage/fidbinaryfile.h \
+    $$PWD/storage/fidindexfile.h \
+    $$PWD/storage/fidwriter.h \
    $$PWD/storage/fidmultistorage.h \
     $$PWD/storage/fidpeakupstorage.h \
     $$PWD/storage/fidsinglestorage.h \
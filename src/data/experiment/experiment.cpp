@@ -16,6 +16,7 @@
 #include <QFile>
 #include <QDir>
 #include <QTextStream>
+#include <QMutex>
 
 Experiment::Experiment() : HeaderStorage(BC::Store::Exp::key)
 {
@@ -441,6 +442,13 @@ void Experiment::setPulseGenConfig(const PulseGenConfig &c)
     pu_pGenCfg = std::make_unique<PulseGenConfig>(c);
 }
 
+void Experiment::setErrorString(const QString s)
+{
+    static QMutex mutex;
+    QMutexLocker l(&mutex);
+    d_errorString = s;
+}
+
 void Experiment::setFlowConfig(const FlowConfig &c)
 {
     pu_flowCfg = std::make_unique<FlowConfig>(c);
@@ -514,6 +522,13 @@ void Experiment::finalSave()
 
     for(auto obj : d_objectives)
         obj->cleanupAndSave();
+
+    //FID data are written in the background; wait until everything is on disk
+    if(ftmwEnabled() && pu_ftmwConfig->storage())
+    {
+        if(!pu_ftmwConfig->storage()->flush())
+            d_errorString = QString("One or more FID files could not be written.");
+    }
 }
 
 bool Experiment::saveObjectives()
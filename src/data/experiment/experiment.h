@@ -94,6 +94,15 @@ public:
 
     void setIOBoardConfig(const IOBoardConfig &cfg);
     void setPulseGenConfig(const PulseGenConfig &c);
+    /*!
+     * \brief Sets d_errorString. Safe to call from several hardware threads at once
+     *
+     * Hardware objects are prepared for an experiment concurrently, so they must use this
+     * function rather than assigning d_errorString directly.
+     *
+     * \param s Error message
+     */
+    void setErrorString(const QString s);
     void setFlowConfig(const FlowConfig &c);
     void setPressureControllerConfig(const PressureControllerConfig &c);
     void setTempControllerConfig(const TemperatureControllerConfig &c);
@@ -149,6 +149,7 @@ double Fid::probeFreq() const
 QVector<QPointF> Fid::toXY() const
 {
     //create a vector of points that can be displayed
+    Analysis::countPayloadCopy();
     QVector<QPointF> out;
     out.reserve(size());
 
@@ -160,6 +161,7 @@ QVector<QPointF> Fid::toXY() const
 
 QVector<double> Fid::toVector() const
 {
+    Analysis::countPayloadCopy();
     QVector<double> out;
     out.reserve(size());
     for(int i=0;i<size();i++)
@@ -173,6 +175,21 @@ QVector<qint64> Fid::rawData() const
     return data->fid;
 }
 
+DataSpan<qint64> Fid::rawSpan() const
+{
+    return {data->fid.constData(),data->fid.size()};
+}
+
+qint64 *Fid::rawDataPtr()
+{
+    return data->fid.data();
+}
+
+bool Fid::isShared() const
+{
+    return data.constData()->ref.loadRelaxed() != 1 || !data->fid.isDetached();
+}
+
 qint64 Fid::atRaw(const int i) const
 {
     return data->fid.at(i);
@@ -231,3 +248,40 @@ double Fid::vMult() const
 {
     return data->vMult;
 }
+
+void FidArena::reset()
+{
+    d_list.clear();
+    d_allocations = 0;
+}
+
+FidList &FidArena::next(const Fid &fidTemplate, int numRecords, int recordLength)
+{
+    //a caller still holding the previous list would force a copy on the first write
+    if(!d_list.isEmpty() && !d_list.isDetached())
+    {
+        d_list.detach();
+        d_allocations++;
+    }
+
+    if(d_list.size() != numRecords)
+        d_list.resize(numRecords);
+
+    for(auto &f : d_list)
+    {
+        if(f.isShared() || f.size() != recordLength)
+        {
+            f = Fid();
+            f.setData(QVector<qint64>(recordLength));
+            d_allocations++;
+        }
+
+        f.setSpacing(fidTemplate.spacing());
+        f.setProbeFreq(fidTemplate.probeFreq());
+        f.setVMult(fidTemplate.vMult());
+        f.setSideband(fidTemplate.sideband());
+        f.setShots(0);
+    }
+
+    return d_list;
+}
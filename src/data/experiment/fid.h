@@ -9,6 +9,7 @@
 #include <QDataStream>
 
 #include <data/experiment/rfconfig.h>
+#include <data/analysis/dataspan.h>
 
 class FidData;
 
@@ -136,6 +137,27 @@ public:
 
     QVector<qint64> rawData() const;
 
+    /*!
+     \brief Read-only view of the raw data that does not copy it
+
+     \return DataSpan<qint64> View that is valid until this Fid is modified or destroyed
+    */
+    DataSpan<qint64> rawSpan() const;
+
+    /*!
+     \brief Writable pointer to the raw data (can cause deep copy)
+
+     \return qint64 Pointer to the first point
+    */
+    qint64 *rawDataPtr();
+
+    /*!
+     \brief Whether the data are referenced by another Fid
+
+     \return bool True if writing to the data would cause a deep copy
+    */
+    bool isShared() const;
+
     qint64 atRaw(const int i) const;
 
     qint64 valueRaw(const int i) const;
@@ -181,4 +203,27 @@ Q_DECLARE_TYPEINFO(Fid,Q_MOVABLE_TYPE);
 using FidList = QVector<Fid>;
 Q_DECLARE_TYPEINFO(FidList,Q_MOVABLE_TYPE);
 
+/*!
+ \brief Reusable set of FID buffers for decoding one shot at a time
+
+ next() returns a FidList with one record of the requested length per entry, with metadata copied
+ from the template. The buffers are kept between calls and reused as long as nobody else holds a
+ reference to them, so once the caller has released the previous shot (normally right after it
+ has been accumulated), decoding the next shot does not allocate. The contents of the returned
+ records are not cleared; the caller is expected to overwrite every point.
+
+ allocations() counts the record buffers (and list copies) that had to be made.
+*/
+class FidArena
+{
+public:
+    void reset();
+    FidList &next(const Fid &fidTemplate, int numRecords, int recordLength);
+    quint64 allocations() const { return d_allocations; }
+
+private:
+    FidList d_list;
+    quint64 d_allocations{0};
+};
+
 #endif // FID_H
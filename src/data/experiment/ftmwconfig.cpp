@@ -7,6 +7,7 @@
 
 #include <data/storage/blackchirpcsv.h>
 #include <data/storage/fidpeakupstorage.h>
+#include <data/storage/settingsstorage.h>
 
 FtmwConfig::FtmwConfig() : HeaderStorage(BC::Store::FTMW::key)
 {
@@ -26,96 +27,45 @@ quint64 FtmwConfig::shotIncrement() const
     return increment;
 }
 
-FidList FtmwConfig::parseWaveform(const QByteArray b) const
+FidList FtmwConfig::parseWaveform(const QByteArray b)
 {
-
     int np = d_scopeConfig.d_recordLength;
+    int nr = d_scopeConfig.d_numRecords;
+    int bpp = d_scopeConfig.d_bytesPerPoint;
+    if(b.size() < static_cast<qint64>(nr)*np*bpp)
+        return {};
+
+    //"Undo" averaging that was done by the device, and add any padding bits used for averaging (eg peakup)
     auto shots = shotIncrement();
-    FidList out;
-    //read raw data into vector in 64 bit integer form
-    for(int j=0;j<d_scopeConfig.d_numRecords;j++)
+    qint64 mult = static_cast<qint64>(shots) << bitShift();
+    bool bigEndian = d_scopeConfig.d_byteOrder == DigitizerConfig::BigEndian;
+
+    //the buffers are reused from the previous shot once the caller has released it
+    auto &out = d_parseArena.next(d_fidTemplate,nr,np);
+    auto src = reinterpret_cast<const uchar*>(b.constData());
+    for(int j=0; j<nr; j++)
     {
-        QVector<qint64> d(np);
+        auto &f = out[j];
+        auto d = f.rawDataPtr();
+        auto p = src + static_cast<qint64>(j)*np*bpp;
 
-        for(int i=0; i<np;i++)
+        if(bpp == 1)
         {
-            qint64 dat = 0;
-
-            /*
-            for(int k = 0; k<scopeConfig().bytesPerPoint; k++)
-            {
-                int thisIndex = k;
-                if(scopeConfig().byteOrder == DigitizerConfig::BigEndian)
-                    thisIndex = scopeConfig().bytesPerPoint - k;
-
-                dat |= (static_cast<quint8>(b.at(scopeConfig().bytesPerPoint*(j*np+i)+thisIndex)) << (8*k));
-            }
-            //check for the sign bit on the most significant byte, and carry out sign extension if necessary
-            if(dat | (128 << (scopeConfig().bytesPerPoint-1)))
-                dat &= Q_INT64_C(0xffffffffffffffff);
-
-            dat += static_cast<qint64>(scopeConfig().yOff);
-            */
-
-
-            if(d_scopeConfig.d_bytesPerPoint == 1)
-            {
-                char y = b.at(j*np+i);
-                dat = static_cast<qint64>(y);
-            }
-            else if(d_scopeConfig.d_bytesPerPoint == 2)
-            {
-                auto y1 = static_cast<quint8>(b.at(2*(j*np+i)));
-                auto y2 = static_cast<quint8>(b.at(2*(j*np+i) + 1));
-
-                qint16 y = 0;
-                y |= y1;
-                y |= (y2 << 8);
-
-                if(d_scopeConfig.d_byteOrder == DigitizerConfig::BigEndian)
-                    y = qFromBigEndian(y);
-                else
-                    y = qFromLittleEndian(y);
-
-                dat = (static_cast<qint64>(y));
-            }
-            else
-            {
-                auto y1 = static_cast<quint8>(b.at(4*(j*np+i)));
-                auto y2 = static_cast<quint8>(b.at(4*(j*np+i) + 1));
-                auto y3 = static_cast<quint8>(b.at(4*(j*np+i) + 2));
-                auto y4 = static_cast<quint8>(b.at(4*(j*np+i) + 3));
-
-                qint32 y = 0;
-                y |= y1;
-                y |= (y2 << 8);
-                y |= (y3 << 16);
-                y |= (y4 << 24);
-
-                if(d_scopeConfig.d_byteOrder == DigitizerConfig::BigEndian)
-                    y = qFromBigEndian(y);
-                else
-                    y = qFromLittleEndian(y);
-
-                dat = (static_cast<qint64>(y));
-            }
-
-            //"Undo" averaging that was done by the device
-            //Ok to do this if statement in the loop; the compiler will optimize it
-            if(shots > 1)
-                dat *= shots;
-
-            //some modes (eg peakup) may add additional padding bits for averaging
-            dat = dat << bitShift();
-
-            d[i] = dat;
+            for(int i=0; i<np; i++)
+                d[i] = static_cast<qint64>(static_cast<qint8>(p[i]))*mult;
+        }
+        else if(bpp == 2)
+        {
+            for(int i=0; i<np; i++)
+                d[i] = static_cast<qint64>(bigEndian ? qFromBigEndian<qint16>(p+2*i) : qFromLittleEndian<qint16>(p+2*i))*mult;
+        }
+        else
+        {
+            for(int i=0; i<np; i++)
+                d[i] = static_cast<qint64>(bigEndian ? qFromBigEndian<qint32>(p+4*i) : qFromLittleEndian<qint32>(p+4*i))*mult;
         }
 
-        Fid f = d_fidTemplate;
-        f.setData(d);
-        f.setShots(shotIncrement());
-
-        out.append(f);
+        f.setShots(shots);
     }
 
     return out;
@@ -197,6 +147,7 @@ bool FtmwConfig::initialize()
     f.setVMult(d_scopeConfig.yMult(d_scopeConfig.d_fidChannel)/pow(2,bitShift()));
 
     d_fidTemplate = f;
+    d_parseArena.reset();
 
     if(!d_rfConfig.prepareForAcquisition())
     {
@@ -215,6 +166,15 @@ bool FtmwConfig::initialize()
         d_errorString = ps_gpu->getErrorString();
         return false;
     }
+#else
+    SettingsStorage s(BC::Key::CpuAvg::key);
+    auto b = static_cast<CpuAverager::Backend>(s.get<int>(BC::Key::CpuAvg::backend,CpuAverager::Auto));
+    ps_cpu = std::make_shared<CpuAverager>();
+    if(!ps_cpu->initialize(d_scopeConfig,bitShift(),b))
+    {
+        d_errorString = ps_cpu->getErrorString();
+        return false;
+    }
 #endif
 
     return _init();
@@ -224,30 +184,48 @@ bool FtmwConfig::initialize()
 
 bool FtmwConfig::advance()
 {
-    auto s = p_fidStorage->currentSegmentShots();
-    auto now = QDateTime::currentDateTime();
-    if(d_rfConfig.numSegments() > 1 && d_rfConfig.canAdvance(s))
+    if(beginSegmentTransition())
     {
-        d_processingPaused = true;
-        d_rfConfig.advanceClockStep();
-        p_fidStorage->advance();
-        d_lastAutosaveTime = now;
-#ifdef BC_CUDA
-        ps_gpu->setCurrentData(p_fidStorage->getCurrentFidList());
-#endif
+        finishSegmentTransition();
         return !isComplete();
     }
     else
+        autosave();
+
+    return false;
+
+}
+
+void FtmwConfig::autosave()
+{
+    auto now = QDateTime::currentDateTime();
+    if(d_lastAutosaveTime.addSecs(60) <= now)
     {
-        if(d_lastAutosaveTime.addSecs(60) <= now)
-        {
-            p_fidStorage->save();
-            d_lastAutosaveTime = now;
-        }
+        p_fidStorage->save();
+        d_lastAutosaveTime = now;
+    }
+}
+
+bool FtmwConfig::beginSegmentTransition()
+{
+    auto s = p_fidStorage->currentSegmentShots();
+    if(d_rfConfig.numSegments() > 1 && d_rfConfig.canAdvance(s))
+    {
+        d_processingPaused = true;
+        d_rfConfig.advanceClockStep();
+        return true;
     }
 
     return false;
+}
 
+void FtmwConfig::finishSegmentTransition()
+{
+    p_fidStorage->advance();
+    d_lastAutosaveTime = QDateTime::currentDateTime();
+#ifdef BC_CUDA
+    ps_gpu->setCurrentData(p_fidStorage->getCurrentFidList());
+#endif
 }
 
 bool FtmwConfig::setFidsData(const QVector<QVector<qint64> > newList)
@@ -297,9 +275,44 @@ bool FtmwConfig::addFids(const QByteArray rawData)
     else
         return setFidsData(ps_gpu->parseAndAdd(rawData.constData(),d_currentShift));
 #else
-    if(newList.isEmpty())
-        newList = parseWaveform(rawData);
-    return p_fidStorage->addFids(newList,d_currentShift);
+    if(!ps_cpu)
+        return false;
+    if(!p_fidStorage->addFids(rawData,*ps_cpu,d_fidTemplate,d_currentShift))
+    {
+        d_errorString = ps_cpu->getErrorString();
+        return false;
+    }
+    return true;
+#endif
+}
+
+bool FtmwConfig::addFids(const FidList &l)
+{
+    //used for shots that were already decoded and summed (e.g., coalesced by the ShotQueue).
+    //These bypass chirp scoring, and are added without a phase correction shift
+    d_errorString.clear();
+#ifdef BC_CUDA
+    Q_UNUSED(l)
+    d_errorString = QString("Adding decoded FIDs is not supported with GPU averaging.");
+    return false;
+#else
+    if(l.size() != d_scopeConfig.d_numRecords)
+    {
+        d_errorString = QString("Could not add FIDs: expected %1 records, got %2.").arg(d_scopeConfig.d_numRecords).arg(l.size());
+        return false;
+    }
+
+    FidList out;
+    out.reserve(l.size());
+    for(auto &f : l)
+    {
+        auto n = d_fidTemplate;
+        n.setData(f.rawData());
+        n.setShots(f.shots());
+        out.append(n);
+    }
+
+    return p_fidStorage->addFids(out);
 #endif
 }
 
@@ -331,6 +344,8 @@ void FtmwConfig::cleanupAndSave()
     p_fidStorage->save();
 #ifdef BC_CUDA
     ps_gpu.reset();
+#else
+    ps_cpu.reset();
 #endif
 }
 
@@ -359,8 +374,14 @@ bool FtmwConfig::preprocessChirp(const FidList l)
     if(r.first < 0 || r.second <= 0)
         return true;
 
-    auto newChirp = l.constFirst().rawData().mid(r.first,r.second);
-    auto avgChirp = fl.constFirst().rawData().mid(r.first,r.second);
+    auto chirpSpan = [r](const Fid &f) -> DataSpan<qint64> {
+        auto s = f.rawSpan();
+        if(r.first >= s.size())
+            return {};
+        return {s.data()+r.first,qMin(r.second,s.size()-r.first)};
+    };
+    auto newChirp = chirpSpan(l.constFirst());
+    auto avgChirp = chirpSpan(fl.constFirst());
 
     if(newChirp.isEmpty() || avgChirp.isEmpty())
         return true;
@@ -450,7 +471,7 @@ bool FtmwConfig::preprocessChirp(const FidList l)
 
 }
 
-float FtmwConfig::calculateFom(const QVector<qint64> vec, const Fid fid, QPair<int, int> range, int trialShift)
+float FtmwConfig::calculateFom(const DataSpan<qint64> vec, const Fid &fid, QPair<int, int> range, int trialShift)
 {
     //Kahan summation (32 bit precision is sufficient)
     float sum = 0.0;
@@ -459,7 +480,7 @@ float FtmwConfig::calculateFom(const QVector<qint64> vec, const Fid fid, QPair<i
     {
         if(i+range.first+trialShift >= 0 && i+range.first+trialShift < fid.size())
         {
-            float dat = static_cast<float>(fid.atRaw(i+range.first+trialShift))*(static_cast<float>(vec.at(i)));
+            float dat = static_cast<float>(fid.atRaw(i+range.first+trialShift))*(static_cast<float>(vec[i]));
             float y = dat - c;
             float t = sum + y;
             c = (t-sum) - y;
@@ -470,14 +491,14 @@ float FtmwConfig::calculateFom(const QVector<qint64> vec, const Fid fid, QPair<i
     return sum/static_cast<float>(fid.shots());
 }
 
-double FtmwConfig::calculateChirpRMS(const QVector<qint64> chirp, quint64 shots)
+double FtmwConfig::calculateChirpRMS(const DataSpan<qint64> chirp, quint64 shots)
 {
     //Kahan summation
     double sum = 0.0;
     double c = 0.0;
     for(int i=0; i<chirp.size(); i++)
     {
-        double dat = static_cast<double>(chirp.at(i)*chirp.at(i))/static_cast<double>(shots*shots);
+        double dat = static_cast<double>(chirp[i]*chirp[i])/static_cast<double>(shots*shots);
         double y = dat - c;
         double t = sum + y;
         c = (t-sum) - y;
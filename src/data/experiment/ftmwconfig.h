@@ -14,6 +14,8 @@
 
 #ifdef BC_CUDA
 #include <modules/cuda/gpuaverager.h>
+#else
+#include <data/analysis/cpuaverager.h>
 #endif
 
 namespace BC::Store::FTMW {
@@ -67,6 +69,27 @@ public:
 
     bool initialize() override;
     bool advance() override;
+
+    /*!
+     * \brief Starts a move to the next clock step, if the current segment is finished
+     *
+     * Processing is paused and the RfConfig is stepped, so the new clock settings are available
+     * immediately. The outgoing segment is not saved and the incoming one is not loaded until
+     * finishSegmentTransition() is called, which lets the caller start retuning the clocks first.
+     * advance() performs both steps back to back.
+     *
+     * \return bool True if a transition was started
+     */
+    bool beginSegmentTransition();
+    void finishSegmentTransition();
+
+    /*!
+     * \brief Saves the current segment if the autosave interval has elapsed
+     *
+     * advance() calls this when no segment transition is due. Callers that add several shots
+     * before advancing can call it once for the group instead.
+     */
+    void autosave();
     void hwReady() override;
     bool abort() override;
     virtual void cleanupAndSave() override;
@@ -76,7 +99,7 @@ public:
     virtual quint64 completedShots() const =0;
 
     quint64 shotIncrement() const;
-    FidList parseWaveform(const QByteArray b) const;
+    FidList parseWaveform(const QByteArray b);
     double ftMinMHz() const;
     double ftMaxMHz() const;
     double ftNyquistMHz() const;
@@ -101,10 +124,12 @@ public:
 
     bool setFidsData(const QVector<QVector<qint64> > newList);
     bool addFids(const QByteArray rawData);
+    bool addFids(const FidList &l);
     void setScopeConfig(const FtmwDigitizerConfig &other);
     std::shared_ptr<FidStorageBase> storage() const;
 
     void loadFids();
+    virtual quint8 bitShift() const { return 0; }
 
 private:
     std::shared_ptr<FidStorageBase> p_fidStorage;
@@ -113,13 +138,16 @@ private:
     int d_currentShift{0};
     float d_lastFom{0.0};
     double d_lastRMS{0.0};
+    FidArena d_parseArena;
 
     bool preprocessChirp(const FidList l);
-    float calculateFom(const QVector<qint64> vec, const Fid fid, QPair<int,int> range, int trialShift);
-    double calculateChirpRMS(const QVector<qint64> chirp, quint64 shots = 1);
+    float calculateFom(const DataSpan<qint64> vec, const Fid &fid, QPair<int,int> range, int trialShift);
+    double calculateChirpRMS(const DataSpan<qint64> chirp, quint64 shots = 1);
 
 #ifdef BC_CUDA
     std::shared_ptr<GpuAverager> ps_gpu;
+#else
+    std::shared_ptr<CpuAverager> ps_cpu;
 #endif
 
     // HeaderStorage interface
@@ -130,7 +158,6 @@ protected:
     QString objectiveKey() const override;
     QVariant objectiveData() const override;
 
-    virtual quint8 bitShift() const { return 0; }
     virtual bool _init() =0;
     virtual void _prepareToSave() =0;
     virtual void _loadComplete() =0;
@@ -2,6 +2,11 @@
 
 #include <data/storage/blackchirpcsv.h>
 
+#include <QMutex>
+
+//hardware objects register their keys concurrently while being prepared for an experiment
+static QMutex s_registerMutex;
+
 AuxDataStorage::AuxDataStorage(BlackchirpCSV *csv, int number, const QString path) : d_number(number), d_path(path)
 {
     auto d = BlackchirpCSV::exptDir(number,path);
@@ -40,12 +45,14 @@ AuxDataStorage::AuxDataStorage(BlackchirpCSV *csv, int number, const QString pat
 void AuxDataStorage::registerKey(const QString objKey, const QString key)
 {
     auto k = BC::Aux::keyTemplate.arg(objKey).arg(key);
+    QMutexLocker l(&s_registerMutex);
     d_allowedKeys.insert(makeKey(objKey,key));
 }
 
 void AuxDataStorage::registerKey(const QString hwKey, const QString hwSubKey, const QString key)
 {
     auto k = BC::Aux::hwKeyTemplate.arg(hwKey).arg(hwSubKey).arg(key);
+    QMutexLocker l(&s_registerMutex);
     d_allowedKeys.insert(makeKey(hwKey,hwSubKey,key));
 }
 
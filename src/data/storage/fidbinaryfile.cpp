@@ -0,0 +1,280 @@
+#include "fidbinaryfile.h"
+
+#include <QFile>
+#include <QtEndian>
+#include <cstring>
+#include <limits>
+
+static const char magic[8] = {'B','C','F','I','D','\0','\0','\0'};
+
+bool FidBinaryFile::write(QIODevice &device, const FidList l, bool checksums, int compressionLevel)
+{
+    if(l.isEmpty())
+        return false;
+
+    qint64 numPoints = 0;
+    for(auto &f : l)
+        numPoints = qMax(numPoints,static_cast<qint64>(f.size()));
+
+    bool compress = compressionLevel > 0;
+    quint32 numFids = l.size();
+    quint32 blockPoints = defaultBlockPoints;
+    qint64 blocksPerFid = (numPoints + blockPoints - 1)/blockPoints;
+    qint64 numBlocks = blocksPerFid*numFids;
+    qint64 csBytes = checksums ? numBlocks*sizeof(quint64) : 0;
+
+    //columns shorter than numPoints are zero-padded
+    QVector<QVector<qint64>> cols;
+    cols.reserve(numFids);
+    for(auto &f : l)
+    {
+        cols << f.rawData();
+        if(cols.last().size() < numPoints)
+            cols.last().resize(numPoints);
+    }
+
+    QByteArray out;
+    QVector<QByteArray> blocks;
+    if(compress)
+    {
+        blocks.reserve(numBlocks);
+        qint64 payloadBytes = 0;
+        for(quint32 i=0; i<numFids; ++i)
+        {
+            for(qint64 b=0; b<blocksPerFid; ++b)
+            {
+                auto first = b*blockPoints;
+                auto n = qMin(static_cast<qint64>(blockPoints),numPoints-first);
+                QByteArray raw;
+                encodeBlock(cols.at(i).constData()+first,n,raw);
+                blocks << qCompress(raw,qMin(compressionLevel,9));
+                payloadBytes += blocks.last().size();
+            }
+        }
+
+        out = QByteArray(headerSize + (numBlocks+1)*sizeof(quint64) + csBytes + payloadBytes,'\0');
+    }
+    else
+        out = QByteArray(headerSize + numPoints*numFids*sizeof(qint64) + csBytes,'\0');
+
+    auto p = out.data();
+    quint32 flags = (checksums ? Checksums : 0) | (compress ? Compressed : 0);
+    memcpy(p,magic,sizeof(magic));
+    qToLittleEndian<quint32>(compress ? 2 : 1,p+8);
+    qToLittleEndian<quint32>(flags,p+12);
+    qToLittleEndian<quint32>(numFids,p+16);
+    qToLittleEndian<quint32>(blockPoints,p+20);
+    qToLittleEndian<qint64>(numPoints,p+24);
+
+    char *cs = nullptr;
+    if(compress)
+    {
+        auto offsets = p + headerSize;
+        cs = offsets + (numBlocks+1)*sizeof(quint64);
+        auto payload = cs + csBytes;
+        quint64 pos = 0;
+        for(qint64 b=0; b<numBlocks; ++b)
+        {
+            qToLittleEndian<quint64>(pos,offsets + b*sizeof(quint64));
+            memcpy(payload+pos,blocks.at(b).constData(),blocks.at(b).size());
+            pos += blocks.at(b).size();
+        }
+        qToLittleEndian<quint64>(pos,offsets + numBlocks*sizeof(quint64));
+    }
+    else
+    {
+        auto dat = p + headerSize;
+        for(quint32 i=0; i<numFids; ++i)
+            qToLittleEndian<qint64>(cols.at(i).constData(),numPoints,dat + i*numPoints*sizeof(qint64));
+        cs = dat + numPoints*numFids*sizeof(qint64);
+    }
+
+    if(checksums)
+    {
+        for(quint32 i=0; i<numFids; ++i)
+        {
+            for(qint64 b=0; b<blocksPerFid; ++b)
+            {
+                auto first = b*blockPoints;
+                auto n = qMin(static_cast<qint64>(blockPoints),numPoints-first);
+                qToLittleEndian<quint64>(checksum(cols.at(i).constData()+first,n),
+                                         cs + (i*blocksPerFid + b)*sizeof(quint64));
+            }
+        }
+    }
+
+    return device.write(out) == out.size();
+}
+
+FidList FidBinaryFile::read(QFile &f, const Fid &fidTemplate, bool verify, QString *errStr)
+{
+    FidList out;
+    auto setErr = [errStr,&f](const QString msg) {
+        if(errStr)
+            *errStr = QString("Could not read %1: %2").arg(f.fileName(),msg);
+    };
+
+    if(!f.isOpen() && !f.open(QIODevice::ReadOnly))
+    {
+        setErr(f.errorString());
+        return out;
+    }
+
+    auto size = f.size();
+    if(size < headerSize)
+    {
+        setErr("File is too small.");
+        return out;
+    }
+
+    auto p = reinterpret_cast<const char*>(f.map(0,size));
+    if(!p)
+    {
+        setErr(f.errorString());
+        return out;
+    }
+
+    quint32 ver = qFromLittleEndian<quint32>(p+8);
+    quint32 flags = qFromLittleEndian<quint32>(p+12);
+    quint32 numFids = qFromLittleEndian<quint32>(p+16);
+    quint32 blockPoints = qFromLittleEndian<quint32>(p+20);
+    qint64 numPoints = qFromLittleEndian<qint64>(p+24);
+
+    bool hasCs = flags & Checksums;
+    bool compressed = flags & Compressed;
+    qint64 blocksPerFid = blockPoints > 0 ? (numPoints + blockPoints - 1)/blockPoints : 0;
+    qint64 numBlocks = blocksPerFid*numFids;
+    qint64 csBytes = hasCs ? numBlocks*sizeof(quint64) : 0;
+
+    const char *offsets = nullptr, *payload = nullptr, *dat = nullptr, *cs = nullptr;
+    qint64 minSize = 0;
+    if(compressed)
+    {
+        offsets = p + headerSize;
+        cs = offsets + (numBlocks+1)*sizeof(quint64);
+        payload = cs + csBytes;
+        minSize = headerSize + (numBlocks+1)*sizeof(quint64) + csBytes;
+        if(size >= minSize)
+            minSize += qFromLittleEndian<quint64>(offsets + numBlocks*sizeof(quint64));
+    }
+    else
+    {
+        dat = p + headerSize;
+        cs = dat + numPoints*numFids*sizeof(qint64);
+        minSize = headerSize + numPoints*numFids*sizeof(qint64) + csBytes;
+    }
+
+    if(memcmp(p,magic,sizeof(magic)) != 0 || ver > version)
+        setErr("Unrecognized file format.");
+    else if(numPoints < 0 || blockPoints == 0 || size < minSize)
+        setErr("File is truncated or has an invalid header.");
+    else
+    {
+        //decode (or copy) each block straight into the Fid's storage
+        out.reserve(numFids);
+        for(quint32 i=0; i<numFids; ++i)
+        {
+            QVector<qint64> d(numPoints);
+            auto dp = d.data();
+            bool ok = true;
+            for(qint64 b=0; ok && b<blocksPerFid; ++b)
+            {
+                auto first = b*blockPoints;
+                auto n = qMin(static_cast<qint64>(blockPoints),numPoints-first);
+                auto idx = i*blocksPerFid + b;
+                if(compressed)
+                {
+                    auto start = qFromLittleEndian<quint64>(offsets + idx*sizeof(quint64));
+                    auto end = qFromLittleEndian<quint64>(offsets + (idx+1)*sizeof(quint64));
+                    ok = end >= start && payload + end <= p + size
+                            && decodeBlock(payload+start,end-start,dp+first,n);
+                    if(!ok)
+                        setErr(QString("Corrupt data in FID %1 at point %2.").arg(i).arg(first));
+                }
+                else
+                    qFromLittleEndian<qint64>(dat + (i*numPoints + first)*sizeof(qint64),n,dp+first);
+
+                if(ok && verify && hasCs
+                        && qFromLittleEndian<quint64>(cs + idx*sizeof(quint64)) != checksum(dp+first,n))
+                {
+                    setErr(QString("Checksum mismatch in FID %1 at point %2.").arg(i).arg(first));
+                    ok = false;
+                }
+            }
+
+            if(!ok)
+            {
+                out.clear();
+                break;
+            }
+
+            out << fidTemplate;
+            out.last().setData(d);
+        }
+    }
+
+    f.unmap(const_cast<uchar*>(reinterpret_cast<const uchar*>(p)));
+    return out;
+}
+
+quint64 FidBinaryFile::checksum(const qint64 *data, qint64 points, quint64 h)
+{
+    //FNV-1a over 64-bit words, taken in little-endian (file) byte order
+    for(qint64 i=0; i<points; ++i)
+        h = (h ^ qToLittleEndian(static_cast<quint64>(data[i])))*0x100000001b3ull;
+
+    return h;
+}
+
+void FidBinaryFile::encodeBlock(const qint64 *data, qint64 points, QByteArray &out)
+{
+    //worst case is 10 bytes per point
+    out.resize(points*10);
+    auto o = reinterpret_cast<quint8*>(out.data());
+    qint64 pos = 0;
+    quint64 prev = 0;
+    for(qint64 i=0; i<points; ++i)
+    {
+        //unsigned arithmetic so that the delta wraps instead of overflowing
+        quint64 d = static_cast<quint64>(data[i]) - prev;
+        prev = static_cast<quint64>(data[i]);
+        quint64 z = (d << 1) ^ static_cast<quint64>(static_cast<qint64>(d) >> 63);
+        while(z >= 0x80)
+        {
+            o[pos++] = static_cast<quint8>(z) | 0x80;
+            z >>= 7;
+        }
+        o[pos++] = static_cast<quint8>(z);
+    }
+    out.resize(pos);
+}
+
+bool FidBinaryFile::decodeBlock(const char *in, qint64 bytes, qint64 *data, qint64 points)
+{
+    if(bytes > std::numeric_limits<int>::max())
+        return false;
+
+    auto raw = qUncompress(reinterpret_cast<const uchar*>(in),static_cast<int>(bytes));
+    auto r = reinterpret_cast<const quint8*>(raw.constData());
+    qint64 n = raw.size(), pos = 0;
+    quint64 prev = 0;
+    for(qint64 i=0; i<points; ++i)
+    {
+        quint64 z = 0;
+        int shift = 0;
+        while(true)
+        {
+            if(pos >= n || shift > 63)
+                return false;
+            auto c = r[pos++];
+            z |= static_cast<quint64>(c & 0x7f) << shift;
+            if(!(c & 0x80))
+                break;
+            shift += 7;
+        }
+        prev += (z >> 1) ^ (~(z & 1) + 1);
+        data[i] = static_cast<qint64>(prev);
+    }
+
+    return pos == n;
+}
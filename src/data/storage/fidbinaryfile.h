@@ -0,0 +1,81 @@
+#ifndef FIDBINARYFILE_H
+#define FIDBINARYFILE_H
+
+#include <QString>
+#include <QIODevice>
+
+#include <data/experiment/fid.h>
+
+class QFile;
+
+namespace BC::Key::FidStorage {
+static const QString key{"FidStorage"};
+static const QString format{"format"};
+static const QString checksums{"checksums"};
+static const QString compressionLevel{"compressionLevel"};
+static const QString syncPolicy{"syncPolicy"};
+static const QString writeQueueSize{"writeQueueSize"};
+static const QString cacheMB{"cacheMB"};
+static const QString prefetchDepth{"prefetchDepth"};
+}
+
+namespace BC::CSV {
+static const QString fidBinExt{"bcfid"};
+}
+
+/*!
+ * \brief Reads and writes the binary FID container (.bcfid)
+ *
+ * The file consists of a fixed 64-byte header, followed by the raw FID sums stored as
+ * little-endian int64 columns (one contiguous column per FID in the list, each padded to the
+ * length of the longest FID), optionally followed by one 64-bit checksum per block of
+ * blockPoints points in each column. All header fields are little-endian.
+ *
+ * | Offset | Type    | Field                                               |
+ * |--------|---------|-----------------------------------------------------|
+ * | 0      | char[8] | Magic ("BCFID" followed by 3 null bytes)            |
+ * | 8      | quint32 | Format version                                      |
+ * | 12     | quint32 | Flags (bit 0: checksums present, bit 1: compressed) |
+ * | 16     | quint32 | Number of FIDs                                      |
+ * | 20     | quint32 | Block size (points)                                 |
+ * | 24     | qint64  | Number of points per FID                            |
+ * | 32     | -       | Reserved (zero)                                     |
+ *
+ * In a compressed file (version 2), the header is followed by a table of numBlocks+1 quint64
+ * payload offsets, then the checksums (if present), then the payload. Each block is coded
+ * independently: the points are delta coded (starting from 0 at the beginning of the block),
+ * zigzag mapped, written as LEB128 varints, and the varint stream is deflated with qCompress.
+ * Averaged FIDs are smooth, so most deltas fit in one or two bytes before deflate. Blocks are
+ * decoded one at a time directly into each Fid's storage. Checksums always refer to the
+ * uncompressed little-endian data, so they are independent of the coding.
+ *
+ * The file is assembled in memory and written with a single write() call. Reads map the file
+ * with QFile::map, so the only copy is the one into each Fid's storage.
+ *
+ * The metadata needed to interpret the sums (spacing, vMult, shots, etc) is not stored here;
+ * it is kept in the segment index (see FidIndexFile) and mirrored in fidparams.csv.
+ */
+class FidBinaryFile
+{
+public:
+    enum Flag {
+        Checksums = 0x1,
+        Compressed = 0x2
+    };
+
+    static constexpr quint32 version{2};
+    static constexpr int headerSize{64};
+    static constexpr quint32 defaultBlockPoints{1 << 16};
+
+    static bool write(QIODevice &device, const FidList l, bool checksums = true, int compressionLevel = 0);
+    static FidList read(QFile &f, const Fid &fidTemplate, bool verify = true, QString *errStr = nullptr);
+
+    //pass the result of a previous call as h to continue a checksum over another block
+    static quint64 checksum(const qint64 *data, qint64 points, quint64 h = 0xcbf29ce484222325ull);
+
+private:
+    static void encodeBlock(const qint64 *data, qint64 points, QByteArray &out);
+    static bool decodeBlock(const char *in, qint64 bytes, qint64 *data, qint64 points);
+};
+
+#endif // FIDBINARYFILE_H
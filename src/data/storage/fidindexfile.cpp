@@ -0,0 +1,100 @@
+#include "fidindexfile.h"
+
+#include <QFile>
+#include <QtEndian>
+#include <cstring>
+
+#include <data/storage/fidbinaryfile.h>
+
+static const char magic[8] = {'B','C','F','I','D','X','\0','\0'};
+
+QString FidIndexFile::Record::fileName(int index) const
+{
+    return QString("%1.%2").arg(index).arg(binary ? BC::CSV::fidBinExt : QString("csv"));
+}
+
+bool FidIndexFile::writeRecord(const QString &path, int index, const Record &r)
+{
+    if(index < 0)
+        return false;
+
+    QFile f(path);
+    if(!f.open(QIODevice::ReadWrite))
+        return false;
+
+    if(f.size() < headerSize)
+    {
+        char hdr[headerSize] = {0};
+        memcpy(hdr,magic,sizeof(magic));
+        qToLittleEndian<quint32>(version,hdr+8);
+        qToLittleEndian<quint32>(recordSize,hdr+12);
+        if(f.write(hdr,headerSize) != headerSize)
+            return false;
+    }
+
+    qint64 words[recordSize/8];
+    auto &t = r.fidTemplate;
+    double d[3] = {t.spacing(),t.probeFreq(),t.vMult()};
+    memcpy(words,d,sizeof(d));
+    words[3] = static_cast<qint64>(t.shots());
+    words[4] = static_cast<qint64>(t.sideband());
+    words[5] = r.size;
+    words[6] = r.binary ? 1 : 0;
+    words[7] = static_cast<qint64>(FidBinaryFile::checksum(words,7));
+
+    char rec[recordSize];
+    qToLittleEndian<qint64>(words,recordSize/8,rec);
+
+    //seeking past the end leaves a gap of zeros, which fails the checksum
+    if(!f.seek(headerSize + static_cast<qint64>(index)*recordSize))
+        return false;
+
+    return f.write(rec,recordSize) == recordSize;
+}
+
+bool FidIndexFile::readRecord(const QString &path, int index, Record &out)
+{
+    if(index < 0)
+        return false;
+
+    QFile f(path);
+    if(!f.open(QIODevice::ReadOnly))
+        return false;
+
+    char hdr[headerSize];
+    if(f.read(hdr,headerSize) != headerSize || memcmp(hdr,magic,sizeof(magic)) != 0
+            || qFromLittleEndian<quint32>(hdr+8) > version
+            || qFromLittleEndian<quint32>(hdr+12) != recordSize)
+        return false;
+
+    char rec[recordSize];
+    if(!f.seek(headerSize + static_cast<qint64>(index)*recordSize) || f.read(rec,recordSize) != recordSize)
+        return false;
+
+    qint64 words[recordSize/8];
+    qFromLittleEndian<qint64>(rec,recordSize/8,words);
+    if(static_cast<quint64>(words[7]) != FidBinaryFile::checksum(words,7))
+        return false;
+
+    double d[3];
+    memcpy(d,words,sizeof(d));
+    out.fidTemplate = Fid();
+    out.fidTemplate.setSpacing(d[0]);
+    out.fidTemplate.setProbeFreq(d[1]);
+    out.fidTemplate.setVMult(d[2]);
+    out.fidTemplate.setShots(static_cast<quint64>(words[3]));
+    out.fidTemplate.setSideband(static_cast<RfConfig::Sideband>(words[4]));
+    out.size = static_cast<int>(words[5]);
+    out.binary = words[6] != 0;
+
+    return true;
+}
+
+int FidIndexFile::count(const QString &path)
+{
+    QFile f(path);
+    if(!f.exists() || f.size() < headerSize)
+        return 0;
+
+    return static_cast<int>((f.size() - headerSize)/recordSize);
+}
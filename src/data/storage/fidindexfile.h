@@ -0,0 +1,56 @@
+#ifndef FIDINDEXFILE_H
+#define FIDINDEXFILE_H
+
+#include <QString>
+
+#include <data/experiment/fid.h>
+
+namespace BC::CSV {
+static const QString fidIndex{"fidparams.bcidx"};
+}
+
+/*!
+ * \brief Fixed-width binary index of the FID segments in an experiment
+ *
+ * The index holds the same information as fidparams.csv, but each segment has a fixed-size
+ * record at a known offset, so saving a segment rewrites only its own record and looking up a
+ * segment is a single seek and read. All fields are little-endian.
+ *
+ * The file begins with a 16-byte header (magic "BCFIDX" followed by 2 null bytes, then quint32
+ * version and quint32 record size), followed by one 64-byte record per index:
+ *
+ * | Offset | Type    | Field                                          |
+ * |--------|---------|------------------------------------------------|
+ * | 0      | double  | Spacing (s)                                    |
+ * | 8      | double  | Probe frequency (MHz)                          |
+ * | 16     | double  | vMult                                          |
+ * | 24     | quint64 | Shots                                          |
+ * | 32     | qint64  | Sideband                                       |
+ * | 40     | qint64  | Size (points)                                  |
+ * | 48     | qint64  | Data file format (0 = csv, 1 = bcfid)          |
+ * | 56     | quint64 | FNV-1a checksum of the preceding 7 fields      |
+ *
+ * Records that have never been written (or were only partially written) fail the checksum and
+ * are treated as missing.
+ */
+class FidIndexFile
+{
+public:
+    struct Record {
+        Fid fidTemplate;
+        int size{0};
+        bool binary{true};
+
+        QString fileName(int index) const;
+    };
+
+    static constexpr quint32 version{1};
+    static constexpr int headerSize{16};
+    static constexpr int recordSize{64};
+
+    static bool writeRecord(const QString &path, int index, const Record &r);
+    static bool readRecord(const QString &path, int index, Record &out);
+    static int count(const QString &path);
+};
+
+#endif // FIDINDEXFILE_H
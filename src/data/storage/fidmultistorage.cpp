@@ -2,6 +2,7 @@
 
 #include <QMutexLocker>
 #include <data/storage/blackchirpcsv.h>
+#include <data/storage/fidbinaryfile.h>
 
 FidMultiStorage::FidMultiStorage(int numRecords, int num, QString path) :
     FidStorageBase(numRecords,num,path)
@@ -11,7 +12,7 @@ FidMultiStorage::FidMultiStorage(int numRecords, int num, QString path) :
     if(d.exists(BC::CSV::fidDir))
     {
         d.cd(BC::CSV::fidDir);
-        auto entries = d.entryList({"*.csv"});
+        auto entries = d.entryList({"*.csv",QString("*.%1").arg(BC::CSV::fidBinExt)});
         for(auto entry : entries)
         {
             auto num = entry.split('.').first().toInt();
@@ -27,14 +28,36 @@ int FidMultiStorage::getCurrentIndex()
     return d_currentSegment;
 }
 
+void FidMultiStorage::start()
+{
+    FidStorageBase::start();
+    prefetchAhead(getCurrentIndex());
+}
+
 void FidMultiStorage::_advance()
 {
     pu_mutex->lock();
     auto nextSegment = (d_currentSegment + 1) % d_numSegments;
     pu_mutex->unlock();
+
+    //normally already in the cache from the prefetch issued at the previous step
     auto fl = loadFidList(nextSegment);
 
     QMutexLocker l(pu_mutex.get());
+    waitForMerge();
     d_currentSegment = nextSegment;
     d_currentFidList = fl;
+    l.unlock();
+
+    prefetchAhead(nextSegment);
+}
+
+void FidMultiStorage::prefetchAhead(int segment)
+{
+    //segments are visited in clock step order, wrapping around at the end of each sweep
+    if(d_numSegments < 2)
+        return;
+
+    for(int k=1; k<=qMin(d_prefetchDepth,d_numSegments-1); ++k)
+        prefetch((segment + k) % d_numSegments);
 }
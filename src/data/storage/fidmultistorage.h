@@ -15,11 +15,14 @@ public:
 
     // FidStorageBase interface
     int getCurrentIndex() override;
+    void start() override;
 
 protected:
     void _advance() override;
 
 private:
+    void prefetchAhead(int segment);
+
     int d_currentSegment{0};
     int d_numSegments{0};
 };
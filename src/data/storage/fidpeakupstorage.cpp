@@ -1,5 +1,8 @@
 #include "fidpeakupstorage.h"
 
+#include <data/analysis/cpuaverager.h>
+#include <data/analysis/analysis.h>
+
 FidPeakUpStorage::FidPeakUpStorage(int numRecords) :
     FidStorageBase(numRecords)
 {
@@ -12,23 +15,38 @@ FidPeakUpStorage::~FidPeakUpStorage()
 
 bool FidPeakUpStorage::addFids(const FidList other, int shift)
 {
-    QMutexLocker l(pu_mutex.get());
-    if(d_currentFidList.isEmpty())
-        d_currentFidList = other;
+    auto ts = targetShots();
+    auto fl = takeCurrentFidList();
+    bool ok = true;
+    if(fl.isEmpty())
+        fl = other;
+    else if(other.size() != fl.size())
+        ok = false;
     else
     {
-        if(other.size() != d_currentFidList.size())
-            return false;
-        for(int i=0; i<d_currentFidList.size(); i++)
-            d_currentFidList[i].rollingAverage(other.at(i),d_targetShots,shift);
+        auto p = fl.data();
+        Analysis::parallelFor(fl.size(),[p,&other,ts,shift](int i){
+            p[i].rollingAverage(other.at(i),ts,shift);
+        });
     }
 
-    return true;
+    restoreCurrentFidList(fl);
+    return ok;
+}
+
+bool FidPeakUpStorage::addFids(const QByteArray rawData, const CpuAverager &avg, const Fid &fidTemplate, int shift)
+{
+    auto ts = targetShots();
+    auto fl = takeCurrentFidList();
+    bool ok = avg.parseAndRollAvg(rawData.constData(),rawData.size(),fl,fidTemplate,ts,shift);
+    restoreCurrentFidList(fl);
+    return ok;
 }
 
 void FidPeakUpStorage::reset()
 {
     QMutexLocker l(pu_mutex.get());
+    waitForMerge();
     d_currentFidList.clear();
 }
 
@@ -52,6 +70,7 @@ quint64 FidPeakUpStorage::targetShots() const
 bool FidPeakUpStorage::setFidsData(const FidList other)
 {
     QMutexLocker l(pu_mutex.get());
+    waitForMerge();
     if(!d_currentFidList.isEmpty() && (other.size() != d_currentFidList.size()))
         return false;
 
@@ -13,6 +13,7 @@ public:
 
     // FidStorageBase interface
     bool addFids(const FidList other, int shift) override;
+    bool addFids(const QByteArray rawData, const CpuAverager &avg, const Fid &fidTemplate, int shift) override;
     int getCurrentIndex() override;
     bool setFidsData(const FidList other) override;
 
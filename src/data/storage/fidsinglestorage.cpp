@@ -2,6 +2,7 @@
 
 #include <QMutexLocker>
 #include <data/storage/blackchirpcsv.h>
+#include <data/storage/fidbinaryfile.h>
 
 FidSingleStorage::FidSingleStorage(int numRecords, int num, QString path) : FidStorageBase(numRecords,num,path)
 {
@@ -10,7 +11,7 @@ FidSingleStorage::FidSingleStorage(int numRecords, int num, QString path) : FidS
     if(d.exists(BC::CSV::fidDir))
     {
         d.cd(BC::CSV::fidDir);
-        auto entries = d.entryList({"*.csv"});
+        auto entries = d.entryList({"*.csv",QString("*.%1").arg(BC::CSV::fidBinExt)});
         for(auto entry : entries)
         {
             auto num = entry.split('.').first().toInt();
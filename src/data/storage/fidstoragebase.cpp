@@ -1,17 +1,61 @@
 #include "fidstoragebase.h"
 
 #include <QSaveFile>
+#include <QFile>
 #include <QDir>
+#include <QFileInfo>
+#include <QThreadPool>
+#include <cstdio>
 #include <data/storage/blackchirpcsv.h>
+#include <data/storage/fidbinaryfile.h>
+#include <data/storage/fidwriter.h>
+#include <data/storage/fidindexfile.h>
+#include <data/storage/settingsstorage.h>
+#include <data/analysis/cpuaverager.h>
+#include <data/analysis/analysis.h>
 
 FidStorageBase::FidStorageBase(int numRecords, int number, QString path) :
     DataStorageBase(number,path), d_numRecords(numRecords)
 {
     pu_baseMutex = std::make_unique<QMutex>();
+
+    //prefetch reads block on disk and on pu_mutex, so they get their own thread instead of
+    //occupying Analysis::workerPool(), which addFids relies on for shot processing
+    pu_prefetchPool = std::make_unique<QThreadPool>();
+    pu_prefetchPool->setMaxThreadCount(1);
+
+    using namespace BC::Key::FidStorage;
+    SettingsStorage s(key);
+    d_format = static_cast<FidFormat>(s.get<int>(format,Binary));
+    d_checksums = s.get<bool>(checksums,true);
+    d_compressionLevel = qBound(1,s.get<int>(compressionLevel,1),9);
+    d_syncPolicy = static_cast<SyncPolicy>(s.get<int>(syncPolicy,SyncEachWrite));
+    d_cacheBudget = static_cast<std::size_t>(qMax(0,s.get<int>(cacheMB,256))) << 20;
+    d_prefetchDepth = qBound(0,s.get<int>(prefetchDepth,1),16);
+
+    pu_writer = std::make_unique<FidWriter>([this](const FidList &l, int i){ return writeFidList(l,i); },
+                                            qBound(1,s.get<int>(writeQueueSize,4),64));
 }
 
 FidStorageBase::~FidStorageBase()
 {
+    //finish any outstanding reads and writes while the rest of the object is still valid
+    QMutexLocker l(pu_baseMutex.get());
+    while(!d_prefetching.empty())
+        d_prefetchDone.wait(pu_baseMutex.get());
+    l.unlock();
+
+    pu_prefetchPool->waitForDone();
+    pu_writer.reset();
+}
+
+bool FidStorageBase::flush()
+{
+    bool ok = pu_writer->flush();
+    if(d_indexDirty.exchange(false))
+        ok &= writeFidParamsCsv();
+
+    return ok;
 }
 
 void FidStorageBase::advance()
@@ -45,85 +89,170 @@ void FidStorageBase::finish()
 
 void FidStorageBase::saveFidList(const FidList l, int i)
 {
-    if(d_number < 1)
+    if(d_number < 1 || l.isEmpty())
         return;
 
+    //the list is implicitly shared, so this does not copy the data
+    pu_writer->enqueue(l,i);
+}
+
+bool FidStorageBase::writeFidList(const FidList &l, int i)
+{
     auto f = l.constFirst();
     f.setData({});
 
-    while(i > d_templateList.size())
-        d_templateList.push_back(Fid());
-    if(i == d_templateList.size())
-        d_templateList.push_back(f);
-    else
-        d_templateList[i] = f;
+    FidIndexFile::Record rec{f,l.constFirst().size(),d_format != Csv};
+    QString fileName = rec.fileName(i);
 
     QDir d{BlackchirpCSV::exptDir(d_number,d_path)};
     if(!d.cd(BC::CSV::fidDir))
     {
         if(!d.mkdir(BC::CSV::fidDir))
-            return;
+            return false;
         if(!d.cd(BC::CSV::fidDir))
-            return;
+            return false;
     }
 
-
-    QSaveFile hdr(d.absoluteFilePath(BC::CSV::fidparams));
-    if(!hdr.open(QIODevice::WriteOnly|QIODevice::Text))
-        return;
-
-    QTextStream txt(&hdr);
-    BlackchirpCSV::writeLine(txt,{"index","spacing","probefreq","vmult","shots","sideband","size"});
-    for(int idx=0; idx<d_templateList.size(); ++idx)
-    {
-        auto &f = d_templateList.at(idx);
-        BlackchirpCSV::writeLine(txt,{idx,f.spacing(),
-                                      f.probeFreq(),f.vMult(),f.shots(),f.sideband(),l.constFirst().size()});
-    }
+    //an index that could only be built in memory cannot be extended on disk
     QMutexLocker lock(pu_baseMutex.get());
-    bool success = hdr.commit();
+    if(!ensureIndex(d) || !d_legacyIndex.empty())
+        return false;
     lock.unlock();
-    if(!success)
-        return;
 
+    //with SyncEachWrite, QSaveFile syncs the file to disk before replacing the old one.
+    //NoSync writes a temporary file and renames it without waiting for the disk.
+    auto path = d.absoluteFilePath(fileName);
+    std::unique_ptr<QFileDevice> dat;
+    if(d_syncPolicy == SyncEachWrite)
+        dat = std::make_unique<QSaveFile>(path);
+    else
+        dat = std::make_unique<QFile>(path + ".tmp");
 
-    QSaveFile dat(d.absoluteFilePath("%1.csv").arg(i));
-    if(!dat.open(QIODevice::WriteOnly|QIODevice::Text))
-        return;
+    bool ok = false;
+    if(d_format != Csv)
+    {
+        if(dat->open(QIODevice::WriteOnly))
+            ok = FidBinaryFile::write(*dat,l,d_checksums,d_format == Compressed ? d_compressionLevel : 0);
+    }
+    else
+    {
+        if(dat->open(QIODevice::WriteOnly|QIODevice::Text))
+        {
+            BlackchirpCSV::writeFidList(*dat,l);
+            ok = dat->error() == QFileDevice::NoError;
+        }
+    }
 
-    BlackchirpCSV::writeFidList(dat,l);
+    if(d_syncPolicy == SyncEachWrite)
+    {
+        auto sf = static_cast<QSaveFile*>(dat.get());
+        if(!ok)
+            sf->cancelWriting();
+        ok = sf->commit();
+    }
+    else
+    {
+        dat->close();
+        ok &= dat->error() == QFileDevice::NoError;
+        if(ok)
+        {
+            //std::rename replaces the old file atomically on POSIX systems; fall back otherwise
+            ok = std::rename(QFile::encodeName(dat->fileName()).constData(),QFile::encodeName(path).constData()) == 0;
+            if(!ok)
+            {
+                QFile::remove(path);
+                ok = QFile::rename(dat->fileName(),path);
+            }
+        }
+        if(!ok)
+            QFile::remove(dat->fileName());
+    }
 
-    if(!dat.commit())
-        return;
+    if(!ok)
+        return false;
 
+    //the index record is written after the data, so it never refers to a file that is not there
     lock.relock();
+    if(!FidIndexFile::writeRecord(d.absoluteFilePath(BC::CSV::fidIndex),i,rec))
+        return false;
+    d_indexDirty = true;
     updateCache(l,i);
+    return true;
 
 }
 
 void FidStorageBase::updateCache(const FidList fl, int i)
 {
+    std::size_t bytes = 0;
+    for(auto &f : fl)
+        bytes += static_cast<std::size_t>(f.size())*sizeof(qint64);
+
     auto it = d_cache.find(i);
     if(it != d_cache.end())
-        it->second = fl;
+    {
+        d_cacheBytes -= it->second.bytes;
+        it->second.list = fl;
+        it->second.bytes = bytes;
+        d_lru.splice(d_lru.begin(),d_lru,it->second.lruPos);
+    }
     else
     {
-        std::size_t recSize = fl.constFirst().size()*fl.size();
-        if(!d_cache.empty() && (recSize * (d_cache.size() + 1) > d_maxCacheSize))
-        {
-            //remove an item from the cache
-            d_cache.erase(d_cacheKeys.front());
-            d_cacheKeys.pop();
-        }
+        d_lru.push_front(i);
+        d_cache.emplace(i,CacheEntry{fl,bytes,d_lru.begin()});
+    }
+    d_cacheBytes += bytes;
 
-        d_cacheKeys.push(i);
-        d_cache.emplace(i,fl);
+    //evict least recently used entries until the cache fits in its budget.
+    //An entry larger than the entire budget is not kept at all
+    while(d_cacheBytes > d_cacheBudget && !d_lru.empty())
+    {
+        auto e = d_cache.find(d_lru.back());
+        d_cacheBytes -= e->second.bytes;
+        d_cache.erase(e);
+        d_lru.pop_back();
+        d_cacheEvictions++;
     }
 }
 
+FidStorageBase::CacheStats FidStorageBase::cacheStats() const
+{
+    QMutexLocker lock(pu_baseMutex.get());
+    return {d_cacheHits,d_cacheMisses,d_cacheEvictions,d_cacheBytes,d_cacheBudget};
+}
+
+void FidStorageBase::prefetch(int i)
+{
+    if(d_number < 1 || i < 0)
+        return;
+
+    QMutexLocker lock(pu_baseMutex.get());
+    if(d_prefetching.count(i) || d_cache.count(i))
+        return;
+    d_prefetching.insert(i);
+    lock.unlock();
+
+    pu_prefetchPool->start([this,i](){
+        loadFidList(i,true);
+
+        QMutexLocker l(pu_baseMutex.get());
+        d_prefetching.erase(i);
+        d_prefetchDone.wakeAll();
+    });
+}
+
 FidList FidStorageBase::loadFidList(int i)
+{
+    return loadFidList(i,false);
+}
+
+FidList FidStorageBase::loadFidList(int i, bool prefetching)
 {
     QMutexLocker lock(pu_baseMutex.get());
+
+    //if this segment is already being read in the background, wait for it to land in the cache
+    while(!prefetching && d_prefetching.count(i))
+        d_prefetchDone.wait(pu_baseMutex.get());
+
     auto cs = getCurrentIndex();
     if(cs == i)
     {
@@ -134,62 +263,69 @@ FidList FidStorageBase::loadFidList(int i)
 
     FidList out;
 
+    //data waiting to be written are newer than anything on disk
+    if(pu_writer->pending(i,out))
+        return out;
+
     auto it = d_cache.find(i);
     if(it != d_cache.end())
     {
-        out = it->second;
+        out = it->second.list;
+        d_lru.splice(d_lru.begin(),d_lru,it->second.lruPos);
         //if we are no longer acquiring, we don't need to check
         //to make sure the cache is updated
         if(!d_acquiring)
+        {
+            d_cacheHits++;
             return out;
+        }
     }
 
     QDir d{BlackchirpCSV::exptDir(d_number,d_path)};
     d.cd(BC::CSV::fidDir);
 
-    bool found = false;
-    int size = 0;
-    Fid fidTemplate;
-
-    QFile hdr(d.absoluteFilePath(BC::CSV::fidparams));
-    if(!hdr.open(QIODevice::ReadOnly|QIODevice::Text))
+    FidIndexFile::Record rec;
+    if(!readIndex(d,i,rec))
         return out;
 
-    while(!hdr.atEnd())
-    {
-        auto l = pu_csv->readLine(hdr);
-        if(l.size() != 7)
-            continue;
-
-        bool ok = false;
-        int idx = l.constFirst().toInt(&ok);
-        if(ok)
-        {
-            if(idx != i)
-                continue;
-
-            found = true;
-            fidTemplate.setSpacing(l.at(1).toDouble());
-            fidTemplate.setProbeFreq(l.at(2).toDouble());
-            fidTemplate.setVMult(l.at(3).toDouble());
-            fidTemplate.setShots(l.at(4).toULongLong());
-            fidTemplate.setSideband(l.at(5).value<RfConfig::Sideband>());
-            size = l.at(6).toInt();
-        }
-    }
-    hdr.close();
+    auto &fidTemplate = rec.fidTemplate;
+    int size = rec.size;
+    QString fileName = rec.fileName(i);
 
-    if(!found)
-        return out;
+    //the data file is written with QSaveFile, so it can be read without holding the lock.
+    //This lets several segments be loaded concurrently (e.g., for sideband processing)
+    lock.unlock();
 
     //at this point, if out is not empty, then the FidList was found in the cache
     //If the number of shots in the fidTemplate matches the number of shots in
     //the fidlist, then the cache is up to date and we can return it without
     //re-reading the fid data from disk
     if(!out.isEmpty() && out.constFirst().shots() == fidTemplate.shots())
+    {
+        d_cacheHits++;
         return out;
+    }
+
+    d_cacheMisses++;
+
+    QFile fid(d.absoluteFilePath(fileName));
+    if(fileName.endsWith(BC::CSV::fidBinExt))
+    {
+        auto bl = FidBinaryFile::read(fid,fidTemplate);
+        if(bl.isEmpty())
+            return out;
+
+        for(auto &f : bl)
+        {
+            if(f.size() > size)
+                f.setData(f.rawData().mid(0,size));
+        }
+
+        lock.relock();
+        updateCache(bl,i);
+        return bl;
+    }
 
-    QFile fid(d.absoluteFilePath(QString("%1.csv").arg(i)));
     if(!fid.open(QIODevice::ReadOnly|QIODevice::Text))
         return out;
 
@@ -229,15 +365,139 @@ FidList FidStorageBase::loadFidList(int i)
 
     //at this point, we either need to update the cache or add this item to the cache
     if(!out.isEmpty())
+    {
+        lock.relock();
         updateCache(out,i);
+    }
 
     return out;
 
 }
 
+bool FidStorageBase::ensureIndex(const QDir &d)
+{
+    auto idxPath = d.absoluteFilePath(BC::CSV::fidIndex);
+    if(!d_legacyIndex.empty() || QFile::exists(idxPath))
+        return true;
+
+    //experiments saved before the index existed only have fidparams.csv; convert it
+    QFile hdr(d.absoluteFilePath(BC::CSV::fidparams));
+    if(!hdr.exists())
+        return true;
+    if(!hdr.open(QIODevice::ReadOnly|QIODevice::Text))
+        return false;
+
+    std::map<int,FidIndexFile::Record> records;
+    while(!hdr.atEnd())
+    {
+        //older experiments do not have the file column; those are always CSV
+        auto l = pu_csv->readLine(hdr);
+        if(l.size() != 7 && l.size() != 8)
+            continue;
+
+        bool isIdx = false;
+        int idx = l.constFirst().toInt(&isIdx);
+        if(!isIdx)
+            continue;
+
+        FidIndexFile::Record rec;
+        rec.fidTemplate.setSpacing(l.at(1).toDouble());
+        rec.fidTemplate.setProbeFreq(l.at(2).toDouble());
+        rec.fidTemplate.setVMult(l.at(3).toDouble());
+        rec.fidTemplate.setShots(l.at(4).toULongLong());
+        rec.fidTemplate.setSideband(l.at(5).value<RfConfig::Sideband>());
+        rec.size = l.at(6).toInt();
+        rec.binary = l.size() == 8 && l.at(7).toString().endsWith(BC::CSV::fidBinExt);
+        records.emplace(idx,rec);
+    }
+
+    //archived experiments may be on read-only media; the index is then kept in memory only.
+    //Otherwise it is written to a temporary file first so that an interrupted conversion is
+    //simply repeated
+    bool ok = QFileInfo(d.absolutePath()).isWritable();
+    if(ok)
+    {
+        auto tmpPath = idxPath + ".tmp";
+        QFile::remove(tmpPath);
+        for(auto it = records.cbegin(); ok && it != records.cend(); ++it)
+            ok = FidIndexFile::writeRecord(tmpPath,it->first,it->second);
+
+        if(!ok || !QFile::rename(tmpPath,idxPath))
+        {
+            QFile::remove(tmpPath);
+            ok = false;
+        }
+    }
+
+    if(!ok)
+        d_legacyIndex = std::move(records);
+
+    return true;
+}
+
+bool FidStorageBase::readIndex(const QDir &d, int i, FidIndexFile::Record &out)
+{
+    if(!ensureIndex(d))
+        return false;
+
+    auto it = d_legacyIndex.find(i);
+    if(it != d_legacyIndex.end())
+    {
+        out = it->second;
+        return true;
+    }
+
+    return FidIndexFile::readRecord(d.absoluteFilePath(BC::CSV::fidIndex),i,out);
+}
+
+bool FidStorageBase::writeFidParamsCsv()
+{
+    //regenerate the human-readable copy of the index
+    QDir d{BlackchirpCSV::exptDir(d_number,d_path)};
+    if(!d.cd(BC::CSV::fidDir))
+        return false;
+
+    QMutexLocker lock(pu_baseMutex.get());
+    auto idxPath = d.absoluteFilePath(BC::CSV::fidIndex);
+    QSaveFile hdr(d.absoluteFilePath(BC::CSV::fidparams));
+    if(!hdr.open(QIODevice::WriteOnly|QIODevice::Text))
+        return false;
+
+    QTextStream txt(&hdr);
+    BlackchirpCSV::writeLine(txt,{"index","spacing","probefreq","vmult","shots","sideband","size","file"});
+    int n = FidIndexFile::count(idxPath);
+    for(int idx=0; idx<n; ++idx)
+    {
+        FidIndexFile::Record rec;
+        if(!FidIndexFile::readRecord(idxPath,idx,rec))
+            continue;
+
+        auto &f = rec.fidTemplate;
+        BlackchirpCSV::writeLine(txt,{idx,f.spacing(),f.probeFreq(),f.vMult(),f.shots(),f.sideband(),
+                                      rec.size,rec.fileName(idx)});
+    }
+    txt.flush();
+
+    return hdr.commit();
+}
+
+bool FidStorageBase::exportCsv(int i, QIODevice &device)
+{
+    auto l = loadFidList(i);
+    if(l.isEmpty())
+        return false;
+
+    if(!device.isOpen() && !device.open(QIODevice::WriteOnly|QIODevice::Text))
+        return false;
+
+    BlackchirpCSV::writeFidList(device,l);
+    return true;
+}
+
 quint64 FidStorageBase::currentSegmentShots()
 {
     QMutexLocker l(pu_mutex.get());
+    waitForMerge();
     if(d_currentFidList.isEmpty())
         return 0;
 
@@ -246,23 +506,37 @@ quint64 FidStorageBase::currentSegmentShots()
 
 bool FidStorageBase::addFids(const FidList other, int shift)
 {
-    QMutexLocker l(pu_mutex.get());
-    if(d_currentFidList.isEmpty())
-        d_currentFidList = other;
+    auto fl = takeCurrentFidList();
+    bool ok = true;
+    if(fl.isEmpty())
+        fl = other;
+    else if(other.size() != fl.size())
+        ok = false;
     else
     {
-        if(other.size() != d_currentFidList.size())
-            return false;
-        for(int i=0; i<d_currentFidList.size(); i++)
-            d_currentFidList[i].add(other.at(i),shift);
+        //records are independent, so each worker only touches its own Fid
+        auto p = fl.data();
+        Analysis::parallelFor(fl.size(),[p,&other,shift](int i){
+            p[i].add(other.at(i),shift);
+        });
     }
 
-    return true;
+    restoreCurrentFidList(fl);
+    return ok;
+}
+
+bool FidStorageBase::addFids(const QByteArray rawData, const CpuAverager &avg, const Fid &fidTemplate, int shift)
+{
+    auto fl = takeCurrentFidList();
+    bool ok = avg.parseAndAdd(rawData.constData(),rawData.size(),fl,fidTemplate,shift);
+    restoreCurrentFidList(fl);
+    return ok;
 }
 
 bool FidStorageBase::setFidsData(const FidList other)
 {
     QMutexLocker l(pu_mutex.get());
+    waitForMerge();
     if(!d_currentFidList.isEmpty() && (other.size() != d_currentFidList.size()))
         return false;
 
@@ -273,6 +547,35 @@ bool FidStorageBase::setFidsData(const FidList other)
 FidList FidStorageBase::getCurrentFidList()
 {
     QMutexLocker l(pu_mutex.get());
+    waitForMerge();
     return d_currentFidList;
 }
 
+FidList FidStorageBase::takeCurrentFidList()
+{
+    //the list is moved out rather than copied, so merging a shot does not detach the records.
+    //pu_mutex is not held during the merge; readers of the list wait in waitForMerge() instead
+    QMutexLocker l(pu_mutex.get());
+    waitForMerge();
+    d_merging = true;
+
+    FidList out;
+    out.swap(d_currentFidList);
+    return out;
+}
+
+void FidStorageBase::restoreCurrentFidList(FidList &l)
+{
+    QMutexLocker lock(pu_mutex.get());
+    d_currentFidList.swap(l);
+    d_merging = false;
+    d_mergeDone.wakeAll();
+}
+
+void FidStorageBase::waitForMerge()
+{
+    //pu_mutex must be locked by the caller
+    while(d_merging)
+        d_mergeDone.wait(pu_mutex.get());
+}
+
@@ -1,18 +1,47 @@
 #ifndef FIDSTORAGEBASE_H
 #define FIDSTORAGEBASE_H
 
-#include <queue>
+#include <list>
+#include <set>
+#include <atomic>
+#include <QWaitCondition>
 #include <QDateTime>
+#include <QByteArray>
 
 #include <data/storage/datastoragebase.h>
 #include <data/experiment/fid.h>
+#include <data/storage/fidindexfile.h>
 
 class BlackchirpCSV;
+class CpuAverager;
+class QIODevice;
+class FidWriter;
+class QDir;
+class QThreadPool;
 
 class FidStorageBase : public DataStorageBase
 {
 
 public:
+    enum FidFormat {
+        Csv,
+        Binary,
+        Compressed
+    };
+
+    enum SyncPolicy {
+        SyncEachWrite,
+        NoSync
+    };
+
+    struct CacheStats {
+        quint64 hits{0};
+        quint64 misses{0};
+        quint64 evictions{0};
+        std::size_t bytes{0};
+        std::size_t budget{0};
+    };
+
     FidStorageBase(int numRecords, int number = -1, QString path = "");
     virtual ~FidStorageBase();
 
@@ -22,10 +51,14 @@ public:
     void save() override;
     void start() override;
     void finish() override;
+    bool flush();
     FidList loadFidList(int i);
+    bool exportCsv(int i, QIODevice &device);
+    CacheStats cacheStats() const;
 
     virtual quint64 currentSegmentShots();
     virtual bool addFids(const FidList other, int shift =0);
+    virtual bool addFids(const QByteArray rawData, const CpuAverager &avg, const Fid &fidTemplate, int shift =0);
     virtual bool setFidsData(const FidList other);
     virtual FidList getCurrentFidList();
     virtual void backup() { return; };
@@ -36,17 +69,46 @@ protected:
     FidList d_currentFidList;
     virtual void _advance() {};
     void saveFidList(const FidList l, int i);
+    void prefetch(int i);
+    FidList takeCurrentFidList();
+    void restoreCurrentFidList(FidList &l);
+    void waitForMerge();
+    int d_prefetchDepth{1};
 
 private:
     bool d_acquiring{false};
+    bool d_merging{false};
+    QWaitCondition d_mergeDone;
     int d_currentSegment{0};
-    std::size_t d_maxCacheSize{1 << 25}; //~200 MB
-    QVector<Fid> d_templateList;
+    std::size_t d_cacheBudget{std::size_t{256} << 20};
+    std::size_t d_cacheBytes{0};
+    std::atomic<quint64> d_cacheHits{0}, d_cacheMisses{0}, d_cacheEvictions{0};
+    std::atomic<bool> d_indexDirty{false};
+    FidFormat d_format{Binary};
+    bool d_checksums{true};
+    int d_compressionLevel{1};
+    SyncPolicy d_syncPolicy{SyncEachWrite};
+    std::unique_ptr<FidWriter> pu_writer;
     std::unique_ptr<QMutex> pu_baseMutex;
-    std::queue<int> d_cacheKeys;
-    std::map<int,FidList> d_cache;
+    std::unique_ptr<QThreadPool> pu_prefetchPool;
+    QWaitCondition d_prefetchDone;
+    std::set<int> d_prefetching;
+
+    struct CacheEntry {
+        FidList list;
+        std::size_t bytes;
+        std::list<int>::iterator lruPos;
+    };
+    std::list<int> d_lru; //most recently used first
+    std::map<int,CacheEntry> d_cache;
+    std::map<int,FidIndexFile::Record> d_legacyIndex; //only used if the index cannot be written
 
+    FidList loadFidList(int i, bool prefetching);
     void updateCache(const FidList fl, int i);
+    bool writeFidList(const FidList &l, int i);
+    bool ensureIndex(const QDir &d);
+    bool readIndex(const QDir &d, int i, FidIndexFile::Record &out);
+    bool writeFidParamsCsv();
 
 };
 
@@ -0,0 +1,105 @@
+#include "fidwriter.h"
+
+#include <QThread>
+#include <QMutexLocker>
+
+FidWriter::FidWriter(WriteFunction f, int capacity) : d_write(f), d_capacity(qMax(1,capacity))
+{
+}
+
+FidWriter::~FidWriter()
+{
+    QMutexLocker l(&d_mutex);
+    d_stop = true;
+    d_workAvailable.wakeAll();
+    l.unlock();
+
+    //the thread drains the queue before exiting
+    if(pu_thread)
+        pu_thread->wait();
+}
+
+void FidWriter::enqueue(const FidList l, int index)
+{
+    QMutexLocker lock(&d_mutex);
+    if(!pu_thread)
+    {
+        pu_thread.reset(QThread::create([this](){ run(); }));
+        pu_thread->setObjectName("FidWriterThread");
+        pu_thread->start();
+    }
+
+    auto it = d_queued.find(index);
+    if(it != d_queued.end())
+    {
+        it->second = l;
+        return;
+    }
+
+    while(static_cast<int>(d_order.size()) >= d_capacity)
+        d_spaceAvailable.wait(&d_mutex);
+
+    d_order.push_back(index);
+    d_queued.emplace(index,l);
+    d_workAvailable.wakeOne();
+}
+
+bool FidWriter::pending(int index, FidList &out) const
+{
+    QMutexLocker lock(&d_mutex);
+    auto it = d_queued.find(index);
+    if(it != d_queued.end())
+    {
+        out = it->second;
+        return true;
+    }
+
+    if(index == d_activeIndex)
+    {
+        out = d_active;
+        return true;
+    }
+
+    return false;
+}
+
+bool FidWriter::flush()
+{
+    QMutexLocker lock(&d_mutex);
+    while(!d_order.empty() || d_activeIndex >= 0)
+        d_idle.wait(&d_mutex);
+
+    bool out = d_ok;
+    d_ok = true;
+    return out;
+}
+
+void FidWriter::run()
+{
+    QMutexLocker lock(&d_mutex);
+    while(true)
+    {
+        while(d_order.empty() && !d_stop)
+            d_workAvailable.wait(&d_mutex);
+
+        if(d_order.empty())
+            break;
+
+        d_activeIndex = d_order.front();
+        d_order.pop_front();
+        auto it = d_queued.find(d_activeIndex);
+        d_active = it->second;
+        d_queued.erase(it);
+        d_spaceAvailable.wakeAll();
+
+        lock.unlock();
+        bool ok = d_write(d_active,d_activeIndex);
+        lock.relock();
+
+        d_ok &= ok;
+        d_activeIndex = -1;
+        d_active.clear();
+        if(d_order.empty())
+            d_idle.wakeAll();
+    }
+}
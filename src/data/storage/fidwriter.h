@@ -0,0 +1,58 @@
+#ifndef FIDWRITER_H
+#define FIDWRITER_H
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+
+#include <data/experiment/fid.h>
+
+class QThread;
+
+/*!
+ * \brief Background writer for FidList snapshots
+ *
+ * FidWriter moves disk writes for FidStorageBase off the acquisition thread. enqueue() stores
+ * the (implicitly shared) FidList in a bounded queue and returns immediately. A dedicated thread,
+ * started on the first enqueue, passes each snapshot to the write function.
+ *
+ * A snapshot for an index that is already queued replaces the queued one and keeps its place,
+ * so frequent autosaves of the same segment are written once. If the queue is full, enqueue()
+ * waits until the writer has made room.
+ *
+ * Queued and in-progress snapshots can be looked up with pending(), which lets readers see data
+ * that has not reached the disk yet. flush() waits until everything queued so far is written.
+ */
+class FidWriter
+{
+public:
+    using WriteFunction = std::function<bool(const FidList&,int)>;
+
+    explicit FidWriter(WriteFunction f, int capacity = 4);
+    ~FidWriter();
+
+    void enqueue(const FidList l, int index);
+    bool pending(int index, FidList &out) const;
+    bool flush();
+
+private:
+    WriteFunction d_write;
+    const int d_capacity;
+
+    mutable QMutex d_mutex;
+    QWaitCondition d_workAvailable, d_spaceAvailable, d_idle;
+    std::deque<int> d_order;
+    std::map<int,FidList> d_queued;
+    int d_activeIndex{-1};
+    FidList d_active;
+    bool d_stop{false};
+    bool d_ok{true};
+    std::unique_ptr<QThread> pu_thread;
+
+    void run();
+};
+
+#endif // FIDWRITER_H
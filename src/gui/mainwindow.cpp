@@ -295,6 +295,7 @@ MainWindow::MainWindow(QWidget *parent) :
 
 
     p_am = new AcquisitionManager();
+    p_hwm->setFtmwShotQueue(p_am->ftmwShotQueue());
     connect(p_am,&AcquisitionManager::logMessage,p_lh,&LogHandler::logMessage);
     connect(p_am,&AcquisitionManager::statusMessage,ui->statusBar,&QStatusBar::showMessage);
     connect(p_am,&AcquisitionManager::ftmwUpdateProgress,ui->ftmwProgressBar,&QProgressBar::setValue);
@@ -360,8 +360,9 @@ int BCEvenSpacedCurveBase::indexBefore(double xVal) const
 
 QVector<QPointF> BCEvenSpacedCurveBase::_filter(int w, const QwtScaleMap map)
 {
-    auto d = yData();
-    d.detach();
+    //yData() shares the curve's data rather than copying it. The curve only ever replaces its data,
+    //so the shared copy is never modified while it is being filtered here
+    const auto d = yData();
     auto s = d.size();
 
     if(s < 2.5*w)
@@ -534,6 +535,18 @@ QRectF BlackchirpFIDCurve::boundingRect() const
     return out;
 }
 
+bool BlackchirpFIDCurve::isEmpty() const
+{
+    QMutexLocker l(p_mutex);
+    return d_fidData.isEmpty();
+}
+
+double BlackchirpFIDCurve::xLast() const
+{
+    QMutexLocker l(p_mutex);
+    return d_spacing*(d_fidData.size()-1);
+}
+
 QVector<QPointF> BlackchirpFIDCurve::curveData() const
 {
     QVector<QPointF> out;
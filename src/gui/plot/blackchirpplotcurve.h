@@ -178,6 +178,8 @@ public:
     ~BlackchirpFIDCurve();
 
     void setCurrentFid(const QVector<double> d, double spacing=1.0, double min=0.0, double max=0.0);
+    bool isEmpty() const;
+    double xLast() const;
 
 private:
     QMutex *p_mutex;
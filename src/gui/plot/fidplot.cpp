@@ -157,9 +157,8 @@ void FidPlot::prepareForExperiment(const Experiment &e)
 void FidPlot::setFtStart(double start)
 {
     double v = start;
-    auto currentFid = p_curve->curveData();
-    if(!currentFid.isEmpty())
-        v = qBound(0.0,start,qMin(d_ftMarkers.second->value().x(),currentFid.constLast().x()*1e6));
+    if(!p_curve->isEmpty())
+        v = qBound(0.0,start,qMin(d_ftMarkers.second->value().x(),p_curve->xLast()*1e6));
 
     d_ftMarkers.first->setValue(v,0.0);
 
@@ -171,9 +170,8 @@ void FidPlot::setFtStart(double start)
 void FidPlot::setFtEnd(double end)
 {
     double v = end;
-    auto currentFid = p_curve->curveData();
-    if(!currentFid.isEmpty())
-        v = qBound(d_ftMarkers.first->value().x(),end,currentFid.constLast().x()*1e6);
+    if(!p_curve->isEmpty())
+        v = qBound(d_ftMarkers.first->value().x(),end,p_curve->xLast()*1e6);
 
     d_ftMarkers.second->setValue(v,0.0);
     emit ftEndChanged(v);
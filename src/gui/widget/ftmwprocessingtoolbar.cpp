@@ -90,6 +90,17 @@ FtmwProcessingToolBar::FtmwProcessingToolBar(QWidget *parent) :
     registerGetter(BC::Key::ftUnits,p_unitsBox,&EnumComboBoxWidgetAction<FtWorker::FtUnits>::value);
     addAction(p_unitsBox);
 
+    p_fftBox = new EnumComboBoxWidgetAction<FftBackend::Type>("FFT Backend",this);
+    p_fftBox->setItemEnabled(FftBackend::Fftw,FftBackend::isAvailable(FftBackend::Fftw));
+    auto fb = get(BC::Key::fftBackend,FftBackend::bestAvailable());
+    p_fftBox->setValue(FftBackend::isAvailable(fb) ? fb : FftBackend::Gsl);
+    p_fftBox->setToolTip(QString("Library used to compute FFTs. FFTW is only available if Blackchirp was built with CONFIG += fftw."));
+    connect(p_fftBox,&EnumComboBoxWidgetAction<FftBackend::Type>::valueChanged,
+            this,&FtmwProcessingToolBar::readSettings);
+
+    registerGetter(BC::Key::fftBackend,p_fftBox,&EnumComboBoxWidgetAction<FftBackend::Type>::value);
+    addAction(p_fftBox);
+
 }
 
 FtmwProcessingToolBar::~FtmwProcessingToolBar()
@@ -105,10 +116,11 @@ FtWorker::FidProcessingSettings FtmwProcessingToolBar::getSettings()
     double ignore = p_autoScaleIgnoreBox->value();
     auto units = p_unitsBox->value();
     auto winf = p_winfBox->value();
+    auto fft = p_fftBox->value();
 
     save();
 
-    return { start, stop, zeroPad, rdc, units, ignore, winf };
+    return { start, stop, zeroPad, rdc, units, ignore, winf, fft };
 }
 
 void FtmwProcessingToolBar::prepareForExperient(const Experiment &e)
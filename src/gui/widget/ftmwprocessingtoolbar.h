@@ -24,6 +24,7 @@ static const QString fidEnd{"endUs"};
 static const QString zeroPad{"zeroPad"};
 static const QString removeDC{"removeDC"};
 static const QString ftUnits{"ftUnits"};
+static const QString fftBackend{"fftBackend"};
 static const QString autoscaleIgnore{"autoscaleIgnoreMHz"};
 static const QString ftWinf{"windowFunction"};
 }
@@ -49,6 +50,7 @@ private:
     CheckWidgetAction *p_removeDCBox;
     EnumComboBoxWidgetAction<FtWorker::FtUnits> *p_unitsBox;
     EnumComboBoxWidgetAction<FtWorker::FtWindowFunction> *p_winfBox;
+    EnumComboBoxWidgetAction<FftBackend::Type> *p_fftBox;
 
 
 
@@ -27,7 +27,8 @@ FtmwViewWidget::FtmwViewWidget(QWidget *parent, QString path) :
     connect(p_worker,&FtWorker::ftDone,this,&FtmwViewWidget::ftDone,Qt::QueuedConnection);
     connect(p_worker,&FtWorker::fidDone,this,&FtmwViewWidget::fidProcessed,Qt::QueuedConnection);
     connect(p_worker,&FtWorker::ftDiffDone,this,&FtmwViewWidget::ftDiffDone,Qt::QueuedConnection);
-    connect(p_worker,&FtWorker::sidebandDone,this,&FtmwViewWidget::sidebandProcessingComplete);
+    connect(p_worker,&FtWorker::sidebandDone,this,&FtmwViewWidget::sidebandProcessingComplete,Qt::QueuedConnection);
+    connect(p_worker,&FtWorker::sidebandProgress,this,&FtmwViewWidget::sidebandProgress,Qt::QueuedConnection);
 
     d_workerIds << d_liveId << d_mainId << d_plot1Id << d_plot2Id;
 
@@ -58,9 +59,6 @@ FtmwViewWidget::FtmwViewWidget(QWidget *parent, QString path) :
 
     }
 
-    d_sbStatus.sbLoadWatcher = new QFutureWatcher<FidList>(this);
-    connect(d_sbStatus.sbLoadWatcher,&QFutureWatcher<FidList>::finished,this,&FtmwViewWidget::sidebandLoadComplete);
-
     for(auto &[key,ps] : d_plotStatus)
     {
         (void)key;
@@ -100,7 +98,7 @@ FtmwViewWidget::~FtmwViewWidget()
     if(p_pfw != nullptr)
         p_pfw->close();
 
-    d_sbStatus.sbLoadWatcher->waitForFinished();
+    cancelSidebandProcessing();
 
     for(auto &[key,ps] : d_plotStatus)
     {
@@ -131,6 +129,7 @@ void FtmwViewWidget::prepareForExperiment(const Experiment &e)
 
     ui->refreshBox->setEnabled(false);
 
+    p_worker->resetCachedFT();
     ui->liveFidPlot->prepareForExperiment(e);
     ui->liveFidPlot->setVisible(true);
 
@@ -308,15 +307,8 @@ void FtmwViewWidget::ftProcessingComplete(int id)
             case FtmwPlotToolBar::Lower_SideBand:
             case FtmwPlotToolBar::Upper_SideBand:
             case FtmwPlotToolBar::Both_SideBands:
-                if(d_sbStatus.cancel)
-                    updateMainPlot();
-                else
-                {
-                    if(!d_sbStatus.nextFid.isEmpty())
-                        processNextSidebandFid();
-                    if(!d_sbStatus.sbLoadWatcher->isRunning())
-                        loadNextSidebandFid();
-                }
+                //a new request arrived while the previous one was running
+                updateMainPlot();
                 break;
             default:
                 updateMainPlot();
@@ -458,8 +450,9 @@ void FtmwViewWidget::process(int id, const Fid f)
         d_plotStatus[id].ftPlot->setCursor(Qt::BusyCursor);
         ws.busy = true;
         ws.reprocessWhenDone = false;
+        //these plots are refreshed repeatedly; ticks with no new shots reuse the previous spectrum
         ws.p_watcher->setFuture(QtConcurrent::run([f,id,this](){
-            p_worker->doFT(f,d_currentProcessingSettings,id);
+            p_worker->cachedFT(f,d_currentProcessingSettings,id);
         }));
     }
 }
@@ -484,31 +477,6 @@ void FtmwViewWidget::processDiff(const Fid f1, const Fid f2)
     }
 }
 
-void FtmwViewWidget::sidebandLoadComplete()
-{
-    d_sbStatus.nextFid = Fid();
-
-    if(d_sbStatus.cancel)
-    {
-        updateMainPlot();
-        return;
-    }
-
-    int frame = ui->plotToolBar->frame(ui->plotToolBar->mainPlotFollow())-1;
-
-    auto fl = d_sbStatus.sbLoadWatcher->result();
-    Fid f = fl.value(frame,Fid());
-
-    //queue FID
-    d_sbStatus.nextFid = f;
-    if(!d_workersStatus[d_mainId].busy)
-    {
-        processNextSidebandFid();
-        loadNextSidebandFid();
-    }
-
-}
-
 void FtmwViewWidget::processSidebands()
 {  
     auto &ws = d_workersStatus[d_mainId];
@@ -516,18 +484,10 @@ void FtmwViewWidget::processSidebands()
         ws.reprocessWhenDone = true;
     else
     {
-        //need to reset sideband parameters
-        //then need to set up load/process chain
-        auto storage = dynamic_cast<FidMultiStorage*>(ps_fidStorage.get());
+        auto storage = std::dynamic_pointer_cast<FidMultiStorage>(ps_fidStorage);
         if(!storage)
             return;
 
-        if(d_sbStatus.sbLoadWatcher->isRunning())
-        {
-            cancelSidebandProcessing();
-            return;
-        }
-
         d_sbStatus.cancel = false;
         d_sbStatus.complete = false;
         auto &sbd = d_sbStatus.sbData;
@@ -535,6 +495,7 @@ void FtmwViewWidget::processSidebands()
         sbd.minOffset = ui->plotToolBar->sbMinFreq();
         sbd.maxOffset = ui->plotToolBar->sbMaxFreq();
         sbd.totalFids = storage->numSegments();
+        sbd.cancel = std::make_shared<std::atomic<bool>>(false);
         switch (ui->plotToolBar->mainPlotMode()) {
         case FtmwPlotToolBar::Lower_SideBand:
             sbd.doubleSideband = false;
@@ -550,50 +511,29 @@ void FtmwViewWidget::processSidebands()
         default:
             break;
         };
-        d_sbStatus.sbData = sbd;
 
         ui->mainFtPlot->canvas()->setCursor(QCursor(Qt::BusyCursor));
         ui->mainFtPlot->setMessageText(QString("Processing..."));
         ui->mainFtPlot->newFt(Ft());
-        loadNextSidebandFid();
-    }
-}
 
-void FtmwViewWidget::loadNextSidebandFid()
-{
-    if(d_sbStatus.cancel && !d_sbStatus.complete)
-    {
-        updateMainPlot();
-        return;
+        int frame = ui->plotToolBar->frame(ui->plotToolBar->mainPlotFollow())-1;
+        auto settings = d_currentProcessingSettings;
+        ws.busy = true;
+        ws.reprocessWhenDone = false;
+        ws.p_watcher->setFuture(QtConcurrent::run([this,sbd,settings,storage,frame]{
+            p_worker->processSidebands(sbd,settings,[storage,frame](int i){
+                return storage->loadFidList(i).value(frame,Fid());
+            });
+        }));
     }
-
-    if(d_sbStatus.sbData.currentIndex >= d_sbStatus.sbData.totalFids)
-        return;
-
-    d_sbStatus.sbLoadWatcher->setFuture(QtConcurrent::run([this](){ return ps_fidStorage->loadFidList(d_sbStatus.sbData.currentIndex); }));
-
 }
 
-void FtmwViewWidget::processNextSidebandFid()
+void FtmwViewWidget::sidebandProgress(int done, int total)
 {
-    auto f = d_sbStatus.nextFid;
-    d_sbStatus.nextFid = Fid();
-
-    if(d_sbStatus.cancel || d_sbStatus.sbData.currentIndex >= d_sbStatus.sbData.totalFids)
+    if(d_sbStatus.cancel || d_sbStatus.complete)
         return;
 
-    auto &ws = d_workersStatus[d_mainId];
-    ws.busy = true;
-    ws.reprocessWhenDone = true;
-    d_sbStatus.sbData.fid = f;
-    auto sbd = d_sbStatus.sbData;
-    ws.p_watcher->setFuture(QtConcurrent::run([this,sbd]{
-        p_worker->processSideband(sbd,d_currentProcessingSettings);
-    }));
-    d_sbStatus.sbData.currentIndex++;
-    ui->mainFtPlot->setMessageText(QString("Processing %1/%2")
-                                   .arg(d_sbStatus.sbData.currentIndex)
-                                   .arg(d_sbStatus.sbData.totalFids));
+    ui->mainFtPlot->setMessageText(QString("Processing %1/%2").arg(done).arg(total));
     ui->mainFtPlot->replot();
 }
 
@@ -605,8 +545,6 @@ void FtmwViewWidget::sidebandProcessingComplete(const Ft ft)
         updateMainPlot();
     else
     {
-        d_sbStatus.nextFid = Fid();
-
         ui->mainFtPlot->canvas()->setCursor(QCursor(Qt::CrossCursor));
         ui->mainFtPlot->setMessageText("");
         ui->mainFtPlot->newFt(ft);
@@ -616,7 +554,8 @@ void FtmwViewWidget::sidebandProcessingComplete(const Ft ft)
 void FtmwViewWidget::cancelSidebandProcessing()
 {
     d_sbStatus.cancel = true;
-    d_sbStatus.nextFid = Fid();
+    if(d_sbStatus.sbData.cancel)
+        d_sbStatus.sbData.cancel->store(true);
 }
 
 void FtmwViewWidget::updateBackups()
@@ -642,6 +581,7 @@ void FtmwViewWidget::experimentComplete()
         ui->verticalLayout->setStretch(0,0);
         ui->liveFidPlot->hide();
         ui->liveFtPlot->hide();
+        p_worker->resetCachedFT(d_liveId);
 
         ui->plotToolBar->experimentComplete();
 
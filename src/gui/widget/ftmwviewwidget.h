@@ -70,10 +70,8 @@ public slots:
     void process(int id, const Fid f);
     void processDiff(const Fid f1, const Fid f2);
 
-    void sidebandLoadComplete();
     void processSidebands();
-    void loadNextSidebandFid();
-    void processNextSidebandFid();
+    void sidebandProgress(int done, int total);
     void sidebandProcessingComplete(const Ft ft);
     void cancelSidebandProcessing();
 
@@ -124,9 +122,7 @@ private:
     const QString d_shotsString = QString("Shots: %1");
 
     struct SidebandStatus {
-        QFutureWatcher<FidList> *sbLoadWatcher;
         FtWorker::SidebandProcessingData sbData;
-        Fid nextFid;
         bool cancel{true};
         bool complete{false};
     } d_sbStatus;
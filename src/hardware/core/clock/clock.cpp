@@ -1,6 +1,7 @@
 #include <hardware/core/clock/clock.h>
 
 #include <QMetaEnum>
+#include <QMutex>
 
 Clock::Clock(int clockNum, int numOutputs, bool tunable, const QString subKey, const QString name, CommunicationProtocol::CommType commType,
              QObject *parent) :
@@ -179,9 +180,14 @@ double Clock::setFrequency(RfConfig::ClockType t, double freqMHz)
 
 bool Clock::prepareForExperiment(Experiment &exp)
 {
+    //clocks are prepared concurrently, and they share the experiment's RfConfig
+    static QMutex rfMutex;
+
     if(exp.ftmwEnabled())
     {
+        QMutexLocker l(&rfMutex);
         auto clocks = exp.ftmwConfig()->d_rfConfig.getClocks();
+        l.unlock();
         for(auto it = clocks.constBegin(); it != clocks.constEnd(); it++)
         {
             if(hasRole(it.key()))
@@ -190,13 +196,15 @@ bool Clock::prepareForExperiment(Experiment &exp)
                 double val = setFrequency(it.key(),c.desiredFreqMHz);
                 if(val < 0.0)
                 {
-                    exp.d_errorString = QString("Could not initialize %1 to %2 MHz")
+                    exp.setErrorString(QString("Could not initialize %1 to %2 MHz")
                                        .arg(QMetaEnum::fromType<RfConfig::ClockType>()
                                             .valueToKey(it.key()))
-                                       .arg(it.value().desiredFreqMHz,0,'f',6);
+                                       .arg(it.value().desiredFreqMHz,0,'f',6));
                     return false;
                 }
+                l.relock();
                 exp.ftmwConfig()->d_rfConfig.setClockDesiredFreq(it.key(),val);
+                l.unlock();
             }
         }
     }
@@ -81,6 +81,7 @@ protected:
     // HardwareObject interface
 public slots:
     virtual bool prepareForExperiment(Experiment &exp) override final;
+    int prepareStage() const override { return 0; }
 };
 
 #endif // CLOCK_H
@@ -1,6 +1,11 @@
 #include "clockmanager.h"
 
 #include <QMetaEnum>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QDeadlineTimer>
+#include <QElapsedTimer>
 
 #include <hardware/core/clock/clock.h>
 
@@ -113,6 +118,85 @@ double ClockManager::setClockFrequency(RfConfig::ClockType t, double freqMHz)
     return d_clockRoles.value(t)->setFrequency(t,freqMHz);
 }
 
+void ClockManager::setClockFrequencies(QHash<RfConfig::ClockType, RfConfig::ClockFreq> &clocks)
+{
+    //each hardware clock is retuned in its own thread, and all clocks are retuned at once.
+    //A clock with several roles sets them in turn, since they share one connection
+    std::map<Clock*,std::vector<RfConfig::ClockType>> byClock;
+    for(auto it = clocks.begin(); it != clocks.end(); ++it)
+    {
+        if(!d_clockRoles.contains(it.key()))
+        {
+            emit logMessage(QString("No clock configured for use as %1")
+                            .arg(QMetaEnum::fromType<RfConfig::ClockType>().valueToKey(it.key())),
+                            LogHandler::Warning);
+            it.value().desiredFreqMHz = -1.0;
+            continue;
+        }
+        byClock[d_clockRoles.value(it.key())].push_back(it.key());
+    }
+
+    //shared with the retune calls, which may outlive this function if they time out
+    struct RetuneSync {
+        QMutex mutex;
+        QWaitCondition finished;
+        std::map<RfConfig::ClockType,double> results;
+        std::size_t done{0};
+    };
+    auto sync = std::make_shared<RetuneSync>();
+
+    auto retune = [sync](Clock *c, std::vector<std::pair<RfConfig::ClockType,double>> targets){
+        std::vector<std::pair<RfConfig::ClockType,double>> out;
+        for(auto &[type,f] : targets)
+            out.push_back({type,c->setFrequency(type,f)});
+
+        QMutexLocker l(&sync->mutex);
+        for(auto &p : out)
+            sync->results.insert(p);
+        sync->done++;
+        sync->finished.wakeAll();
+    };
+
+    std::vector<std::pair<Clock*,std::vector<std::pair<RfConfig::ClockType,double>>>> local;
+    int timeoutSec = 0;
+    for(auto &[c,types] : byClock)
+    {
+        std::vector<std::pair<RfConfig::ClockType,double>> targets;
+        for(auto t : types)
+            targets.push_back({t,clocks.value(t).desiredFreqMHz});
+
+        timeoutSec = qMax(timeoutSec,c->prepareTimeoutSec());
+        if(c->thread() != QThread::currentThread())
+            QMetaObject::invokeMethod(c,[c,targets,retune](){ retune(c,targets); },Qt::QueuedConnection);
+        else
+            local.push_back({c,targets});
+    }
+
+    for(auto &[c,targets] : local)
+        retune(c,targets);
+
+    QDeadlineTimer deadline(timeoutSec*1000ll);
+    QMutexLocker l(&sync->mutex);
+    while(sync->done < byClock.size())
+    {
+        if(!sync->finished.wait(&sync->mutex,deadline))
+            break;
+    }
+
+    for(auto &[c,types] : byClock)
+    {
+        if(sync->results.find(types.front()) == sync->results.end())
+            emit logMessage(QString("Timed out setting %1 frequency (limit: %2 s)")
+                            .arg(c->d_name).arg(timeoutSec),LogHandler::Error);
+
+        for(auto t : types)
+        {
+            auto it = sync->results.find(t);
+            clocks[t].desiredFreqMHz = it == sync->results.end() ? -1.0 : it->second;
+        }
+    }
+}
+
 double ClockManager::readClockFrequency(RfConfig::ClockType t)
 {
     if(!d_clockRoles.contains(t))
@@ -45,6 +45,7 @@ public slots:
     void readActiveClocks();
     QMultiHash<RfConfig::ClockType,RfConfig::ClockFreq> getCurrentClocks();
     double setClockFrequency(RfConfig::ClockType t, double freqMHz);
+    void setClockFrequencies(QHash<RfConfig::ClockType,RfConfig::ClockFreq> &clocks);
     double readClockFrequency(RfConfig::ClockType t);
     bool configureClocks(QMultiHash<RfConfig::ClockType,RfConfig::ClockFreq> clocks);
     bool prepareForExperiment(Experiment &exp);
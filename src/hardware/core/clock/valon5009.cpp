@@ -127,7 +127,7 @@ bool Valon5009::prepareClock(Experiment &exp)
         auto resp = valonQueryCmd(QString("LOCK?\r"));
         if(resp.contains("not locked"))
         {
-            exp.d_errorString = QString("Could not lock to external reference.");
+            exp.setErrorString(QString("Could not lock to external reference."));
             return false;
         }
     }
@@ -138,7 +138,7 @@ bool Valon5009::prepareClock(Experiment &exp)
         auto resp = valonQueryCmd(QString("LOCK?\r"));
         if(resp.contains("not locked"))
         {
-            exp.d_errorString = QString("Could not lock to internal reference.");
+            exp.setErrorString(QString("Could not lock to internal reference."));
             return false;
         }
     }
@@ -0,0 +1,111 @@
+#include "blockdataparser.h"
+
+#include <QIODevice>
+#include <limits>
+
+BlockDataParser::BlockDataParser(qint64 expectedBytes, const QByteArray terminator) :
+    d_expectedBytes(expectedBytes), d_terminator(terminator)
+{
+}
+
+void BlockDataParser::reset()
+{
+    d_state = SeekingHeader;
+    d_lengthDigits = 0;
+    d_filled = 0;
+    d_skipTerminator = false;
+    d_block.clear();
+}
+
+bool BlockDataParser::read(QIODevice *dev, QByteArray &out, Allocator alloc)
+{
+    while(true)
+    {
+        auto avail = dev->bytesAvailable();
+        if(avail <= 0)
+            return false;
+
+        switch(d_state) {
+        case SeekingHeader:
+        {
+            if(d_skipTerminator)
+            {
+                if(avail < d_terminator.size())
+                    return false;
+                if(dev->peek(d_terminator.size()) == d_terminator)
+                    dev->skip(d_terminator.size());
+                d_skipTerminator = false;
+                continue;
+            }
+
+            auto chunk = qMin(avail,static_cast<qint64>(4096));
+            auto idx = dev->peek(chunk).indexOf('#');
+            if(idx < 0)
+            {
+                dev->skip(chunk);
+                continue;
+            }
+            dev->skip(idx+1);
+            d_state = ReadingDigitCount;
+            break;
+        }
+        case ReadingDigitCount:
+        {
+            char c = 0;
+            dev->getChar(&c);
+            bool ok = false;
+            int nd = QByteArray(1,c).toInt(&ok,16);
+            if(!ok || nd < 1 || nd > 15)
+            {
+                //probably in the middle of an old block; look for the next '#'
+                resync();
+                break;
+            }
+            d_lengthDigits = nd;
+            d_state = ReadingLength;
+            break;
+        }
+        case ReadingLength:
+        {
+            if(avail < d_lengthDigits)
+                return false;
+
+            bool ok = false;
+            qint64 n = dev->read(d_lengthDigits).toLongLong(&ok);
+            if(!ok || n < 1 || n > std::numeric_limits<int>::max() || (d_expectedBytes > 0 && n != d_expectedBytes))
+            {
+                resync();
+                break;
+            }
+
+            d_block = alloc ? alloc(static_cast<int>(n)) : QByteArray(static_cast<int>(n),Qt::Uninitialized);
+            d_filled = 0;
+            d_state = ReadingData;
+            break;
+        }
+        case ReadingData:
+        {
+            auto r = dev->read(d_block.data()+d_filled,d_block.size()-d_filled);
+            if(r <= 0)
+                return false;
+            d_filled += r;
+            if(d_filled < d_block.size())
+                return false;
+
+            out.clear();
+            out.swap(d_block);
+            d_state = SeekingHeader;
+            d_lengthDigits = 0;
+            d_filled = 0;
+            d_skipTerminator = !d_terminator.isEmpty();
+            return true;
+        }
+        }
+    }
+}
+
+void BlockDataParser::resync()
+{
+    d_resyncs++;
+    reset();
+}
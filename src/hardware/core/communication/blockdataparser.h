@@ -0,0 +1,67 @@
+#ifndef BLOCKDATAPARSER_H
+#define BLOCKDATAPARSER_H
+
+#include <QByteArray>
+#include <functional>
+
+class QIODevice;
+
+/*!
+ * \brief Incremental parser for IEEE 488.2 definite-length block data
+ *
+ * Instruments return binary data in the format #xyyyy<data>, where x is the number of digits
+ * in the length yyyy, and the block is usually followed by a terminator. read() consumes
+ * whatever the device has available and picks up where it left off on the next call, so it can
+ * be called from a readyRead handler without waiting for the whole block to arrive.
+ *
+ * Once the length is known, the destination buffer is obtained from an allocator and the data
+ * are read straight into it as they arrive, instead of accumulating in the device buffer first.
+ * Bytes before the '#' are discarded, as is a block whose length does not match the expected
+ * size (if one has been set). In both cases the parser resumes looking for the next '#'.
+ */
+class BlockDataParser
+{
+public:
+    enum State {
+        SeekingHeader,
+        ReadingDigitCount,
+        ReadingLength,
+        ReadingData
+    };
+
+    using Allocator = std::function<QByteArray(int)>;
+
+    explicit BlockDataParser(qint64 expectedBytes = -1, const QByteArray terminator = QByteArray("\n"));
+
+    void reset();
+    void setExpectedBytes(qint64 n) { d_expectedBytes = n; }
+    void setTerminator(const QByteArray t) { d_terminator = t; }
+
+    /*!
+     * \brief Consumes available bytes from dev
+     * \param dev Device to read from
+     * \param out Receives the block when one is complete
+     * \param alloc Returns a buffer of the requested size. If empty, a new QByteArray is allocated.
+     * \return bool True if a complete block was placed in out. Call again to check for another.
+     */
+    bool read(QIODevice *dev, QByteArray &out, Allocator alloc = Allocator());
+
+    State state() const { return d_state; }
+    bool inBlock() const { return d_state != SeekingHeader; }
+    quint64 resyncs() const { return d_resyncs; }
+
+private:
+    qint64 d_expectedBytes;
+    QByteArray d_terminator;
+
+    State d_state{SeekingHeader};
+    int d_lengthDigits{0};
+    qint64 d_filled{0};
+    bool d_skipTerminator{false};
+    QByteArray d_block;
+    quint64 d_resyncs{0};
+
+    void resync();
+};
+
+#endif // BLOCKDATAPARSER_H
@@ -1,5 +1,6 @@
 
 HEADERS += \
+    $$PWD/blockdataparser.h \
     $$PWD/communicationprotocol.h \
 	$$PWD/custominstrument.h \
 	$$PWD/gpibinstrument.h \
@@ -8,6 +9,7 @@ HEADERS += \
     $$PWD/virtualinstrument.h
 
 SOURCES += \
+    $$PWD/blockdataparser.cpp \
     $$PWD/communicationprotocol.cpp \
     $$PWD/custominstrument.cpp \
 	$$PWD/gpibinstrument.cpp \
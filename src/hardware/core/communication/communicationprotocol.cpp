@@ -65,6 +65,7 @@ QByteArray CommunicationProtocol::queryCmd(QString cmd, bool suppressError)
     if(p_device->bytesAvailable())
         p_device->readAll();
 
+    d_roundTrips++;
     qint64 ret = p_device->write(cmd.toLatin1());
 
     if(ret == -1)
@@ -137,6 +138,94 @@ QByteArray CommunicationProtocol::queryCmd(QString cmd, bool suppressError)
     }
 }
 
+QList<QByteArray> CommunicationProtocol::queryBatch(const QStringList cmds, bool suppressError)
+{
+    QList<QByteArray> out;
+    out.reserve(cmds.size());
+
+    //protocols without a QIODevice (e.g., GPIB) implement queryCmd themselves
+    if(p_device == nullptr || !d_useTermChar || d_readTerminator.isEmpty() || cmds.size() == 1)
+    {
+        for(auto &c : cmds)
+            out.append(queryCmd(c,suppressError));
+        return out;
+    }
+
+    for(int start = 0; start < cmds.size(); start += d_maxBatchSize)
+    {
+        auto chunk = cmds.mid(start,d_maxBatchSize);
+        QString joined = chunk.join(QString(""));
+
+        if(p_device->bytesAvailable())
+            p_device->readAll();
+
+        d_roundTrips++;
+        if(p_device->write(joined.toLatin1()) == -1)
+        {
+            if(!suppressError)
+            {
+                emit hardwareFailure();
+                emit logMessage(QString("Could not write batched queries. (queries = %1)").arg(joined),LogHandler::Error);
+            }
+            break;
+        }
+
+        bool written = true;
+        while(p_device->bytesToWrite() > 0)
+        {
+            if(!p_device->waitForBytesWritten(30000))
+            {
+                written = false;
+                break;
+            }
+        }
+        if(!written)
+        {
+            if(!suppressError)
+            {
+                emit hardwareFailure();
+                emit logMessage(QString("Timed out while waiting for batched query write. (queries = %1)").arg(joined),LogHandler::Error);
+            }
+            break;
+        }
+
+        //responses arrive in order; split them on the read terminator as they come in
+        QByteArray buffer;
+        int received = 0;
+        while(received < chunk.size())
+        {
+            int idx = buffer.indexOf(d_readTerminator);
+            if(idx >= 0)
+            {
+                out.append(buffer.left(idx));
+                buffer.remove(0,idx+d_readTerminator.size());
+                received++;
+                continue;
+            }
+
+            if(!p_device->waitForReadyRead(d_timeOut))
+                break;
+            buffer.append(p_device->readAll());
+        }
+
+        if(received < chunk.size())
+        {
+            if(!suppressError)
+            {
+                emit hardwareFailure();
+                emit logMessage(QString("Received %1 of %2 responses to batched queries. (first missing query = %3, partial response = %4)")
+                                .arg(received).arg(chunk.size()).arg(chunk.at(received)).arg(QString(buffer)),LogHandler::Error);
+            }
+            break;
+        }
+    }
+
+    while(out.size() < cmds.size())
+        out.append(QByteArray());
+
+    return out;
+}
+
 QString CommunicationProtocol::errorString()
 {
     QString out = d_errorString;
@@ -38,6 +38,30 @@ public:
     virtual bool writeBinary(QByteArray dat);
     virtual QByteArray queryCmd(QString cmd, bool suppressError = false);
 
+    /*!
+     * \brief Sends several queries and returns one response per query
+     *
+     * When a read terminator is in use, the queries are pipelined: up to maxBatchSize() of them
+     * are written at once and the responses are read back in order, split on the terminator.
+     * This costs one round trip per batch rather than one per query. Without a terminator the
+     * responses cannot be told apart, so each query is sent with queryCmd() instead. The same
+     * is done when there is no QIODevice, as for protocols that override queryCmd().
+     *
+     * Each command must already include any write terminator the device expects.
+     *
+     * \param cmds Queries to send, in order
+     * \param suppressError If true, no error messages are emitted on failure
+     * \return QList<QByteArray> Responses (without the read terminator), one per query. Queries that did not receive a response have an empty entry.
+     */
+    virtual QList<QByteArray> queryBatch(const QStringList cmds, bool suppressError = false);
+    void setMaxBatchSize(int n) { d_maxBatchSize = qMax(1,n); }
+    int maxBatchSize() const { return d_maxBatchSize; }
+
+    /*!
+     * \brief Number of write/read exchanges performed by queryCmd() and queryBatch()
+     */
+    quint64 roundTrips() const { return d_roundTrips; }
+
     const QString d_key;
 
     QIODevice *device() { return p_device; }
@@ -65,6 +89,8 @@ protected:
     QByteArray d_readTerminator; /*!< Termination characters that indicate a message from the device is complete. */
     bool d_useTermChar; /*!< If true, a read operation is complete when the message ends with d_readTerminator */
     int d_timeOut; /*!< Timeout for read operation, in ms */
+    int d_maxBatchSize{32}; /*!< Maximum number of queries written at once by queryBatch() */
+    quint64 d_roundTrips{0};
 
     virtual bool testConnection() =0;
 
@@ -24,6 +24,8 @@ bool TcpInstrument::testConnection()
     SettingsStorage s(d_key,SettingsStorage::Hardware);
     d_ip = s.get<QString>(ip,"");
     d_port = s.get<int>(port,5000);
+    d_lowDelay = s.get<bool>(lowDelay,true);
+    d_receiveBufferKB = s.get<int>(receiveBufferKB,0);
 
 	return connectSocket();
 
@@ -87,7 +89,11 @@ bool TcpInstrument::connectSocket()
         d_errorString = QString("Could not connect to %1:%2. %3").arg(d_ip).arg(d_port).arg(p_device->errorString());
         return false;
     }
+    //socket options only take effect once the socket exists, so they are applied on every connection
     p_socket->setSocketOption(QAbstractSocket::KeepAliveOption,1);
+    p_socket->setSocketOption(QAbstractSocket::LowDelayOption,d_lowDelay ? 1 : 0);
+    if(d_receiveBufferKB > 0)
+        p_socket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption,d_receiveBufferKB*1024);
 
     return true;
 }
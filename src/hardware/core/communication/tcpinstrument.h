@@ -8,6 +8,8 @@
 namespace BC::Key::TCP {
 static const QString ip{"ip"};
 static const QString port{"port"};
+static const QString lowDelay{"lowDelay"};
+static const QString receiveBufferKB{"receiveBufferKB"};
 }
 
 class TcpInstrument : public CommunicationProtocol
@@ -28,6 +30,8 @@ public slots:
 private:
     QString d_ip;
     int d_port;
+    bool d_lowDelay{true};
+    int d_receiveBufferKB{0};
 
     bool connectSocket();
     void disconnectSocket();
@@ -1,5 +1,73 @@
 #include <hardware/core/communication/virtualinstrument.h>
 
+#include <QThread>
+#include <cstring>
+
+LatencySimulator::LatencySimulator(int latencyMs, const QByteArray terminator, Responder r, QObject *parent) :
+    QIODevice(parent), d_latencyMs(qMax(0,latencyMs)), d_terminator(terminator), d_respond(r)
+{
+    if(!d_respond)
+        d_respond = [](const QByteArray &msg){ return msg; };
+
+    d_clock.start();
+}
+
+qint64 LatencySimulator::bytesAvailable() const
+{
+    return d_readable.size() + QIODevice::bytesAvailable();
+}
+
+bool LatencySimulator::waitForReadyRead(int msecs)
+{
+    if(d_inFlight.isEmpty())
+        return false;
+
+    auto wait = d_arrivalMs - d_clock.elapsed();
+    if(wait > msecs)
+    {
+        QThread::msleep(static_cast<unsigned long>(qMax(0,msecs)));
+        return false;
+    }
+
+    if(wait > 0)
+        QThread::msleep(static_cast<unsigned long>(wait));
+
+    d_readable.append(d_inFlight);
+    d_inFlight.clear();
+    emit readyRead();
+    return true;
+}
+
+qint64 LatencySimulator::readData(char *data, qint64 maxlen)
+{
+    auto n = qMin(maxlen,static_cast<qint64>(d_readable.size()));
+    memcpy(data,d_readable.constData(),static_cast<size_t>(n));
+    d_readable.remove(0,static_cast<int>(n));
+    return n;
+}
+
+qint64 LatencySimulator::writeData(const char *data, qint64 len)
+{
+    d_incoming.append(data,static_cast<int>(len));
+
+    bool queued = false;
+    int idx = d_incoming.indexOf(d_terminator);
+    while(idx >= 0)
+    {
+        d_inFlight.append(d_respond(d_incoming.left(idx)));
+        d_inFlight.append(d_terminator);
+        d_incoming.remove(0,idx+d_terminator.size());
+        d_messages++;
+        queued = true;
+        idx = d_incoming.indexOf(d_terminator);
+    }
+
+    if(queued)
+        d_arrivalMs = d_clock.elapsed() + d_latencyMs;
+
+    return len;
+}
+
 VirtualInstrument::VirtualInstrument(QString key, QObject *parent) :
     CommunicationProtocol(key,parent)
 {
@@ -11,6 +79,16 @@ VirtualInstrument::~VirtualInstrument()
 
 }
 
+void VirtualInstrument::simulateLatency(int latencyMs, const QByteArray terminator, LatencySimulator::Responder r)
+{
+    if(p_device)
+        p_device->deleteLater();
+
+    p_device = new LatencySimulator(latencyMs,terminator,r,this);
+    p_device->open(QIODevice::ReadWrite|QIODevice::Unbuffered);
+    setReadOptions(qMax(d_timeOut,10*latencyMs),true,terminator);
+}
+
 void VirtualInstrument::initialize()
 {
 }
@@ -3,6 +3,50 @@
 
 #include <hardware/core/communication/communicationprotocol.h>
 
+#include <QIODevice>
+#include <QElapsedTimer>
+#include <functional>
+
+/*!
+ * \brief In-memory device that answers messages after a fixed link latency
+ *
+ * Every message written to the device (delimited by the terminator) is passed to a responder
+ * function, and the reply, followed by the terminator, becomes readable one latency period after
+ * the write. All messages in a single write share the same latency, as they would on a serial
+ * or network link where the transit time dominates, so the device can be used to measure how
+ * many round trips a sequence of commands costs.
+ */
+class LatencySimulator : public QIODevice
+{
+    Q_OBJECT
+public:
+    using Responder = std::function<QByteArray(const QByteArray&)>;
+
+    LatencySimulator(int latencyMs, const QByteArray terminator, Responder r, QObject *parent = nullptr);
+
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override;
+    qint64 bytesToWrite() const override { return 0; }
+    bool waitForReadyRead(int msecs) override;
+    bool waitForBytesWritten(int msecs) override { Q_UNUSED(msecs) return true; }
+
+    int messagesReceived() const { return d_messages; }
+
+protected:
+    qint64 readData(char *data, qint64 maxlen) override;
+    qint64 writeData(const char *data, qint64 len) override;
+
+private:
+    const int d_latencyMs;
+    const QByteArray d_terminator;
+    Responder d_respond;
+
+    QElapsedTimer d_clock;
+    QByteArray d_incoming, d_inFlight, d_readable;
+    qint64 d_arrivalMs{0};
+    int d_messages{0};
+};
+
 class VirtualInstrument : public CommunicationProtocol
 {
     Q_OBJECT
@@ -10,6 +54,18 @@ public:
     explicit VirtualInstrument(QString key, QObject *parent = nullptr);
     ~VirtualInstrument();
 
+    /*!
+     * \brief Routes commands through a LatencySimulator instead of discarding them
+     *
+     * Intended for benchmarking the number of round trips used by a command sequence.
+     * The read terminator is set to the simulator's terminator.
+     *
+     * \param latencyMs Time between a write and the arrival of its responses
+     * \param terminator Message terminator, used for both commands and responses
+     * \param r Produces the response to each command. If empty, commands are echoed back.
+     */
+    void simulateLatency(int latencyMs, const QByteArray terminator = QByteArray("\n"), LatencySimulator::Responder r = LatencySimulator::Responder());
+
 public slots:
     void initialize() override;
     bool testConnection() override;
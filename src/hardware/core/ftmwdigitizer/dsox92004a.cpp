@@ -75,7 +75,6 @@ void DSOx92004A::initialize()
 {
     p_comm->setReadOptions(1000,true,QByteArray("\n"));
     p_socket = dynamic_cast<QTcpSocket*>(p_comm->device());
-    p_socket->setSocketOption(QAbstractSocket::LowDelayOption,1);
 
 }
 
@@ -354,6 +353,8 @@ void DSOx92004A::beginAcquisition()
 {
     if(d_enabledForExperiment)
     {
+        d_parser.reset();
+        d_parser.setExpectedBytes(static_cast<qint64>(d_bytesPerPoint)*d_recordLength*d_numRecords);
         connect(p_socket,&QTcpSocket::readyRead,this,&DSOx92004A::readWaveform);
         p_comm->writeCmd(QString(":SYSTEM:GUI OFF;:DIGITIZE;*OPC?\n"));
 //        p_queryTimer->start(100);
@@ -369,6 +370,7 @@ void DSOx92004A::endAcquisition()
 //        p_queryTimer->stop();
         p_comm->writeCmd(QString("*CLS\n"));
         p_comm->writeCmd(QString(":SYSTEM:GUI ON\n"));
+        clearBufferPool();
     }
 }
 
@@ -384,6 +386,7 @@ void DSOx92004A::readWaveform()
 
         //grab waveform data directly from socket;
 //        p_queryTimer->stop();
+        d_parser.reset();
         p_comm->writeCmd(QString(":WAVEFORM:DATA?\n"));
 
         connect(p_socket, &QTcpSocket::readyRead, this, &DSOx92004A::retrieveData);
@@ -394,26 +397,15 @@ void DSOx92004A::readWaveform()
 
 void DSOx92004A::retrieveData()
 {
-    qint64 bytes = d_bytesPerPoint*d_recordLength*d_numRecords;
-
-    if(p_socket->bytesAvailable() < bytes+2)
+    //parse the block as it arrives; the parser keeps its place between readyRead signals
+    QByteArray out;
+    if(!d_parser.read(p_socket,out,[this](int n){ return acquireBuffer(n); }))
         return;
 
     disconnect(p_socket, &QTcpSocket::readyRead, this, &DSOx92004A::retrieveData);
 
-    char c = 0;
-    bool gc = false;
-    do
-    {
-        gc = p_socket->getChar(&c);
-    } while(c != '#' && gc);
-
-    if(c != '#') //how would this happen?
-        return;
-
-
-    QByteArray out = p_socket->read(bytes);
     emit shotAcquired(out);
+    releaseBuffer(out);
 
     p_socket->readAll();
 
@@ -2,6 +2,7 @@
 #define DSOX92004A_H
 
 #include <hardware/core/ftmwdigitizer/ftmwscope.h>
+#include <hardware/core/communication/blockdataparser.h>
 
 class QTcpSocket;
 
@@ -37,6 +38,7 @@ private:
     bool scopeCommand(QString cmd);
 
     bool d_acquiring;
+    BlockDataParser d_parser;
 };
 
 #endif // DSOX92004A_H
@@ -3,7 +3,8 @@
 FtmwScope::FtmwScope(const QString subKey, const QString name, CommunicationProtocol::CommType commType, QObject *parent, bool threaded, bool critical) :
     HardwareObject(BC::Key::FtmwScope::ftmwScope,subKey,name,commType,parent,threaded,critical)
 {
-
+    d_bufferPoolSize = qBound(2,getOrSetDefault(BC::Key::FtmwScope::bufferPoolSize,4).toInt(),64);
+    d_bufferPool.reserve(d_bufferPoolSize);
 }
 
 FtmwScope::~FtmwScope()
@@ -19,3 +20,38 @@ QStringList FtmwScope::forbiddenKeys() const
 {
     return {BC::Key::Digi::numAnalogChannels, BC::Key::Digi::numDigitalChannels};
 }
+
+QByteArray FtmwScope::acquireBuffer(int bytes)
+{
+    //newest buffers are at the back and are most likely to still be in cache
+    for(int i=d_bufferPool.size()-1; i>=0; --i)
+    {
+        auto &b = d_bufferPool[i];
+        if(b.isDetached() && b.size() == bytes)
+            return d_bufferPool.takeAt(i);
+    }
+
+    //either the pool is empty, a receiver is still holding on to the buffers, or the
+    //waveform size changed. Drop any buffers of the wrong size and allocate a new one
+    for(int i=d_bufferPool.size()-1; i>=0; --i)
+    {
+        if(d_bufferPool.at(i).size() != bytes)
+            d_bufferPool.removeAt(i);
+    }
+
+    return QByteArray(bytes,Qt::Uninitialized);
+}
+
+void FtmwScope::releaseBuffer(QByteArray &b)
+{
+    if(d_bufferPool.size() < d_bufferPoolSize)
+        d_bufferPool.append(b);
+
+    b.clear();
+}
+
+void FtmwScope::clearBufferPool()
+{
+    d_bufferPool.clear();
+    d_bufferPool.reserve(d_bufferPoolSize);
+}
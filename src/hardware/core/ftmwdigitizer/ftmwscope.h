@@ -4,6 +4,7 @@
 #include <hardware/core/hardwareobject.h>
 
 #include <QByteArray>
+#include <QVector>
 
 #include <data/experiment/ftmwconfig.h>
 #include <hardware/core/ftmwdigitizer/ftmwdigitizerconfig.h>
@@ -12,6 +13,7 @@
 namespace BC::Key::FtmwScope {
 static const QString ftmwScope{"FtmwDigitizer"};
 static const QString bandwidth{"bandwidthMHz"};
+static const QString bufferPoolSize{"bufferPoolSize"};
 }
 
 class FtmwScope : public HardwareObject, protected FtmwDigitizerConfig
@@ -31,6 +33,26 @@ public slots:
     // HardwareObject interface
 public slots:
     QStringList forbiddenKeys() const override;
+
+protected:
+    /*!
+     * \brief Returns a waveform buffer of the requested size for the driver to fill in place
+     *
+     * Buffers are recycled through a small pool. A pooled buffer is only handed out once every
+     * receiver of shotAcquired has released its reference to it, so writing through data() never
+     * detaches, and once the pool is warm no heap allocation occurs. If no buffer is free, a new
+     * one is allocated. Each buffer must be handed back with releaseBuffer() after emitting it.
+     *
+     * \param bytes Size of the buffer
+     * \return QByteArray Buffer of size bytes (contents are undefined)
+     */
+    QByteArray acquireBuffer(int bytes);
+    void releaseBuffer(QByteArray &b);
+    void clearBufferPool();
+
+private:
+    QVector<QByteArray> d_bufferPool;
+    int d_bufferPoolSize;
 };
 
 #if BC_FTMWSCOPE == 0
@@ -1,6 +1,7 @@
 #include "m4i2220x8.h"
 
 #include <math.h>
+#include <cstring>
 
 
 using namespace BC::Key::FtmwScope;
@@ -266,7 +267,7 @@ bool M4i2220x8::prepareForExperiment(Experiment &exp)
     QByteArray errText(1000,'\0');
     if(spcm_dwGetErrorInfo_i32(p_handle,NULL,NULL,errText.data()) != ERR_OK)
     {
-        exp.d_errorString = QString("Could not initialize %1. Error message: %2").arg(d_name).arg(QString::fromLatin1(errText));
+        exp.setErrorString(QString("Could not initialize %1. Error message: %2").arg(d_name).arg(QString::fromLatin1(errText)));
         spcm_dwInvalidateBuf(p_handle,SPCM_BUF_DATA);
         delete[] p_m4iBuffer;
         return false;
@@ -315,6 +316,7 @@ void M4i2220x8::endAcquisition()
         spcm_dwSetParam_i32(p_handle,SPC_M2CMD,M2CMD_DATA_STOPDMA);
         spcm_dwInvalidateBuf(p_handle,SPCM_BUF_DATA);
         delete[] p_m4iBuffer;
+        clearBufferPool();
 
         d_waveformBytes = 0;
     }
@@ -348,28 +350,24 @@ void M4i2220x8::readWaveform()
         //are enough bytes available to make a waveform?
         if(ba >= d_waveformBytes || stat & M2STAT_DATA_END)
         {
-            //transfer data into a QByteArray
-            QByteArray out;
-            out.resize(d_waveformBytes);
+            //transfer data into a pooled buffer
+            auto out = acquireBuffer(d_waveformBytes);
 
             //get current position
             qint64 pos = 0;
             spcm_dwGetParam_i64(p_handle,SPC_DATA_AVAIL_USER_POS,&pos);
 
-            //copy data; rolling over at end of buffer if necessary
-            for(int i=0; i<d_waveformBytes; i++)
-            {
-                int thisPos = i + pos;
-                if(thisPos >= d_bufferSize)
-                    thisPos -= d_bufferSize;
-
-                out[i] = p_m4iBuffer[thisPos];
-            }
+            //copy data in (at most) two segments, rolling over at end of ring buffer if necessary
+            qint64 first = qMin(d_waveformBytes,d_bufferSize - pos);
+            memcpy(out.data(),p_m4iBuffer + pos,first);
+            if(first < d_waveformBytes)
+                memcpy(out.data() + first,p_m4iBuffer,d_waveformBytes - first);
 
             //tell m4i that it can use this memory again
             spcm_dwSetParam_i64(p_handle,SPC_DATA_AVAIL_CARD_LEN,d_waveformBytes);
 
             emit shotAcquired(out);
+            releaseBuffer(out);
         }
     }
 
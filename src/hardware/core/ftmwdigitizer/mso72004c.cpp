@@ -9,8 +9,7 @@ using namespace BC::Key::Digi;
 
 MSO72004C::MSO72004C(QObject *parent) :
     FtmwScope(mso72004c,mso72004cName,CommunicationProtocol::Tcp,parent),
-    d_waitingForReply(false), d_foundHeader(false),
-    d_headerNumBytes(0), d_waveformBytes(0)
+    d_waitingForReply(false)
 {
     setDefault(numAnalogChannels,4);
     setDefault(numDigitalChannels,0);
@@ -79,7 +78,6 @@ void MSO72004C::initialize()
     p_comm->setReadOptions(1000,true,QByteArray("\n"));
     p_socket = dynamic_cast<QTcpSocket*>(p_comm->device());
     connect(p_socket,static_cast<void (QTcpSocket::*)(QAbstractSocket::SocketError)>(&QTcpSocket::errorOccurred),this,&MSO72004C::socketError);
-    p_socket->setSocketOption(QAbstractSocket::LowDelayOption,1);
 }
 
 bool MSO72004C::prepareForExperiment(Experiment &exp)
@@ -572,9 +570,8 @@ void MSO72004C::beginAcquisition()
 
         p_comm->writeCmd(QString(":CURVESTREAM?\n"));
         d_waitingForReply = true;
-        d_foundHeader = false;
-        d_headerNumBytes = 0;
-        d_waveformBytes = 0;
+        d_parser.reset();
+        d_parser.setExpectedBytes(static_cast<qint64>(d_recordLength)*d_bytesPerPoint*(d_multiRecord ? d_numRecords : 1));
 
         p_scopeTimeout->stop();
         p_scopeTimeout->start(10000);
@@ -607,9 +604,8 @@ void MSO72004C::endAcquisition()
         p_comm->writeCmd(QString(":UNLOCK ALL;:DISPLAY:WAVEFORM ON\n"));
 
         d_waitingForReply = false;
-        d_foundHeader = false;
-        d_headerNumBytes = 0;
-        d_waveformBytes = 0;
+        d_parser.reset();
+        clearBufferPool();
     }
 }
 
@@ -618,104 +614,22 @@ void MSO72004C::readWaveform()
     if(!d_waitingForReply) // if for some reason the readyread signal weren't disconnected, don't eat all the bytes
         return;
 
-    qint64 ba = p_socket->bytesAvailable();
-//    emit logMessage(QString("Bytes available: %1\t%2 ms").arg(ba).arg(QTime::currentTime().msec()));
-
     //waveforms are returned from the scope in the format #xyyyyyyy<data>\n
-    //the reply starts with the '#' character
-    //the next byte (x) is a hex digit that tells how many bytes of header information follow
-    //yyyyyy is an ASCII sequence of x numbers that tells how many data bytes the waveform contains
-    //<data> is the actual data block
-    //the final character is an ASCII newline
-
-    if(!d_foundHeader) //here, we start looking for a block data header, which starts with '#'
-    {
-//        emit consoleMessage(tr("Looking for header, BA %1, %2  %3").arg(ba).arg(scope->peek(ba).toHex().constData()).arg(scope->peek(ba).constData()));
-//        emit consoleMessage(tr("Looking for header, BA %1").arg(ba));
-        char c=0;
-        qint64 i=0;
-        while(i<ba && !d_foundHeader)
-        {
-            p_socket->getChar(&c);
-            if(c=='#')
-            {
-                d_foundHeader = true;
-                p_scopeTimeout->stop();
-                p_scopeTimeout->start(10000);
-//                emit logMessage(QString("Found hdr: %1 ms").arg(QTime::currentTime().msec()));
-            }
-            i++;
-        }
-    }
-
-    if(d_foundHeader && d_headerNumBytes == 0) //we've found the header hash, now get the number of header bytes
+    //(see BlockDataParser). The parser keeps its place between calls, and reads the
+    //data straight into the pooled buffer as they arrive.
+    QByteArray wfm;
+    bool progress = false;
+    while(d_parser.read(p_socket,wfm,[this](int n){ return acquireBuffer(n); }))
     {
-        //make sure the entire header can be read
-        if(p_socket->bytesAvailable())
-        {
-            //there is a header byte ready. Read it and set the number of remaining header bytes
-            char c=0;
-            p_socket->getChar(&c);
-            QString hdrNum = QString::fromLatin1(&c,1);
-            bool ok = false;
-            int nb = hdrNum.toInt(&ok,16);
-            if(!ok || nb < 1 || nb > 15)
-            {
-                //it's possible that we're in the middle of an old waveform by fluke.
-                //continue looking for '#'
-                d_foundHeader = false;
-                if(p_socket->bytesAvailable())
-                    readWaveform();
-
-                return;
-            }
-            d_headerNumBytes = nb;
-        }
-        else
-            return;
+        progress = true;
+        emit shotAcquired(wfm);
+        releaseBuffer(wfm);
     }
 
-    if(d_foundHeader && d_headerNumBytes > 0 && d_waveformBytes == 0) //header hash and number of header bytes read, need to read # wfm bytes
+    if(progress || d_parser.inBlock())
     {
-        if(p_socket->bytesAvailable() >= d_headerNumBytes)
-        {
-            QByteArray wfmBytes = p_socket->read(d_headerNumBytes);
-            bool ok = false;
-            int b = wfmBytes.toInt(&ok);
-            int nf = 1;
-            if(d_multiRecord)
-                nf = d_numRecords;
-            if(!ok || b != d_recordLength*d_bytesPerPoint*nf)
-            {
-                //it's possible that we're in the middle of an old waveform by fluke.
-                //continue looking for '#'
-                d_foundHeader = false;
-                d_headerNumBytes = 0;
-                if(p_socket->bytesAvailable())
-                    readWaveform();
-
-                return;
-            }
-            d_waveformBytes = b;
-        }
-        else
-            return;
-    }
-
-    if(d_foundHeader && d_headerNumBytes > 0 && d_waveformBytes > 0) // waiting to read waveform data
-    {
-        if(p_socket->bytesAvailable() >= d_waveformBytes) // whole waveform can be read!
-        {
-            QByteArray wfm = p_socket->read(d_waveformBytes);
-//            emit logMessage(QString("Wfm read complete: %1 ms").arg(QTime::currentTime().msec()));
-            emit shotAcquired(wfm);
-            d_foundHeader = false;
-            d_headerNumBytes = 0;
-            d_waveformBytes = 0;
-            return;
-        }
-        else
-            return;
+        p_scopeTimeout->stop();
+        p_scopeTimeout->start(10000);
     }
 }
 
@@ -2,6 +2,7 @@
 #define MSO72004C_H
 
 #include <hardware/core/ftmwdigitizer/ftmwscope.h>
+#include <hardware/core/communication/blockdataparser.h>
 
 #include <QTimer>
 #include <QAbstractSocket>
@@ -37,9 +38,7 @@ protected:
 
 private:
     bool d_waitingForReply;
-    bool d_foundHeader;
-    int d_headerNumBytes;
-    int d_waveformBytes;
+    BlockDataParser d_parser;
     QTimer *p_scopeTimeout;
 
     QByteArray scopeQueryCmd(QString query);
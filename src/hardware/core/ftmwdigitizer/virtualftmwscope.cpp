@@ -105,21 +105,18 @@ void VirtualFtmwScope::beginAcquisition()
 void VirtualFtmwScope::endAcquisition()
 {
     d_simulatedTimer->stop();
+    clearBufferPool();
 }
 
 void VirtualFtmwScope::readWaveform()
 {
     //    d_testTime.restart();
-        QByteArray out;
-
         int frames = 1;
         if(d_multiRecord)
-        {
             frames = d_numRecords;
-            out.resize(d_recordLength*d_bytesPerPoint*frames);
-        }
-        else
-            out.resize(d_recordLength*d_bytesPerPoint);
+
+        auto out = acquireBuffer(d_recordLength*d_bytesPerPoint*frames);
+        auto dp = out.data();
 
 
         double ym = yMult(d_fidChannel);
@@ -135,7 +132,7 @@ void VirtualFtmwScope::readWaveform()
                 {
                     int noise = (rand()%32)-16;
                     qint8 n = qBound(-128,((int)(dat/ym)+noise),127);
-                    out[d_recordLength*i + j] = n;
+                    dp[d_recordLength*i + j] = n;
                 }
                 else
                 {
@@ -153,11 +150,12 @@ void VirtualFtmwScope::readWaveform()
                         byte1 = (n & 0xff00) >> 8;
                         byte2 = (n & 0x00ff);
                     }
-                    out[d_recordLength*2*i + 2*j] = byte1;
-                    out[d_recordLength*2*i + 2*j + 1] = byte2;
+                    dp[d_recordLength*2*i + 2*j] = byte1;
+                    dp[d_recordLength*2*i + 2*j + 1] = byte2;
                 }
             }
         }
     //    emit logMessage(QString("Simulate: %1 ms").arg(d_testTime.elapsed()));
         emit shotAcquired(out);
+        releaseBuffer(out);
 }
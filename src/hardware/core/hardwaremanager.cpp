@@ -3,6 +3,7 @@
 #include <hardware/core/hardwareobject.h>
 #include <hardware/core/ftmwdigitizer/ftmwscope.h>
 #include <hardware/core/clock/clockmanager.h>
+#include <acquisition/shotqueue.h>
 #include <hardware/optional/chirpsource/awg.h>
 #include <hardware/optional/pulsegenerator/pulsegenerator.h>
 #include <hardware/optional/flowcontroller/flowcontroller.h>
@@ -12,6 +13,10 @@
 #include <hardware/optional/tempcontroller/temperaturecontroller.h>
 
 #include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QDeadlineTimer>
+#include <QElapsedTimer>
 
 #ifdef BC_LIF
 #include <modules/lif/hardware/lifdigitizer/lifscope.h>
@@ -25,7 +30,11 @@ HardwareManager::HardwareManager(QObject *parent) : QObject(parent), SettingsSto
 {
     //Required hardware: FtmwScope and Clocks
     auto ftmwScope = new FtmwScopeHardware;
-    connect(ftmwScope,&FtmwScope::shotAcquired,this,&HardwareManager::ftmwScopeShotAcquired);
+    //runs in the scope's thread so that the shot is copied into the queue without an event loop hop
+    connect(ftmwScope,&FtmwScope::shotAcquired,this,[this](const QByteArray b){
+        if(!ps_ftmwShotQueue || !ps_ftmwShotQueue->push(b))
+            emit ftmwScopeShotAcquired(b);
+    },Qt::DirectConnection);
     d_hardwareMap.emplace(ftmwScope->d_key,ftmwScope);
 
     pu_clockManager = std::make_unique<ClockManager>();
@@ -292,27 +301,13 @@ void HardwareManager::sleep(bool b)
 
 void HardwareManager::initializeExperiment(std::shared_ptr<Experiment> exp)
 {
+    d_retuneTiming.clear();
+
     //do initialization
     bool success = pu_clockManager->prepareForExperiment(*exp);
 
-    if(success) {
-        for(auto it = d_hardwareMap.cbegin(); it != d_hardwareMap.cend(); ++it)
-        {
-            auto obj = it->second;
-            if(obj->thread() != QThread::currentThread())
-                QMetaObject::invokeMethod(obj,[obj,exp](){
-                    return obj->prepareForExperiment(*exp);
-                },Qt::BlockingQueuedConnection,&success);
-            else
-                success = obj->prepareForExperiment(*exp);
-
-            if(!success)
-            {
-                emit logMessage(QString("Error initializing %1").arg(obj->d_name),LogHandler::Error);
-                break;
-            }
-        }
-    }
+    if(success)
+        success = prepareHardware(exp);
 
     exp->d_hardwareSuccess = success;
     exp->d_hardware = currentHardware();
@@ -337,8 +332,105 @@ void HardwareManager::initializeExperiment(std::shared_ptr<Experiment> exp)
 
 }
 
+bool HardwareManager::prepareHardware(std::shared_ptr<Experiment> exp)
+{
+    //objects are prepared one stage at a time (see HardwareObject::prepareStage).
+    //Within a stage, every object's prepareForExperiment is started at once in its own thread;
+    //objects that share a thread (GPIB, or unthreaded objects) are handled in turn by that thread
+    std::map<int,std::vector<HardwareObject*>> stages;
+    for(auto &[key,obj] : d_hardwareMap)
+    {
+        Q_UNUSED(key)
+        stages[obj->prepareStage()].push_back(obj);
+    }
+
+    struct PrepareResult {
+        bool done{false};
+        bool success{false};
+        qint64 elapsedMs{0};
+    };
+
+    //shared with the prepare calls, which may outlive this function if they time out
+    struct PrepareSync {
+        QMutex mutex;
+        QWaitCondition finished;
+    };
+    auto sync = std::make_shared<PrepareSync>();
+
+    for(auto &[stage,objs] : stages)
+    {
+        Q_UNUSED(stage)
+        std::vector<std::shared_ptr<PrepareResult>> results;
+        QElapsedTimer stageTimer;
+        stageTimer.start();
+
+        auto prepare = [exp,sync](HardwareObject *obj, std::shared_ptr<PrepareResult> r){
+            QElapsedTimer t;
+            t.start();
+            bool ok = obj->prepareForExperiment(*exp);
+
+            QMutexLocker l(&sync->mutex);
+            r->success = ok;
+            r->elapsedMs = t.elapsed();
+            r->done = true;
+            sync->finished.wakeAll();
+        };
+
+        std::vector<std::size_t> local;
+        for(std::size_t i=0; i<objs.size(); ++i)
+        {
+            auto obj = objs.at(i);
+            auto r = std::make_shared<PrepareResult>();
+            results.push_back(r);
+            if(obj->thread() != QThread::currentThread())
+                QMetaObject::invokeMethod(obj,[obj,r,prepare](){ prepare(obj,r); },Qt::QueuedConnection);
+            else
+                local.push_back(i);
+        }
+
+        //objects that live in this thread are prepared while the others are working
+        for(auto i : local)
+            prepare(objs.at(i),results.at(i));
+
+        bool success = true;
+        QMutexLocker l(&sync->mutex);
+        for(std::size_t i=0; i<objs.size(); ++i)
+        {
+            auto obj = objs.at(i);
+            auto &r = results.at(i);
+            QDeadlineTimer deadline(qMax(0ll,obj->prepareTimeoutSec()*1000ll - stageTimer.elapsed()));
+            while(!r->done)
+            {
+                if(!sync->finished.wait(&sync->mutex,deadline))
+                    break;
+            }
+
+            if(!r->done)
+            {
+                emit logMessage(QString("Timed out initializing %1 (limit: %2 s)").arg(obj->d_name).arg(obj->prepareTimeoutSec()),LogHandler::Error);
+                success = false;
+            }
+            else if(!r->success)
+            {
+                emit logMessage(QString("Error initializing %1").arg(obj->d_name),LogHandler::Error);
+                success = false;
+            }
+            else
+                emit logMessage(QString("Initialized %1 in %2 ms").arg(obj->d_name).arg(r->elapsedMs),LogHandler::Debug);
+        }
+
+        if(!success)
+            return false;
+    }
+
+    return true;
+}
+
 void HardwareManager::experimentComplete()
 {
+    if(d_retuneTiming.count() > 0)
+        emit logMessage(d_retuneTiming.summary());
+
 #ifdef BC_LIF
     auto ll = findHardware<LifLaser>(BC::Key::LifLaser::key);
     if(ll)
@@ -407,9 +499,12 @@ void HardwareManager::configureClocks(QHash<RfConfig::ClockType, RfConfig::Clock
 
 void HardwareManager::setClocks(QHash<RfConfig::ClockType, RfConfig::ClockFreq> clocks)
 {
-
-    for(auto it = clocks.begin(); it != clocks.end(); ++it)
-        it.value().desiredFreqMHz = pu_clockManager->setClockFrequency(it.key(),it.value().desiredFreqMHz);
+    QElapsedTimer t;
+    t.start();
+    pu_clockManager->setClockFrequencies(clocks);
+    auto ms = t.nsecsElapsed()/1e6;
+    d_retuneTiming.add(ms);
+    emit logMessage(QString("Clocks retuned in %1 ms").arg(ms,0,'f',1),LogHandler::Debug);
 
     emit allClocksReady(clocks);
 }
@@ -630,12 +725,24 @@ void HardwareManager::setLifParameters(double delay, double pos)
         return;
     }
 
+    //a threaded laser starts moving before the delay is set, so that the motion overlaps the
+    //pulse generator communication. Completion (and any delay failure) is then reported when
+    //the laser responds in lifLaserSetComplete.
+    bool overlap = ll->thread() != QThread::currentThread();
+    d_lifDelayOk = true;
+    if(overlap)
+        setLifLaserPos(pos);
+
     auto pGen = findHardware<PulseGenerator>(BC::Key::PGen::key);
     if(pGen)
     {
         if(!setPGenLifDelay(delay))
             success = false;
     }
+    d_lifDelayOk = success;
+
+    if(overlap)
+        return;
 
     if(success)
         setLifLaserPos(pos);
@@ -679,7 +786,7 @@ void HardwareManager::setLifLaserPos(double pos)
 
 void HardwareManager::lifLaserSetComplete(double pos)
 {
-    emit lifSettingsComplete(pos > 0.0);
+    emit lifSettingsComplete(pos > 0.0 && d_lifDelayOk);
 }
 
 void HardwareManager::startLifConfigAcq(const LifDigitizerConfig &c)
@@ -7,6 +7,7 @@
 #include <data/storage/auxdatastorage.h>
 #include <data/storage/settingsstorage.h>
 #include <data/experiment/rfconfig.h>
+#include <data/analysis/timinghistogram.h>
 
 #include <hardware/optional/flowcontroller/flowconfig.h>
 #include <hardware/optional/pulsegenerator/pulsegenconfig.h>
@@ -20,6 +21,7 @@
 class HardwareObject;
 class ClockManager;
 class Experiment;
+class ShotQueue;
 
 namespace BC::Key {
 static const QString hw{"hardware"};
@@ -33,6 +35,14 @@ public:
     explicit HardwareManager(QObject *parent = 0);
     ~HardwareManager();
 
+    /*!
+     * \brief Routes FTMW scope shots into a ShotQueue instead of the ftmwScopeShotAcquired signal
+     *
+     * Must be called before the hardware threads are started. Shots are pushed from the scope's
+     * thread; ftmwScopeShotAcquired is still emitted if the queue rejects a shot (e.g., it is closed).
+     */
+    void setFtmwShotQueue(std::shared_ptr<ShotQueue> q) { ps_ftmwShotQueue = q; }
+
 signals:
     void logMessage(QString,LogHandler::MessageCode = LogHandler::Normal);
     void statusMessage(QString,int=0);
@@ -164,9 +174,15 @@ public:
 private:
     std::size_t d_responseCount{0};
     void checkStatus();
+    bool prepareHardware(std::shared_ptr<Experiment> exp);
 
     std::map<QString,HardwareObject*> d_hardwareMap;
     std::unique_ptr<ClockManager> pu_clockManager;
+    std::shared_ptr<ShotQueue> ps_ftmwShotQueue;
+    TimingHistogram d_retuneTiming{"Clock retune"};
+#ifdef BC_LIF
+    bool d_lifDelayOk{true};
+#endif
 
     template<class T>
     T* findHardware(const QString key) const {
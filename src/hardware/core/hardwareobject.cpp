@@ -15,6 +15,7 @@ HardwareObject::HardwareObject(const QString key, const QString subKey, const QS
     set(BC::Key::HW::key,d_key); set(BC::Key::HW::name,d_name);
     setDefault(BC::Key::HW::critical,critical);
     setDefault(BC::Key::HW::rInterval,0);
+    setDefault(BC::Key::HW::prepareTimeout,30);
     save();
 
     //it is necessary to write the subKey one level above the SettingsStorage group, which
@@ -26,6 +27,7 @@ HardwareObject::HardwareObject(const QString key, const QString subKey, const QS
     s.sync();
 
     d_critical = get(BC::Key::HW::critical,true);
+    d_prepareTimeoutSec = qMax(1,get(BC::Key::HW::prepareTimeout,30));
 }
 
 HardwareObject::~HardwareObject()
@@ -120,6 +122,8 @@ void HardwareObject::buildCommunication(QObject *gc)
         break;
     case CommunicationProtocol::Tcp:
         p_comm = new TcpInstrument(d_key,this);
+        setDefault(BC::Key::TCP::lowDelay,true);
+        setDefault(BC::Key::TCP::receiveBufferKB,8192);
         break;
 #ifdef BC_GPIBCONTROLLER
     case CommunicationProtocol::Gpib:
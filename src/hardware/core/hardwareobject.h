@@ -29,6 +29,8 @@ static const QString critical{"critical"};
 static const QString threaded{"threaded"};
 static const QString commType{"commType"};
 static const QString rInterval{"rollingDataIntervalSec"};
+static const QString prepareTimeout{"prepareTimeoutSec"};
+static const QString batchQueries{"batchQueries"};
 }
 
 /*!
@@ -101,6 +103,25 @@ public:
     bool isConnected() const { return d_isConnected; }
 
     virtual QStringList validationKeys() const { return {}; }
+
+    /*!
+     * \brief Ordering of prepareForExperiment() among hardware objects
+     *
+     * The HardwareManager prepares objects in order of increasing stage, and all objects in the same
+     * stage are prepared at the same time in their own threads. Objects whose preparation depends
+     * on another object (e.g., anything that needs the final clock frequencies) must have a higher
+     * stage than that object. Clocks use stage 0; everything else defaults to 1.
+     *
+     * \return int Stage
+     */
+    virtual int prepareStage() const { return 1; }
+
+    /*!
+     * \brief How long the HardwareManager waits for prepareForExperiment(), in seconds
+     *
+     * Set with the prepareTimeoutSec setting (default 30 s).
+     */
+    int prepareTimeoutSec() const { return d_prepareTimeoutSec; }
 	
 signals:
     /*!
@@ -172,6 +193,7 @@ private:
 
     bool d_isConnected;
     int d_rollingDataTimerId{-1};
+    int d_prepareTimeoutSec{30};
 
 
 	
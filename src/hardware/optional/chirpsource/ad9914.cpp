@@ -138,7 +138,7 @@ bool AD9914::prepareForExperiment(Experiment &exp)
     QByteArray resp = p_comm->queryCmd(QString("IN\n"));
     if(!resp.startsWith(QByteArray("SUCCESS")))
     {
-        exp.d_errorString = QString("Could not initialize %1").arg(d_name);
+        exp.setErrorString(QString("Could not initialize %1").arg(d_name));
         emit hardwareFailure();
         return false;
     }
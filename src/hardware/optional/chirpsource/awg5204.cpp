@@ -59,7 +59,7 @@ bool AWG5204::prepareForExperiment(Experiment &exp)
 
     if(wfmName.startsWith(QChar('!')))
     {
-        exp.d_errorString = wfmName.mid(1);
+        exp.setErrorString(wfmName.mid(1));
         emit hardwareFailure();
         return false;
     }
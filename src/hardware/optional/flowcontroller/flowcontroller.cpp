@@ -20,13 +20,17 @@ FlowController::~FlowController()
 
 void FlowController::setAll(const FlowConfig &c)
 {
+    //write everything first, then read it all back at once
     for(int i=0; i<c.size(); ++i)
     {
         setChannelName(i,c.setting(i,FlowConfig::Name).toString());
-        setFlowSetpoint(i,c.setting(i,FlowConfig::Setpoint).toDouble());
+        if(i < d_numChannels)
+            hwSetFlowSetpoint(i,c.setting(i,FlowConfig::Setpoint).toDouble());
     }
-    setPressureSetpoint(c.pressureSetpoint());
-    setPressureControlMode(c.pressureControlMode());
+    hwSetPressureSetpoint(c.pressureSetpoint());
+    hwSetPressureControlMode(c.pressureControlMode());
+
+    readAll();
 }
 
 void FlowController::initialize()
@@ -107,23 +111,12 @@ void FlowController::readFlowSetpoint(const int ch)
         emit logMessage(QString("Invalid flow channel (%1) requested. Valid channels are 0-%2").arg(ch).arg(d_numChannels));
         return;
     }
-    double sp = hwReadFlowSetpoint(ch);
-    if(sp > -1e-10)
-    {
-        d_config.set(ch,FlowConfig::Setpoint,sp);
-        emit flowSetpointUpdate(ch,sp,QPrivateSignal());
-    }
+    applyFlowSetpoint(ch,hwReadFlowSetpoint(ch));
 }
 
 void FlowController::readPressureSetpoint()
 {
-    double sp = hwReadPressureSetpoint();
-    if(sp > -1e-10)
-    {
-        d_config.setPressureSetpoint(sp);
-        emit pressureSetpointUpdate(sp,QPrivateSignal());
-    }
-
+    applyPressureSetpoint(hwReadPressureSetpoint());
 }
 
 void FlowController::readFlow(const int ch)
@@ -133,7 +126,21 @@ void FlowController::readFlow(const int ch)
         emit logMessage(QString("Invalid flow channel (%1) requested. Valid channels are 0-%2").arg(ch).arg(d_numChannels-1));
         return;
     }
-    double flow = hwReadFlow(ch);
+    applyFlow(ch,hwReadFlow(ch));
+}
+
+void FlowController::readPressure()
+{
+    applyPressure(hwReadPressure());
+}
+
+void FlowController::readPressureControlMode()
+{
+    applyPressureControlMode(hwReadPressureControlMode());
+}
+
+void FlowController::applyFlow(const int ch, const double flow)
+{
     if(flow>-1.0)
     {
         d_config.set(ch,FlowConfig::Flow,flow);
@@ -141,9 +148,17 @@ void FlowController::readFlow(const int ch)
     }
 }
 
-void FlowController::readPressure()
+void FlowController::applyFlowSetpoint(const int ch, const double sp)
+{
+    if(sp > -1e-10)
+    {
+        d_config.set(ch,FlowConfig::Setpoint,sp);
+        emit flowSetpointUpdate(ch,sp,QPrivateSignal());
+    }
+}
+
+void FlowController::applyPressure(const double pressure)
 {
-    double pressure = hwReadPressure();
     if(pressure > -1.0)
     {
         d_config.setPressure(pressure);
@@ -151,14 +166,38 @@ void FlowController::readPressure()
     }
 }
 
-void FlowController::readPressureControlMode()
+void FlowController::applyPressureSetpoint(const double sp)
+{
+    if(sp > -1e-10)
+    {
+        d_config.setPressureSetpoint(sp);
+        emit pressureSetpointUpdate(sp,QPrivateSignal());
+    }
+}
+
+void FlowController::applyPressureControlMode(const int mode)
 {
-    int ret = hwReadPressureControlMode();
-    if(ret < 0)
+    if(mode < 0)
         return;
 
-    d_config.setPressureControlMode(ret==1);
-    emit pressureControlMode(ret==1,QPrivateSignal());
+    d_config.setPressureControlMode(mode==1);
+    emit pressureControlMode(mode==1,QPrivateSignal());
+}
+
+FlowController::Readings FlowController::hwReadAll()
+{
+    Readings out;
+    for(int i=0; i<d_numChannels; i++)
+    {
+        out.flow.append(hwReadFlow(i));
+        out.setpoint.append(hwReadFlowSetpoint(i));
+    }
+
+    out.pressureSetpoint = hwReadPressureSetpoint();
+    out.pressure = hwReadPressure();
+    out.pressureControlMode = hwReadPressureControlMode();
+
+    return out;
 }
 
 void FlowController::poll()
@@ -168,15 +207,16 @@ void FlowController::poll()
 
 void FlowController::readAll()
 {
-    for(int i=0; i<d_config.size(); i++)
+    auto r = hwReadAll();
+    for(int i=0; i<d_config.size() && i<r.flow.size() && i<r.setpoint.size(); i++)
     {
-        readFlow(i);
-        readFlowSetpoint(i);
+        applyFlow(i,r.flow.at(i));
+        applyFlowSetpoint(i,r.setpoint.at(i));
     }
 
-    readPressureSetpoint();
-    readPressure();
-    readPressureControlMode();
+    applyPressureSetpoint(r.pressureSetpoint);
+    applyPressure(r.pressure);
+    applyPressureControlMode(r.pressureControlMode);
 }
 
 AuxDataStorage::AuxDataMap FlowController::readAuxData()
@@ -29,6 +29,14 @@ class FlowController : public HardwareObject
 {
     Q_OBJECT
 public:
+    struct Readings {
+        QVector<double> flow;
+        QVector<double> setpoint;
+        double pressure{-1.0};
+        double pressureSetpoint{-1.0};
+        int pressureControlMode{-1};
+    };
+
     FlowController(const QString subKey, const QString name, CommunicationProtocol::CommType commType,
                    QObject *parent = nullptr, bool threaded = false, bool critical = false);
     virtual ~FlowController();
@@ -68,6 +76,23 @@ private:
     virtual double hwReadPressure() =0;
     virtual int hwReadPressureControlMode() =0;
 
+    /*!
+     * \brief Reads every flow, setpoint, and the pressure state
+     *
+     * The default implementation calls the individual hwRead functions. Drivers that can send
+     * several queries in one exchange should override this. Values that could not be read
+     * should be left negative.
+     *
+     * \return Readings Current values
+     */
+    virtual Readings hwReadAll();
+
+    void applyFlow(const int ch, const double flow);
+    void applyFlowSetpoint(const int ch, const double sp);
+    void applyPressure(const double pressure);
+    void applyPressureSetpoint(const double sp);
+    void applyPressureControlMode(const int mode);
+
     FlowConfig d_config;
     QTimer *p_readTimer;
     const int d_numChannels;
@@ -24,6 +24,9 @@ Mks946::Mks946(QObject *parent) :
     setDefault(pMax,10.0);
     setDefault(pDec,3);
 
+    //pipelined queries are not documented for the 946, so they must be enabled explicitly
+    setDefault(BC::Key::HW::batchQueries,false);
+
 }
 
 
@@ -37,6 +40,7 @@ bool Mks946::fcTestConnection()
     }
 
     emit logMessage(QString("Response: %1").arg(QString(resp)));
+    d_useBatch = get(BC::Key::HW::batchQueries,false);
     return true;
 }
 
@@ -140,7 +144,82 @@ double Mks946::hwReadFlowSetpoint(const int ch)
     if(!isConnected())
         return 0.0;
 
-    QByteArray resp = mksQuery(QString("RRQ%1?").arg(ch+get(offset,1)));
+    return parseFlowSetpoint(ch,mksQuery(QString("RRQ%1?").arg(ch+get(offset,1))));
+}
+
+double Mks946::hwReadPressureSetpoint()
+{
+    if(!isConnected())
+        return 0.0;
+
+    return parsePressureSetpoint(mksQuery(QString("RPSP?")));
+}
+
+double Mks946::hwReadFlow(const int ch)
+{
+    if(!isConnected())
+        return 0.0;
+
+    return parseFlow(ch,mksQuery(QString("FR%1?").arg(ch+get(offset,1))));
+}
+
+double Mks946::hwReadPressure()
+{
+    if(!isConnected())
+        return 0.0;
+
+    return parsePressure(mksQuery(QString("PR%1?").arg(get(pressureChannel,5))));
+}
+
+FlowController::Readings Mks946::hwReadAll()
+{
+    Readings out;
+    int n = get(flowChannels,4);
+    if(!isConnected())
+    {
+        out.flow.fill(0.0,n);
+        out.setpoint.fill(0.0,n);
+        out.pressure = 0.0;
+        out.pressureSetpoint = 0.0;
+        return out;
+    }
+
+    if(!d_useBatch)
+        return FlowController::hwReadAll();
+
+    int o = get(offset,1);
+    QStringList cmds;
+    for(int i=0; i<n; ++i)
+        cmds << QString("FR%1?").arg(i+o) << QString("RRQ%1?").arg(i+o);
+    cmds << QString("RPSP?") << QString("PR%1?").arg(get(pressureChannel,5)) << QString("PID?");
+
+    auto resp = mksQueryBatch(cmds);
+    for(auto &r : resp)
+    {
+        //a missing reply means the unit did not keep up with pipelined queries; stop batching
+        //until the next connection test rather than waiting out the timeout on every read
+        if(r.isEmpty())
+        {
+            d_useBatch = false;
+            emit logMessage(QString("No reply to a batched query. Sending queries one at a time until the next connection test."),LogHandler::Warning);
+            return FlowController::hwReadAll();
+        }
+    }
+
+    for(int i=0; i<n; ++i)
+    {
+        out.flow.append(parseFlow(i,resp.at(2*i)));
+        out.setpoint.append(parseFlowSetpoint(i,resp.at(2*i+1)));
+    }
+    out.pressureSetpoint = parsePressureSetpoint(resp.at(2*n));
+    out.pressure = parsePressure(resp.at(2*n+1));
+    out.pressureControlMode = parsePressureControlMode(resp.at(2*n+2));
+
+    return out;
+}
+
+double Mks946::parseFlowSetpoint(const int ch, const QByteArray resp)
+{
     bool ok = false;
     double out = resp.mid(2).toDouble(&ok);
     if(!ok)
@@ -153,12 +232,8 @@ double Mks946::hwReadFlowSetpoint(const int ch)
     return out;
 }
 
-double Mks946::hwReadPressureSetpoint()
+double Mks946::parsePressureSetpoint(const QByteArray resp)
 {
-    if(!isConnected())
-        return 0.0;
-
-    QByteArray resp = mksQuery(QString("RPSP?"));
     bool ok = false;
     double out = resp.mid(2).toDouble(&ok);
     if(!ok)
@@ -171,12 +246,8 @@ double Mks946::hwReadPressureSetpoint()
     return out/1000.0; // convert to kTorr
 }
 
-double Mks946::hwReadFlow(const int ch)
+double Mks946::parseFlow(const int ch, const QByteArray resp)
 {
-    if(!isConnected())
-        return 0.0;
-
-    QByteArray resp = mksQuery(QString("FR%1?").arg(ch+get(offset,1)));
     if(resp.contains(QByteArray("MISCONN")))
         return 0.0;
 
@@ -192,12 +263,8 @@ double Mks946::hwReadFlow(const int ch)
     return out;
 }
 
-double Mks946::hwReadPressure()
+double Mks946::parsePressure(const QByteArray resp)
 {
-    if(!isConnected())
-        return 0.0;
-
-    QByteArray resp = mksQuery(QString("PR%1?").arg(get(pressureChannel,5)));
     if(resp.contains(QByteArray("LO")))
         return 0.0;
 
@@ -289,7 +356,11 @@ int Mks946::hwReadPressureControlMode()
     {
         return -1;
     }
-    QByteArray resp = mksQuery(QString("PID?"));
+    return parsePressureControlMode(mksQuery(QString("PID?")));
+}
+
+int Mks946::parsePressureControlMode(const QByteArray resp)
+{
     if(resp.contains(QByteArray("ON")))
         return 1;
     else if(resp.contains(QByteArray("OFF")))
@@ -344,6 +415,26 @@ QByteArray Mks946::mksQuery(QString cmd)
     return resp.mid(7);
 }
 
+QList<QByteArray> Mks946::mksQueryBatch(QStringList cmds)
+{
+    int a = get(address,253);
+    auto prefix = QString("@%1").arg(a,3,10,QChar('0'));
+    for(auto &c : cmds)
+        c = QString("%1%2;FF").arg(prefix).arg(c);
+
+    //errors are not reported here; a missing reply makes hwReadAll fall back to single queries
+    auto out = p_comm->queryBatch(cmds,true);
+    auto ack = QString("%1ACK").arg(prefix).toLatin1();
+    for(auto &r : out)
+    {
+        //chop off prefix
+        if(r.startsWith(ack))
+            r = r.mid(7);
+    }
+
+    return out;
+}
+
 void Mks946::sleep(bool b)
 {
     if(b)
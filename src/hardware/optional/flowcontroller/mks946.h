@@ -37,6 +37,14 @@ protected:
     void fcInitialize() override;
     bool mksWrite(QString cmd);
     QByteArray mksQuery(QString cmd);
+    QList<QByteArray> mksQueryBatch(QStringList cmds);
+    Readings hwReadAll() override;
+
+    double parseFlowSetpoint(const int ch, const QByteArray resp);
+    double parsePressureSetpoint(const QByteArray resp);
+    double parseFlow(const int ch, const QByteArray resp);
+    double parsePressure(const QByteArray resp);
+    int parsePressureControlMode(const QByteArray resp);
 
     // HardwareObject interface
 public slots:
@@ -44,6 +52,7 @@ public slots:
 
 private:
     int d_nextRead;
+    bool d_useBatch{false};
 };
 
 #endif // MKS947_H
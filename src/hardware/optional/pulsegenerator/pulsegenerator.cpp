@@ -2,6 +2,8 @@
 
 #include <gui/widget/pulseconfigwidget.h>
 
+#include <QMetaEnum>
+
 PulseGenerator::PulseGenerator(const QString subKey, const QString name, CommunicationProtocol::CommType commType, int numChannels, QObject *parent, bool threaded, bool critical) :
     HardwareObject(BC::Key::PGen::key,subKey,name,commType,parent,threaded,critical),
     d_numChannels(numChannels)
@@ -44,44 +46,33 @@ bool PulseGenerator::prepareForExperiment(Experiment &exp)
 
 void PulseGenerator::readChannel(const int index)
 {
-    auto c = settings(index);
-
-    bool success = true;
+    auto cc = settings(index);
+    if(!readChSettings(index,cc))
+    {
+        emit logMessage(QString("Could not read settings for channel %1").arg(index),LogHandler::Error);
+        return;
+    }
 
-    auto w = readChWidth(index);
-    success &= (w <= get<double>(BC::Key::PGen::maxWidth) && w >= get<double>(BC::Key::PGen::minWidth));
-    if(!success)
+    if(cc.width > get<double>(BC::Key::PGen::maxWidth) || cc.width < get<double>(BC::Key::PGen::minWidth))
     {
         emit logMessage(QString("Could not read width for channel %1").arg(index),LogHandler::Error);
         return;
     }
 
-    auto d = readChDelay(index);
-    success &= (d <= get<double>(BC::Key::PGen::maxDelay) && d >= get<double>(BC::Key::PGen::minDelay));
-    if(!success)
+    if(cc.delay > get<double>(BC::Key::PGen::maxDelay) || cc.delay < get<double>(BC::Key::PGen::minDelay))
     {
         emit logMessage(QString("Could not read delay for channel %1").arg(index),LogHandler::Error);
         return;
     }
 
-    auto en = readChEnabled(index);
-    auto level = readChActiveLevel(index);
-    auto mode = readChMode(index);
-    auto sync = readChSynchCh(index);
-    auto dutyOn = readChDutyOn(index);
-    auto dutyOff = readChDutyOff(index);
-
-    if(success)
-    {
-        setCh(index,PulseGenConfig::WidthSetting,w);
-        setCh(index,PulseGenConfig::DelaySetting,d);
-        setCh(index,PulseGenConfig::EnabledSetting,en);
-        setCh(index,PulseGenConfig::LevelSetting,level);
-        setCh(index,PulseGenConfig::ModeSetting,mode);
-        setCh(index,PulseGenConfig::SyncSetting,sync);
-        setCh(index,PulseGenConfig::DutyOnSetting,dutyOn);
-        setCh(index,PulseGenConfig::DutyOffSetting,dutyOff);
-    }
+    setCh(index,PulseGenConfig::WidthSetting,cc.width);
+    setCh(index,PulseGenConfig::DelaySetting,cc.delay);
+    setCh(index,PulseGenConfig::EnabledSetting,cc.enabled);
+    setCh(index,PulseGenConfig::LevelSetting,cc.level);
+    setCh(index,PulseGenConfig::ModeSetting,cc.mode);
+    setCh(index,PulseGenConfig::SyncSetting,cc.syncCh);
+    setCh(index,PulseGenConfig::DutyOnSetting,cc.dutyOn);
+    setCh(index,PulseGenConfig::DutyOffSetting,cc.dutyOff);
 
 }
 
@@ -121,11 +112,8 @@ bool PulseGenerator::readPulseEnabled()
 
 bool PulseGenerator::setPGenSetting(const int index, const PulseGenConfig::Setting s, const QVariant val)
 {
-    if(index >= d_channels.size())
-    {
-        emit logMessage(QString("Received invalid channel (%1). Allowed values: 0-%2").arg(index).arg(d_channels.size()-1),LogHandler::Error);
+    if(!validateSetting(index,s,val))
         return false;
-    }
 
     bool success = true;
     QVariant result = val;
@@ -134,176 +122,49 @@ bool PulseGenerator::setPGenSetting(const int index, const PulseGenConfig::Setti
     case PulseGenConfig::RoleSetting:
         break;
     case PulseGenConfig::LevelSetting:
-    {
-        auto level = val.value<PulseGenConfig::ActiveLevel>();
-        success = setChActiveLevel(index,level);
-        auto a = readChActiveLevel(index);
-        if(a == level)
-            result = a;
-        else
-            success = false;
-
+        success = setChActiveLevel(index,val.value<PulseGenConfig::ActiveLevel>());
+        if(success)
+            result = readChActiveLevel(index);
         break;
-    }
     case PulseGenConfig::EnabledSetting:
-    {
-        auto en = val.toBool();
-        success = setChEnabled(index,en);
-        en = readChEnabled(index);
-        if(en == val.toBool())
-            result = en;
-        else
-            success = false;
+        success = setChEnabled(index,val.toBool());
+        if(success)
+            result = readChEnabled(index);
         break;
-    }
     case PulseGenConfig::WidthSetting:
-    {
-        auto w = val.toDouble();
-        auto min = get<double>(BC::Key::PGen::minWidth);
-        auto max = get<double>(BC::Key::PGen::maxWidth);
-        if((w < min) || (w > max))
-        {
-            success = false;
-            emit logMessage(QString("Requested width (%1) for channel %2 is outside the allowed range (%3 - %4)").arg(w,0,'e',2).arg(index).arg(min,0,'e',2).arg(max,0,'e',2),LogHandler::Error);
-        }
-        else
-        {
-            success = setChWidth(index,w);
-            if(success)
-            {
-                double newW = readChWidth(index);
-                if(fabs(newW - w) <= min)
-                    result = newW;
-                else
-                    success = false;
-
-            }
-        }
+        success = setChWidth(index,val.toDouble());
+        if(success)
+            result = readChWidth(index);
         break;
-    }
     case PulseGenConfig::DelaySetting:
-    {
-        auto d = val.toDouble();
-        auto min = get<double>(BC::Key::PGen::minDelay);
-        auto max = get<double>(BC::Key::PGen::maxDelay);
-        if((d < min) || (d > max))
-        {
-            success = false;
-            emit logMessage(QString("Requested delay (%1) for channel %2 is outside the allowed range (%3 - %4)").arg(d,0,'e',2).arg(index).arg(min,0,'e',2).arg(max,0,'e',2),LogHandler::Error);
-        }
-        else
-        {
-            success = setChDelay(index,d);
-            if(success)
-            {
-                double newD = readChDelay(index);
-                if(fabs(newD - d) <= min)
-                    result = newD;
-                else
-                    success = false;
-
-            }
-        }
+        success = setChDelay(index,val.toDouble());
+        if(success)
+            result = readChDelay(index);
         break;
-    }
     case PulseGenConfig::ModeSetting:
-    {
-        auto d = val.value<PulseGenConfig::ChannelMode>();
-        auto ok = get(BC::Key::PGen::canDutyCycle,false);
-        if(!ok && d == PulseGenConfig::DutyCycle)
-        {
-            success = false;
-            emit logMessage("Duty cycle mode is not supported.",LogHandler::Error);
-        }
-        else
-        {
-            success = setChMode(index,d);
-            if(success)
-            {
-                auto m = readChMode(index);
-                if(m == d)
-                    result = m;
-                else
-                    success = false;
-            }
-        }
+        success = setChMode(index,val.value<PulseGenConfig::ChannelMode>());
+        if(success)
+            result = readChMode(index);
         break;
-    }
     case PulseGenConfig::SyncSetting:
-    {
-        auto d = val.toInt();
-        auto ok = get(BC::Key::PGen::canSyncToChannel,false);
-        if(!ok && d != 0)
-        {
-            success = false;
-            emit logMessage(QString("Syncing one channel to another is not supported."),LogHandler::Error);
-        }
-        else if (d < 0 || d > d_numChannels)
-        {
-            success = false;
-            emit logMessage(QString("Requested sync channel (%1) is invalid").arg(d),LogHandler::Error);
-        }
-        else
-        {
-            success = setChSyncCh(index,d);
-            if(success)
-            {
-                auto ch = readChSynchCh(index);
-                if(d == ch)
-                    result = ch;
-                else
-                    success = false;
-            }
-        }
+        success = setChSyncCh(index,val.toInt());
+        if(success)
+            result = readChSynchCh(index);
         break;
-    }
     case PulseGenConfig::DutyOnSetting:
-    {
-        auto d = val.toInt();
-        auto max = get(BC::Key::PGen::dutyMax,1000);
-        if(d<1 || d > max)
-        {
-            success = false;
-            emit logMessage(QString("Requested number of duty cycle on pulses (%1) exceeds the maximum limit of %2.").arg(d).arg(max),LogHandler::Error);
-        }
-        else
-        {
-            success = setChDutyOn(index,d);
-            if(success)
-            {
-                auto dd = readChDutyOn(index);
-                if(d == dd)
-                    result = dd;
-                else
-                    success = false;
-            }
-        }
+        success = setChDutyOn(index,val.toInt());
+        if(success)
+            result = readChDutyOn(index);
         break;
-    }
     case PulseGenConfig::DutyOffSetting:
-    {
-        auto d = val.toInt();
-        auto max = get(BC::Key::PGen::dutyMax,1000);
-        if(d<1 || d > max)
-        {
-            success = false;
-            emit logMessage(QString("Requested number of duty cycle off pulses (%1) exceeds the maximum limit of %2.").arg(d).arg(max),LogHandler::Error);
-        }
-        else
-        {
-            success = setChDutyOff(index,d);
-            if(success)
-            {
-                auto dd = readChDutyOff(index);
-                if(d == dd)
-                    result = dd;
-                else
-                    success = false;
-            }
-        }
+        success = setChDutyOff(index,val.toInt());
+        if(success)
+            result = readChDutyOff(index);
         break;
     }
-    }
+
+    if(success)
+        success = settingMatches(s,val,result);
 
     if(success)
     {
@@ -317,30 +178,59 @@ bool PulseGenerator::setPGenSetting(const int index, const PulseGenConfig::Setti
 
 bool PulseGenerator::setChannel(const int index, const PulseGenConfig::ChannelConfig &cc)
 {
-    bool success = true;
+    if(index >= d_channels.size())
+    {
+        emit logMessage(QString("Received invalid channel (%1). Allowed values: 0-%2").arg(index).arg(d_channels.size()-1),LogHandler::Error);
+        return false;
+    }
 
-    blockSignals(true);
-    success &= setPGenSetting(index,PulseGenConfig::NameSetting,cc.channelName);
-    if(success)
-        success &= setPGenSetting(index,PulseGenConfig::EnabledSetting,cc.enabled);
-    if(success)
-        success &= setPGenSetting(index,PulseGenConfig::DelaySetting,cc.delay);
-    if(success)
-        success &= setPGenSetting(index,PulseGenConfig::WidthSetting,cc.width);
-    if(success)
-        success &= setPGenSetting(index,PulseGenConfig::LevelSetting,cc.level);
-    if(success)
-        setPGenSetting(index,PulseGenConfig::RoleSetting,cc.role);
-    if(success)
-        success &= setPGenSetting(index,PulseGenConfig::ModeSetting,cc.mode);
-    if(success)
-        success &= setPGenSetting(index,PulseGenConfig::SyncSetting,cc.syncCh);
+    const std::vector<std::pair<PulseGenConfig::Setting,QVariant>> hw {
+        {PulseGenConfig::EnabledSetting,cc.enabled},
+        {PulseGenConfig::DelaySetting,cc.delay},
+        {PulseGenConfig::WidthSetting,cc.width},
+        {PulseGenConfig::LevelSetting,cc.level},
+        {PulseGenConfig::ModeSetting,cc.mode},
+        {PulseGenConfig::SyncSetting,cc.syncCh},
+        {PulseGenConfig::DutyOnSetting,cc.dutyOn},
+        {PulseGenConfig::DutyOffSetting,cc.dutyOff}
+    };
+
+    for(auto &[s,v] : hw)
+    {
+        if(!validateSetting(index,s,v))
+            return false;
+    }
+
+    setCh(index,PulseGenConfig::NameSetting,cc.channelName);
+    setCh(index,PulseGenConfig::RoleSetting,cc.role);
+
+    //write everything, then read everything back, so that drivers can batch each step
+    bool success = setChSettings(index,cc);
+    auto rb = cc;
     if(success)
-        success &= setPGenSetting(index,PulseGenConfig::DutyOnSetting,cc.dutyOn);
+        success = readChSettings(index,rb);
+
     if(success)
-        success &= setPGenSetting(index,PulseGenConfig::DutyOffSetting,cc.dutyOff);
+    {
+        const std::vector<QVariant> actual {
+            rb.enabled, rb.delay, rb.width, rb.level, rb.mode,
+            rb.syncCh, rb.dutyOn, rb.dutyOff
+        };
+        for(std::size_t i=0; i<hw.size(); ++i)
+        {
+            auto s = hw.at(i).first;
+            if(!settingMatches(s,hw.at(i).second,actual.at(i)))
+            {
+                emit logMessage(QString("Channel %1 setting %2 did not take effect (requested %3, read back %4)")
+                                .arg(index).arg(QMetaEnum::fromType<PulseGenConfig::Setting>().valueToKey(s))
+                                .arg(hw.at(i).second.toString()).arg(actual.at(i).toString()),LogHandler::Error);
+                success = false;
+                break;
+            }
+            setCh(index,s,actual.at(i));
+        }
+    }
 
-    blockSignals(false);
     if(success)
         emit configUpdate(static_cast<PulseGenConfig>(*this),QPrivateSignal());
 
@@ -445,6 +335,123 @@ void PulseGenerator::readAll()
     emit configUpdate(static_cast<PulseGenConfig&>(*this),QPrivateSignal());
 }
 
+bool PulseGenerator::validateSetting(const int index, const PulseGenConfig::Setting s, const QVariant val)
+{
+    if(index < 0 || index >= d_channels.size())
+    {
+        emit logMessage(QString("Received invalid channel (%1). Allowed values: 0-%2").arg(index).arg(d_channels.size()-1),LogHandler::Error);
+        return false;
+    }
+
+    switch(s) {
+    case PulseGenConfig::WidthSetting:
+    {
+        auto w = val.toDouble();
+        auto min = get<double>(BC::Key::PGen::minWidth);
+        auto max = get<double>(BC::Key::PGen::maxWidth);
+        if((w < min) || (w > max))
+        {
+            emit logMessage(QString("Requested width (%1) for channel %2 is outside the allowed range (%3 - %4)").arg(w,0,'e',2).arg(index).arg(min,0,'e',2).arg(max,0,'e',2),LogHandler::Error);
+            return false;
+        }
+        break;
+    }
+    case PulseGenConfig::DelaySetting:
+    {
+        auto d = val.toDouble();
+        auto min = get<double>(BC::Key::PGen::minDelay);
+        auto max = get<double>(BC::Key::PGen::maxDelay);
+        if((d < min) || (d > max))
+        {
+            emit logMessage(QString("Requested delay (%1) for channel %2 is outside the allowed range (%3 - %4)").arg(d,0,'e',2).arg(index).arg(min,0,'e',2).arg(max,0,'e',2),LogHandler::Error);
+            return false;
+        }
+        break;
+    }
+    case PulseGenConfig::ModeSetting:
+        if(!get(BC::Key::PGen::canDutyCycle,false) && val.value<PulseGenConfig::ChannelMode>() == PulseGenConfig::DutyCycle)
+        {
+            emit logMessage("Duty cycle mode is not supported.",LogHandler::Error);
+            return false;
+        }
+        break;
+    case PulseGenConfig::SyncSetting:
+    {
+        auto d = val.toInt();
+        if(!get(BC::Key::PGen::canSyncToChannel,false) && d != 0)
+        {
+            emit logMessage(QString("Syncing one channel to another is not supported."),LogHandler::Error);
+            return false;
+        }
+        if (d < 0 || d > d_numChannels)
+        {
+            emit logMessage(QString("Requested sync channel (%1) is invalid").arg(d),LogHandler::Error);
+            return false;
+        }
+        break;
+    }
+    case PulseGenConfig::DutyOnSetting:
+    case PulseGenConfig::DutyOffSetting:
+    {
+        auto d = val.toInt();
+        auto max = get(BC::Key::PGen::dutyMax,1000);
+        if(d<1 || d > max)
+        {
+            emit logMessage(QString("Requested number of duty cycle %1 pulses (%2) exceeds the maximum limit of %3.")
+                            .arg(s == PulseGenConfig::DutyOnSetting ? "on" : "off").arg(d).arg(max),LogHandler::Error);
+            return false;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+
+    return true;
+}
+
+bool PulseGenerator::settingMatches(const PulseGenConfig::Setting s, const QVariant requested, const QVariant actual)
+{
+    switch(s) {
+    case PulseGenConfig::NameSetting:
+    case PulseGenConfig::RoleSetting:
+        return true;
+    case PulseGenConfig::WidthSetting:
+        return fabs(actual.toDouble() - requested.toDouble()) <= get<double>(BC::Key::PGen::minWidth);
+    case PulseGenConfig::DelaySetting:
+        return fabs(actual.toDouble() - requested.toDouble()) <= get<double>(BC::Key::PGen::minDelay);
+    case PulseGenConfig::EnabledSetting:
+        return actual.toBool() == requested.toBool();
+    default:
+        return actual.toInt() == requested.toInt();
+    }
+}
+
+bool PulseGenerator::readChSettings(const int index, PulseGenConfig::ChannelConfig &cc)
+{
+    cc.width = readChWidth(index);
+    cc.delay = readChDelay(index);
+    cc.enabled = readChEnabled(index);
+    cc.level = readChActiveLevel(index);
+    cc.mode = readChMode(index);
+    cc.syncCh = readChSynchCh(index);
+    cc.dutyOn = readChDutyOn(index);
+    cc.dutyOff = readChDutyOff(index);
+
+    return !isnan(cc.width) && !isnan(cc.delay);
+}
+
+bool PulseGenerator::setChSettings(const int index, const PulseGenConfig::ChannelConfig &cc)
+{
+    return setChEnabled(index,cc.enabled)
+            && setChDelay(index,cc.delay)
+            && setChWidth(index,cc.width)
+            && setChActiveLevel(index,cc.level)
+            && setChMode(index,cc.mode)
+            && setChSyncCh(index,cc.syncCh)
+            && setChDutyOn(index,cc.dutyOn)
+            && setChDutyOff(index,cc.dutyOff);
+}
 
 QStringList PulseGenerator::forbiddenKeys() const
 {
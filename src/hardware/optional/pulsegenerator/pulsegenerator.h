@@ -87,8 +87,35 @@ protected:
     virtual double readHwRepRate() =0;
     virtual bool readHwPulseEnabled() =0;
 
+    /*!
+     * \brief Reads all hardware settings of a channel
+     *
+     * The default implementation calls each readCh function in turn. Drivers that can send
+     * several queries in one exchange should override this.
+     *
+     * \param index Channel index
+     * \param cc Receives the settings; name and role are left unchanged
+     * \return bool True if the settings were read
+     */
+    virtual bool readChSettings(const int index, PulseGenConfig::ChannelConfig &cc);
+
+    /*!
+     * \brief Writes all hardware settings of a channel, without reading them back
+     *
+     * The default implementation calls each setCh function in turn, stopping at the first failure.
+     *
+     * \param index Channel index
+     * \param cc Settings to write. The values have already been validated.
+     * \return bool True if all settings were written
+     */
+    virtual bool setChSettings(const int index, const PulseGenConfig::ChannelConfig &cc);
+
     const int d_numChannels;
 
+private:
+    bool validateSetting(const int index, const PulseGenConfig::Setting s, const QVariant val);
+    bool settingMatches(const PulseGenConfig::Setting s, const QVariant requested, const QVariant actual);
+
     // HardwareObject interface
 public slots:
     QStringList forbiddenKeys() const override;
@@ -51,3 +51,12 @@ QByteArray Qc9214::pGenQueryCmd(QString cmd)
 {
     return p_comm->queryCmd(cmd.append(QString("\r\n")));
 }
+
+QList<QByteArray> Qc9214::pGenQueryBatch(QStringList cmds)
+{
+    for(auto &c : cmds)
+        c.append(QString("\r\n"));
+
+    //errors are not reported here; a missing reply makes the caller retry one query at a time
+    return p_comm->queryBatch(cmds,true);
+}
@@ -79,6 +79,15 @@ QByteArray Qc9518::pGenQueryCmd(QString cmd)
     return p_comm->queryCmd(cmd.append(QString("\n")));
 }
 
+QList<QByteArray> Qc9518::pGenQueryBatch(QStringList cmds)
+{
+    for(auto &c : cmds)
+        c.append(QString("\n"));
+
+    //errors are not reported here; a missing reply makes the caller retry one query at a time
+    return p_comm->queryBatch(cmds,true);
+}
+
 void Qc9518::beginAcquisition()
 {
     lockKeys(true);
@@ -54,4 +54,13 @@ QByteArray Qc9528::pGenQueryCmd(QString cmd)
     return p_comm->queryCmd(cmd.append(QString("\r\n")));
 }
 
+QList<QByteArray> Qc9528::pGenQueryBatch(QStringList cmds)
+{
+    for(auto &c : cmds)
+        c.append(QString("\r\n"));
+
+    //errors are not reported here; a missing reply makes the caller retry one query at a time
+    return p_comm->queryBatch(cmds,true);
+}
+
 
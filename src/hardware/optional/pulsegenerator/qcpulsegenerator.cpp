@@ -4,6 +4,8 @@
 
 QCPulseGenerator::QCPulseGenerator(const QString subKey, const QString name, CommunicationProtocol::CommType commType, int numChannels, QObject *parent, bool threaded, bool critical) : PulseGenerator(subKey,name,commType,numChannels,parent,threaded,critical)
 {
+    //pipelined queries are not documented for these units, so they must be enabled explicitly
+    setDefault(BC::Key::HW::batchQueries,false);
 }
 
 QCPulseGenerator::~QCPulseGenerator()
@@ -28,6 +30,7 @@ bool QCPulseGenerator::testConnection()
 
     emit logMessage(QString("ID response: %1").arg(QString(resp.trimmed())));
 
+    d_useBatch = get(BC::Key::HW::batchQueries,false);
     if(get(BC::Key::PGen::lockExternal,true))
     {
         if(!pGenWriteCmd(QString(":%1:ICL %2").arg(sysStr()).arg(clock10MHzStr())))
@@ -50,51 +53,42 @@ void QCPulseGenerator::sleep(bool b)
 
 bool QCPulseGenerator::setChWidth(const int index, const double width)
 {
-    return pGenWriteCmd(QString(":PULSE%1:WIDTH %2").arg(index+1).arg(width/1e6,0,'f',9));
+    return pGenWriteCmd(chCommand(index,PulseGenConfig::WidthSetting,width));
 }
 
 bool QCPulseGenerator::setChDelay(const int index, const double delay)
 {
-    return pGenWriteCmd(QString(":PULSE%1:DELAY %2").arg(index+1).arg(delay/1e6,0,'f',9));
+    return pGenWriteCmd(chCommand(index,PulseGenConfig::DelaySetting,delay));
 }
 
 bool QCPulseGenerator::setChActiveLevel(const int index, const ActiveLevel level)
 {
-    if(level == PulseGenConfig::ActiveHigh)
-        return pGenWriteCmd(QString(":PULSE%1:POLARITY NORM").arg(index+1));
-
-    return pGenWriteCmd(QString(":PULSE%1:POLARITY INV").arg(index+1));
+    return pGenWriteCmd(chCommand(index,PulseGenConfig::LevelSetting,level));
 }
 
 bool QCPulseGenerator::setChEnabled(const int index, const bool en)
 {
-    if(en)
-        return pGenWriteCmd(QString(":PULSE%1:STATE 1").arg(index+1));
-
-    return pGenWriteCmd(QString(":PULSE%1:STATE 0").arg(index+1));
+    return pGenWriteCmd(chCommand(index,PulseGenConfig::EnabledSetting,en));
 }
 
 bool QCPulseGenerator::setChSyncCh(const int index, const int syncCh)
 {
-    return pGenWriteCmd(QString(":PULSE%1:SYNC %2").arg(index+1).arg(d_channels.at(syncCh)));
+    return pGenWriteCmd(chCommand(index,PulseGenConfig::SyncSetting,syncCh));
 }
 
 bool QCPulseGenerator::setChMode(const int index, const ChannelMode mode)
 {
-    QString mstr("NORM");
-    if(mode == PulseGenConfig::DutyCycle)
-        mstr = QString("DCYC");
-    return pGenWriteCmd(QString(":PULSE%1:CMODE %2").arg(index+1).arg(mstr));
+    return pGenWriteCmd(chCommand(index,PulseGenConfig::ModeSetting,mode));
 }
 
 bool QCPulseGenerator::setChDutyOn(const int index, const int pulses)
 {
-    return pGenWriteCmd(QString(":PULSE%1:PCO %2").arg(index+1).arg(pulses));
+    return pGenWriteCmd(chCommand(index,PulseGenConfig::DutyOnSetting,pulses));
 }
 
 bool QCPulseGenerator::setChDutyOff(const int index, const int pulses)
 {
-    return pGenWriteCmd(QString(":PULSE%1:OCO %2").arg(index+1).arg(pulses));
+    return pGenWriteCmd(chCommand(index,PulseGenConfig::DutyOffSetting,pulses));
 }
 
 bool QCPulseGenerator::setHwPulseMode(PGenMode mode)
@@ -128,133 +122,272 @@ bool QCPulseGenerator::setHwPulseEnabled(bool en)
 
 double QCPulseGenerator::readChWidth(const int index)
 {
-    auto resp = pGenQueryCmd(QString(":PULSE%1:WIDTH?").arg(index+1));
-    if(!resp.isEmpty())
-    {
-        bool ok = false;
-        double val = resp.trimmed().toDouble(&ok)*1e6;
-        if(ok)
-            return val;
-    }
-
-    emit hardwareFailure();
-    emit logMessage(QString("Could not read channel %1 width. Response: %2").arg(index+1).arg(QString(resp)));
-    return nan("");
+    auto v = parseChResponse(index,PulseGenConfig::WidthSetting,pGenQueryCmd(chQuery(index,PulseGenConfig::WidthSetting)));
+    return v.isValid() ? v.toDouble() : nan("");
 }
 
 double QCPulseGenerator::readChDelay(const int index)
 {
-    auto resp = pGenQueryCmd(QString(":PULSE%1:DELAY?").arg(index+1));
-    if(!resp.isEmpty())
-    {
-        bool ok = false;
-        double val = resp.trimmed().toDouble(&ok)*1e6;
-        if(ok)
-            return val;
-    }
-
-    emit hardwareFailure();
-    emit logMessage(QString("Could not read channel %1 delay. Response: %2").arg(index+1).arg(QString(resp)));
-    return nan("");
+    auto v = parseChResponse(index,PulseGenConfig::DelaySetting,pGenQueryCmd(chQuery(index,PulseGenConfig::DelaySetting)));
+    return v.isValid() ? v.toDouble() : nan("");
 }
 
 PulseGenConfig::ActiveLevel QCPulseGenerator::readChActiveLevel(const int index)
 {
-    auto resp = pGenQueryCmd(QString(":PULSE%1:POLARITY?").arg(index+1));
-    if(!resp.isEmpty())
-    {
-        if(QString(resp).startsWith(QString("NORM"),Qt::CaseInsensitive))
-            return PulseGenConfig::ActiveHigh;
-        else if(QString(resp).startsWith(QString("INV"),Qt::CaseInsensitive))
-            return PulseGenConfig::ActiveLow;
-    }
-
-    emit hardwareFailure();
-    emit logMessage(QString("Could not read channel %1 active level. Response: %2").arg(index+1).arg(QString(resp)));
-    return PulseGenConfig::ActiveHigh;
+    auto v = parseChResponse(index,PulseGenConfig::LevelSetting,pGenQueryCmd(chQuery(index,PulseGenConfig::LevelSetting)));
+    return v.isValid() ? static_cast<ActiveLevel>(v.toInt()) : PulseGenConfig::ActiveHigh;
 }
 
 bool QCPulseGenerator::readChEnabled(const int index)
 {
-    auto resp = pGenQueryCmd(QString(":PULSE%1:STATE?").arg(index+1));
-    if(!resp.isEmpty())
-    {
-        bool ok = false;
-        int val = resp.trimmed().toInt(&ok);
-        if(ok)
-            return static_cast<bool>(val);
-    }
-
-    emit hardwareFailure();
-    emit logMessage(QString("Could not read channel %1 enabled state. Response: %2").arg(index+1).arg(QString(resp)));
-    return false;
+    auto v = parseChResponse(index,PulseGenConfig::EnabledSetting,pGenQueryCmd(chQuery(index,PulseGenConfig::EnabledSetting)));
+    return v.isValid() ? v.toBool() : false;
 }
 
 int QCPulseGenerator::readChSynchCh(const int index)
 {
-    auto resp = pGenQueryCmd(QString(":PULSE%1:SYNC?").arg(index+1));
-    if(!resp.isEmpty())
+    auto v = parseChResponse(index,PulseGenConfig::SyncSetting,pGenQueryCmd(chQuery(index,PulseGenConfig::SyncSetting)));
+    return v.isValid() ? v.toInt() : -1;
+}
+
+PulseGenConfig::ChannelMode QCPulseGenerator::readChMode(const int index)
+{
+    auto v = parseChResponse(index,PulseGenConfig::ModeSetting,pGenQueryCmd(chQuery(index,PulseGenConfig::ModeSetting)));
+    return v.isValid() ? static_cast<ChannelMode>(v.toInt()) : Normal;
+}
+
+int QCPulseGenerator::readChDutyOn(const int index)
+{
+    auto v = parseChResponse(index,PulseGenConfig::DutyOnSetting,pGenQueryCmd(chQuery(index,PulseGenConfig::DutyOnSetting)));
+    return v.isValid() ? v.toInt() : -1;
+}
+
+int QCPulseGenerator::readChDutyOff(const int index)
+{
+    auto v = parseChResponse(index,PulseGenConfig::DutyOffSetting,pGenQueryCmd(chQuery(index,PulseGenConfig::DutyOffSetting)));
+    return v.isValid() ? v.toInt() : -1;
+}
+
+bool QCPulseGenerator::readChSettings(const int index, PulseGenConfig::ChannelConfig &cc)
+{
+    const QVector<PulseGenConfig::Setting> order {
+        WidthSetting, DelaySetting, EnabledSetting, LevelSetting, ModeSetting, SyncSetting, DutyOnSetting, DutyOffSetting
+    };
+
+    if(!d_useBatch)
+        return PulseGenerator::readChSettings(index,cc);
+
+    QStringList cmds;
+    for(auto s : order)
+        cmds << chQuery(index,s);
+
+    auto resp = pGenQueryBatch(cmds);
+    if(batchFailed(resp))
+        return PulseGenerator::readChSettings(index,cc);
+
+    QVector<QVariant> v;
+    for(int i=0; i<order.size(); ++i)
     {
-        QString val = QString(resp.trimmed());
-        int idx = d_channels.indexOf(val);
-        if(idx >= 0)
-            return idx;
+        v << parseChResponse(index,order.at(i),resp.value(i));
+        if(!v.constLast().isValid())
+            return false;
     }
 
-    emit hardwareFailure();
-    emit logMessage(QString("Could not read channel %1 sync channel. Response: %2").arg(index+1).arg(QString(resp)));
-    return -1;
+    cc.width = v.at(0).toDouble();
+    cc.delay = v.at(1).toDouble();
+    cc.enabled = v.at(2).toBool();
+    cc.level = static_cast<ActiveLevel>(v.at(3).toInt());
+    cc.mode = static_cast<ChannelMode>(v.at(4).toInt());
+    cc.syncCh = v.at(5).toInt();
+    cc.dutyOn = v.at(6).toInt();
+    cc.dutyOff = v.at(7).toInt();
+
+    return true;
 }
 
-PulseGenConfig::ChannelMode QCPulseGenerator::readChMode(const int index)
+bool QCPulseGenerator::setChSettings(const int index, const PulseGenConfig::ChannelConfig &cc)
 {
-    auto resp = pGenQueryCmd(QString(":PULSE%1:CMOD?").arg(index+1));
-    if(!resp.isEmpty())
+    if(!d_useBatch)
+        return PulseGenerator::setChSettings(index,cc);
+
+    QStringList cmds {
+        chCommand(index,EnabledSetting,cc.enabled),
+        chCommand(index,DelaySetting,cc.delay),
+        chCommand(index,WidthSetting,cc.width),
+        chCommand(index,LevelSetting,cc.level),
+        chCommand(index,ModeSetting,cc.mode),
+        chCommand(index,SyncSetting,cc.syncCh),
+        chCommand(index,DutyOnSetting,cc.dutyOn),
+        chCommand(index,DutyOffSetting,cc.dutyOff)
+    };
+
+    auto resp = pGenQueryBatch(cmds);
+    if(batchFailed(resp))
+        return PulseGenerator::setChSettings(index,cc);
+
+    for(auto &r : resp)
     {
-        QString val = QString(resp.trimmed());
-        if(resp.contains("DCYC"))
-            return DutyCycle;
-        else if(resp.contains("NORM"))
-            return Normal;
+        //fall back to one command at a time, which lets the model-specific write retry
+        if(!r.startsWith("ok"))
+            return PulseGenerator::setChSettings(index,cc);
     }
 
-    emit hardwareFailure();
-    emit logMessage(QString("Could not read channel %1 mode. Response: %2").arg(index+1).arg(QString(resp)));
-    return Normal;
+    return true;
 }
 
-int QCPulseGenerator::readChDutyOn(const int index)
+bool QCPulseGenerator::batchFailed(const QList<QByteArray> &resp)
 {
-    auto resp = pGenQueryCmd(QString(":PULSE%1:PCO?").arg(index+1));
-    if(!resp.isEmpty())
+    //a missing reply means the unit did not keep up with pipelined queries; stop batching until
+    //the next connection test rather than waiting out the timeout on every call
+    for(auto &r : resp)
     {
-        bool ok = false;
-        auto val = resp.trimmed().toInt(&ok);
+        if(r.isEmpty())
+        {
+            d_useBatch = false;
+            emit logMessage(QString("No reply to a batched query. Sending queries one at a time until the next connection test."),LogHandler::Warning);
+            return true;
+        }
+    }
 
-        if(ok)
-            return val;
+    return false;
+}
+
+QString QCPulseGenerator::chCommand(const int index, const PulseGenConfig::Setting s, const QVariant val) const
+{
+    auto base = QString(":PULSE%1:").arg(index+1);
+    switch(s) {
+    case WidthSetting:
+        return base + QString("WIDTH %1").arg(val.toDouble()/1e6,0,'f',9);
+    case DelaySetting:
+        return base + QString("DELAY %1").arg(val.toDouble()/1e6,0,'f',9);
+    case LevelSetting:
+        return base + (val.toInt() == PulseGenConfig::ActiveHigh ? QString("POLARITY NORM") : QString("POLARITY INV"));
+    case EnabledSetting:
+        return base + (val.toBool() ? QString("STATE 1") : QString("STATE 0"));
+    case SyncSetting:
+        return base + QString("SYNC %1").arg(d_channels.at(val.toInt()));
+    case ModeSetting:
+        return base + (val.toInt() == PulseGenConfig::DutyCycle ? QString("CMODE DCYC") : QString("CMODE NORM"));
+    case DutyOnSetting:
+        return base + QString("PCO %1").arg(val.toInt());
+    case DutyOffSetting:
+        return base + QString("OCO %1").arg(val.toInt());
+    default:
+        return QString();
     }
+}
 
-    emit hardwareFailure();
-    emit logMessage(QString("Could not read channel %1 duty cycle on pulses. Response: %2").arg(index).arg(QString(resp)));
-    return -1;
+QString QCPulseGenerator::chQuery(const int index, const PulseGenConfig::Setting s) const
+{
+    auto base = QString(":PULSE%1:").arg(index+1);
+    switch(s) {
+    case WidthSetting:
+        return base + QString("WIDTH?");
+    case DelaySetting:
+        return base + QString("DELAY?");
+    case LevelSetting:
+        return base + QString("POLARITY?");
+    case EnabledSetting:
+        return base + QString("STATE?");
+    case SyncSetting:
+        return base + QString("SYNC?");
+    case ModeSetting:
+        return base + QString("CMOD?");
+    case DutyOnSetting:
+        return base + QString("PCO?");
+    case DutyOffSetting:
+        return base + QString("OCO?");
+    default:
+        return QString();
+    }
 }
 
-int QCPulseGenerator::readChDutyOff(const int index)
+QVariant QCPulseGenerator::parseChResponse(const int index, const PulseGenConfig::Setting s, const QByteArray resp)
 {
-    auto resp = pGenQueryCmd(QString(":PULSE%1:OCO?").arg(index+1));
+    QString what;
     if(!resp.isEmpty())
     {
         bool ok = false;
-        auto val = resp.trimmed().toInt(&ok);
+        switch(s) {
+        case WidthSetting:
+        case DelaySetting:
+        {
+            double val = resp.trimmed().toDouble(&ok)*1e6;
+            if(ok)
+                return val;
+            break;
+        }
+        case LevelSetting:
+            if(QString(resp).startsWith(QString("NORM"),Qt::CaseInsensitive))
+                return PulseGenConfig::ActiveHigh;
+            else if(QString(resp).startsWith(QString("INV"),Qt::CaseInsensitive))
+                return PulseGenConfig::ActiveLow;
+            break;
+        case EnabledSetting:
+        {
+            int val = resp.trimmed().toInt(&ok);
+            if(ok)
+                return static_cast<bool>(val);
+            break;
+        }
+        case SyncSetting:
+        {
+            int idx = d_channels.indexOf(QString(resp.trimmed()));
+            if(idx >= 0)
+                return idx;
+            break;
+        }
+        case ModeSetting:
+            if(resp.contains("DCYC"))
+                return DutyCycle;
+            else if(resp.contains("NORM"))
+                return Normal;
+            break;
+        case DutyOnSetting:
+        case DutyOffSetting:
+        {
+            auto val = resp.trimmed().toInt(&ok);
+            if(ok)
+                return val;
+            break;
+        }
+        default:
+            break;
+        }
+    }
 
-        if(ok)
-            return val;
+    switch(s) {
+    case WidthSetting:
+        what = QString("width");
+        break;
+    case DelaySetting:
+        what = QString("delay");
+        break;
+    case LevelSetting:
+        what = QString("active level");
+        break;
+    case EnabledSetting:
+        what = QString("enabled state");
+        break;
+    case SyncSetting:
+        what = QString("sync channel");
+        break;
+    case ModeSetting:
+        what = QString("mode");
+        break;
+    case DutyOnSetting:
+        what = QString("duty cycle on pulses");
+        break;
+    case DutyOffSetting:
+        what = QString("duty cycle off pulses");
+        break;
+    default:
+        break;
     }
 
     emit hardwareFailure();
-    emit logMessage(QString("Could not read channel %1 duty cycle off pulses. Response: %2").arg(index).arg(QString(resp)));
-    return -1;
+    emit logMessage(QString("Could not read channel %1 %2. Response: %3").arg(index+1).arg(what).arg(QString(resp)));
+    return QVariant();
 }
 
 PulseGenConfig::PGenMode QCPulseGenerator::readHwPulseMode()
@@ -57,11 +57,14 @@ protected:
     PulseGenConfig::PGenMode readHwPulseMode() override final;
     double readHwRepRate() override final;
     bool readHwPulseEnabled() override final;
+    bool readChSettings(const int index, PulseGenConfig::ChannelConfig &cc) override final;
+    bool setChSettings(const int index, const PulseGenConfig::ChannelConfig &cc) override final;
 
 protected:
     void lockKeys(bool lock);
     virtual bool pGenWriteCmd(QString cmd) =0;
     virtual QByteArray pGenQueryCmd(QString cmd) =0;
+    virtual QList<QByteArray> pGenQueryBatch(QStringList cmds) =0;
 
 
     virtual QString idResponse() =0;
@@ -71,6 +74,13 @@ protected:
 
 private:
     const QStringList d_channels{"T0","CHA","CHB","CHC","CHD","CHE","CHF","CHG","CHH"};
+    bool d_useBatch{false};
+
+    bool batchFailed(const QList<QByteArray> &resp);
+
+    QString chCommand(const int index, const PulseGenConfig::Setting s, const QVariant val) const;
+    QString chQuery(const int index, const PulseGenConfig::Setting s) const;
+    QVariant parseChResponse(const int index, const PulseGenConfig::Setting s, const QByteArray resp);
 };
 
 #if BC_PGEN==2
@@ -94,6 +104,7 @@ protected:
 protected:
     bool pGenWriteCmd(QString cmd) override;
     QByteArray pGenQueryCmd(QString cmd) override;
+    QList<QByteArray> pGenQueryBatch(QStringList cmds) override;
     inline QString idResponse() override { return id; }
     inline QString sysStr() override { return sys; }
     inline QString clock10MHzStr() override { return clock; }
@@ -129,6 +140,7 @@ protected:
 protected:
     bool pGenWriteCmd(QString cmd) override;
     QByteArray pGenQueryCmd(QString cmd) override;
+    QList<QByteArray> pGenQueryBatch(QStringList cmds) override;
     inline QString idResponse() override { return id; }
     inline QString sysStr() override { return sys; }
     inline QString clock10MHzStr() override { return clock; }
@@ -166,6 +178,7 @@ protected:
 protected:
     bool pGenWriteCmd(QString cmd) override;
     QByteArray pGenQueryCmd(QString cmd) override;
+    QList<QByteArray> pGenQueryBatch(QStringList cmds) override;
     inline QString idResponse() override { return id; }
     inline QString sysStr() override { return sys; }
     inline QString clock10MHzStr() override { return clock; }
@@ -2,10 +2,14 @@
 
 HEADERS += \
     $$PWD/lifconfig.h \
+    $$PWD/lifcubefile.h \
+    $$PWD/lifprocessor.h \
     $$PWD/lifstorage.h \
     $$PWD/liftrace.h
 
 SOURCES += \
     $$PWD/lifconfig.cpp \
+    $$PWD/lifcubefile.cpp \
+    $$PWD/lifprocessor.cpp \
     $$PWD/lifstorage.cpp \
     $$PWD/liftrace.cpp
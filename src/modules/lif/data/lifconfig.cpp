@@ -62,8 +62,7 @@ void LifConfig::addWaveform(const QVector<qint8> d)
     if(d_complete && d_completeMode == StopWhenComplete)
         return;
 
-    LifTrace t(d_scopeConfig,d,d_currentDelayIndex,d_currentLaserIndex);
-    ps_storage->addTrace(t);
+    ps_storage->addWaveform(d_scopeConfig,d,d_currentDelayIndex,d_currentLaserIndex);
 }
 
 void LifConfig::loadLifData()
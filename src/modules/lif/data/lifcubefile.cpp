@@ -0,0 +1,224 @@
+#include "lifcubefile.h"
+
+#include <QFile>
+#include <QtEndian>
+#include <cstring>
+
+#include <data/storage/fidbinaryfile.h>
+
+static const char magic[8] = {'B','C','L','I','F','\0','\0','\0'};
+
+LifCubeFile::LifCubeFile()
+{
+}
+
+LifCubeFile::~LifCubeFile()
+{
+    close();
+}
+
+bool LifCubeFile::create(const QString path, const Layout &l)
+{
+    close();
+    d_errorString.clear();
+
+    if(l.delayPoints < 1 || l.laserPoints < 1 || l.recordLength < 1)
+    {
+        d_errorString = QString("Invalid LIF data dimensions (%1 x %2 x %3).")
+                .arg(l.delayPoints).arg(l.laserPoints).arg(l.recordLength);
+        return false;
+    }
+
+    d_layout = l;
+    pu_file = std::make_unique<QFile>(path);
+    //resizing an empty file leaves it filled with zeros, so every cell starts with 0 shots
+    if(!pu_file->open(QIODevice::ReadWrite|QIODevice::Truncate) || !pu_file->resize(fileSize()))
+    {
+        d_errorString = pu_file->errorString();
+        close();
+        return false;
+    }
+
+    char hdr[headerSize] = {0};
+    memcpy(hdr,magic,sizeof(magic));
+    qToLittleEndian<quint32>(version,hdr+8);
+    qToLittleEndian<quint32>(l.refEnabled ? 1 : 0,hdr+12);
+    qToLittleEndian<qint32>(l.delayPoints,hdr+16);
+    qToLittleEndian<qint32>(l.laserPoints,hdr+20);
+    qToLittleEndian<qint32>(l.recordLength,hdr+24);
+    qToLittleEndian<double>(l.xSpacing,hdr+32);
+    qToLittleEndian<double>(l.lifYMult,hdr+40);
+    qToLittleEndian<double>(l.refYMult,hdr+48);
+    if(pu_file->write(hdr,headerSize) != headerSize || !pu_file->flush())
+    {
+        d_errorString = pu_file->errorString();
+        close();
+        return false;
+    }
+
+    p_map = pu_file->map(0,fileSize());
+    if(!p_map)
+    {
+        d_errorString = pu_file->errorString();
+        close();
+        return false;
+    }
+
+    d_writable = true;
+    return true;
+}
+
+bool LifCubeFile::open(const QString path, bool writable)
+{
+    close();
+    d_errorString.clear();
+
+    pu_file = std::make_unique<QFile>(path);
+    if(!pu_file->open(writable ? QIODevice::ReadWrite : QIODevice::ReadOnly))
+    {
+        d_errorString = pu_file->errorString();
+        close();
+        return false;
+    }
+
+    char hdr[headerSize];
+    if(pu_file->read(hdr,headerSize) != headerSize || memcmp(hdr,magic,sizeof(magic)) != 0
+            || qFromLittleEndian<quint32>(hdr+8) > version)
+    {
+        d_errorString = QString("%1 is not a recognized LIF data file.").arg(path);
+        close();
+        return false;
+    }
+
+    d_layout.refEnabled = qFromLittleEndian<quint32>(hdr+12) & 1;
+    d_layout.delayPoints = qFromLittleEndian<qint32>(hdr+16);
+    d_layout.laserPoints = qFromLittleEndian<qint32>(hdr+20);
+    d_layout.recordLength = qFromLittleEndian<qint32>(hdr+24);
+    d_layout.xSpacing = qFromLittleEndian<double>(hdr+32);
+    d_layout.lifYMult = qFromLittleEndian<double>(hdr+40);
+    d_layout.refYMult = qFromLittleEndian<double>(hdr+48);
+
+    if(d_layout.delayPoints < 1 || d_layout.laserPoints < 1 || d_layout.recordLength < 1
+            || pu_file->size() < fileSize())
+    {
+        d_errorString = QString("%1 is truncated or has an invalid header.").arg(path);
+        close();
+        return false;
+    }
+
+    p_map = pu_file->map(0,fileSize());
+    if(!p_map)
+    {
+        d_errorString = pu_file->errorString();
+        close();
+        return false;
+    }
+
+    d_writable = writable;
+    return true;
+}
+
+void LifCubeFile::close()
+{
+    //closing the file also unmaps it, which hands any modified pages to the OS to write back
+    if(pu_file)
+        pu_file->close();
+    pu_file.reset();
+    p_map = nullptr;
+    d_writable = false;
+}
+
+bool LifCubeFile::writeTrace(const LifTrace &t)
+{
+    if(!p_map || !d_writable)
+        return false;
+
+    auto c = cellIndex(t.delayIndex(),t.laserIndex());
+    auto p = d_layout.recordLength;
+    if(c < 0 || t.size() != p || t.hasRefData() != d_layout.refEnabled)
+        return false;
+
+    auto lif = t.lifRaw();
+    auto dat = p_map + dataOffset() + static_cast<qint64>(c)*channels()*p*sizeof(qint64);
+    qToLittleEndian<qint64>(lif.constData(),p,dat);
+    auto cs = FidBinaryFile::checksum(lif.constData(),p);
+    if(d_layout.refEnabled)
+    {
+        auto ref = t.refRaw();
+        qToLittleEndian<qint64>(ref.constData(),p,dat + p*sizeof(qint64));
+        cs = FidBinaryFile::checksum(ref.constData(),p,cs);
+    }
+
+    auto rec = p_map + headerSize + static_cast<qint64>(c)*cellRecordSize;
+    qToLittleEndian<quint64>(cs,rec+8);
+    qToLittleEndian<qint64>(t.shots(),rec);
+    return true;
+}
+
+LifTrace LifCubeFile::readTrace(int di, int li, bool verify, quint64 revision) const
+{
+    auto c = cellIndex(di,li);
+    if(!p_map || c < 0)
+        return LifTrace();
+
+    auto rec = p_map + headerSize + static_cast<qint64>(c)*cellRecordSize;
+    auto shots = qFromLittleEndian<qint64>(rec);
+    if(shots < 1)
+        return LifTrace();
+
+    auto p = d_layout.recordLength;
+    auto dat = p_map + dataOffset() + static_cast<qint64>(c)*channels()*p*sizeof(qint64);
+    QVector<qint64> lif(p), ref;
+    qFromLittleEndian<qint64>(dat,p,lif.data());
+    auto cs = FidBinaryFile::checksum(lif.constData(),p);
+    if(d_layout.refEnabled)
+    {
+        ref.resize(p);
+        qFromLittleEndian<qint64>(dat + p*sizeof(qint64),p,ref.data());
+        cs = FidBinaryFile::checksum(ref.constData(),p,cs);
+    }
+
+    if(verify && cs != qFromLittleEndian<quint64>(rec+8))
+        return LifTrace();
+
+    return LifTrace(di,li,lif,ref,static_cast<int>(shots),d_layout.xSpacing,d_layout.lifYMult,d_layout.refYMult,revision);
+}
+
+qint64 LifCubeFile::shots(int di, int li) const
+{
+    auto c = cellIndex(di,li);
+    if(!p_map || c < 0)
+        return 0;
+
+    return qFromLittleEndian<qint64>(p_map + headerSize + static_cast<qint64>(c)*cellRecordSize);
+}
+
+qint64 LifCubeFile::totalShots() const
+{
+    if(!p_map)
+        return 0;
+
+    qint64 out = 0;
+    for(int c=0; c<cells(); ++c)
+        out += qFromLittleEndian<qint64>(p_map + headerSize + static_cast<qint64>(c)*cellRecordSize);
+
+    return out;
+}
+
+qint64 LifCubeFile::dataOffset() const
+{
+    return headerSize + static_cast<qint64>(cells())*cellRecordSize;
+}
+
+qint64 LifCubeFile::fileSize() const
+{
+    return dataOffset() + static_cast<qint64>(cells())*channels()*d_layout.recordLength*sizeof(qint64);
+}
+
+int LifCubeFile::cellIndex(int di, int li) const
+{
+    if(di < 0 || li < 0 || di >= d_layout.delayPoints || li >= d_layout.laserPoints)
+        return -1;
+
+    return di*d_layout.laserPoints + li;
+}
@@ -0,0 +1,99 @@
+#ifndef LIFCUBEFILE_H
+#define LIFCUBEFILE_H
+
+#include <QString>
+#include <memory>
+
+#include <modules/lif/data/liftrace.h>
+
+class QFile;
+
+namespace BC::CSV {
+static const QString lifCube{"lifdata.bclif"};
+}
+
+/*!
+ * \brief Memory-mapped binary store for the traces of a LIF scan
+ *
+ * The file holds a delay x laser grid of cells. Each cell has room for one trace of a fixed
+ * record length, with the LIF channel and (optionally) the reference channel stored as the
+ * summed digitizer readings. The whole file is allocated and mapped when it is created, so
+ * writing or reading a trace is a copy to or from a known offset. Nothing else in the file is
+ * rewritten when one cell changes. All fields are little-endian.
+ *
+ * The file begins with a 64-byte header:
+ *
+ * | Offset | Type    | Field                                          |
+ * |--------|---------|------------------------------------------------|
+ * | 0      | char[8] | Magic ("BCLIF" followed by 3 null bytes)       |
+ * | 8      | quint32 | Format version                                 |
+ * | 12     | quint32 | Flags (bit 0: reference channel present)       |
+ * | 16     | qint32  | Delay points (D)                               |
+ * | 20     | qint32  | Laser points (L)                               |
+ * | 24     | qint32  | Record length (P)                              |
+ * | 28     | -       | Reserved (zero)                                |
+ * | 32     | double  | Sample spacing (s)                             |
+ * | 40     | double  | LIF yMult                                      |
+ * | 48     | double  | Reference yMult                                |
+ * | 56     | -       | Reserved (zero)                                |
+ *
+ * The header is followed by D*L 16-byte cell records (qint64 shots, quint64 FNV-1a checksum of
+ * the cell's data), then the data: C*P qint64 values per cell, where C is 2 if the reference
+ * channel is present and 1 otherwise. Cell (di,li) has index di*L + li; its LIF data are
+ * followed by its reference data. A cell with 0 shots has not been acquired.
+ *
+ * The data are written before the cell record, and a cell whose checksum does not match is
+ * treated as missing.
+ *
+ * Trace revisions are not stored in the file. readTrace() gives the trace the revision passed
+ * in, so the caller can keep one revision per cell that changes only when the cell is written.
+ */
+class LifCubeFile
+{
+public:
+    struct Layout {
+        int delayPoints{0};
+        int laserPoints{0};
+        int recordLength{0};
+        bool refEnabled{false};
+        double xSpacing{1.0};
+        double lifYMult{1.0};
+        double refYMult{1.0};
+    };
+
+    static constexpr quint32 version{1};
+    static constexpr int headerSize{64};
+    static constexpr int cellRecordSize{16};
+
+    LifCubeFile();
+    ~LifCubeFile();
+
+    bool create(const QString path, const Layout &l);
+    bool open(const QString path, bool writable = false);
+    void close();
+
+    bool isOpen() const { return p_map != nullptr; }
+    bool isWritable() const { return d_writable; }
+    const Layout &layout() const { return d_layout; }
+    QString errorString() const { return d_errorString; }
+
+    bool writeTrace(const LifTrace &t);
+    LifTrace readTrace(int di, int li, bool verify = true, quint64 revision = 0) const;
+    qint64 shots(int di, int li) const;
+    qint64 totalShots() const;
+
+private:
+    std::unique_ptr<QFile> pu_file;
+    uchar *p_map{nullptr};
+    bool d_writable{false};
+    Layout d_layout;
+    QString d_errorString;
+
+    int cells() const { return d_layout.delayPoints*d_layout.laserPoints; }
+    int channels() const { return d_layout.refEnabled ? 2 : 1; }
+    qint64 dataOffset() const;
+    qint64 fileSize() const;
+    int cellIndex(int di, int li) const;
+};
+
+#endif // LIFCUBEFILE_H
@@ -0,0 +1,110 @@
+#include "lifprocessor.h"
+
+#include <data/analysis/analysis.h>
+#include <QThreadPool>
+
+LifProcessor::LifProcessor()
+{
+}
+
+void LifProcessor::reset(int delayPoints, int laserPoints)
+{
+    QMutexLocker l(&d_mutex);
+    d_delayPoints = qMax(0,delayPoints);
+    d_laserPoints = qMax(0,laserPoints);
+    d_entries.assign(static_cast<std::size_t>(d_delayPoints)*d_laserPoints,Entry());
+    d_hasSettings = false;
+}
+
+QVector<double> LifProcessor::process(const LifTrace::LifProcSettings &s, TraceFunction f)
+{
+    QMutexLocker l(&d_mutex);
+    bool lifOk = d_hasSettings && sameLif(s,d_settings);
+    bool refOk = d_hasSettings && sameRef(s,d_settings);
+    d_settings = s;
+    d_hasSettings = true;
+    int lp = d_laserPoints;
+    int n = static_cast<int>(d_entries.size());
+    l.unlock();
+
+    //loading a trace takes the storage lock and may read from disk, so this stays off
+    //Analysis::workerPool(), which is reserved for shot processing
+    QVector<double> out(n);
+    double *o = out.data();
+    Analysis::parallelFor(n,[&](int i){
+        auto t = f(i/lp,i%lp);
+
+        QMutexLocker lock(&d_mutex);
+        auto e = d_entries[i];
+        lock.unlock();
+
+        //an empty trace has no indices; any other must belong to this grid point
+        bool sameCell = t.size() == 0 || t.delayIndex()*lp + t.laserIndex() == i;
+        bool current = e.valid && sameCell && e.revision == t.revision();
+        if(!current || !lifOk)
+        {
+            e.lifInt = t.lifIntegral(s);
+            d_integrations.fetch_add(1,std::memory_order_relaxed);
+        }
+        if(t.hasRefData() && (!current || !refOk))
+        {
+            e.refInt = t.refIntegral(s);
+            d_integrations.fetch_add(1,std::memory_order_relaxed);
+        }
+        else if(!t.hasRefData())
+            e.refInt = 0.0;
+
+        e.revision = t.revision();
+        e.valid = true;
+        o[i] = LifTrace::normalizedIntegral(e.lifInt,e.refInt);
+
+        lock.relock();
+        d_entries[i] = e;
+    },QThreadPool::globalInstance());
+
+    return out;
+}
+
+double LifProcessor::update(const LifTrace &t, const LifTrace::LifProcSettings &s)
+{
+    Entry e;
+    e.revision = t.revision();
+    e.valid = true;
+    e.lifInt = t.lifIntegral(s);
+    e.refInt = t.refIntegral(s);
+    d_integrations.fetch_add(t.hasRefData() ? 2 : 1,std::memory_order_relaxed);
+
+    QMutexLocker l(&d_mutex);
+    auto i = t.delayIndex()*d_laserPoints + t.laserIndex();
+    if(t.delayIndex() >= 0 && t.laserIndex() >= 0 && i < static_cast<int>(d_entries.size()))
+    {
+        //results computed with other settings would be mistaken for cached ones by process()
+        if(d_hasSettings && sameLif(s,d_settings) && sameRef(s,d_settings))
+            d_entries[i] = e;
+        else
+            d_entries[i].valid = false;
+    }
+
+    return LifTrace::normalizedIntegral(e.lifInt,e.refInt);
+}
+
+bool LifProcessor::sameFilter(const LifTrace::LifProcSettings &a, const LifTrace::LifProcSettings &b)
+{
+    if(a.lowPassAlpha != b.lowPassAlpha || a.savGolEnabled != b.savGolEnabled)
+        return false;
+
+    if(a.savGolEnabled)
+        return a.savGolWin == b.savGolWin && a.savGolPoly == b.savGolPoly;
+
+    return true;
+}
+
+bool LifProcessor::sameLif(const LifTrace::LifProcSettings &a, const LifTrace::LifProcSettings &b)
+{
+    return sameFilter(a,b) && a.lifGateStart == b.lifGateStart && a.lifGateEnd == b.lifGateEnd;
+}
+
+bool LifProcessor::sameRef(const LifTrace::LifProcSettings &a, const LifTrace::LifProcSettings &b)
+{
+    return sameFilter(a,b) && a.refGateStart == b.refGateStart && a.refGateEnd == b.refGateEnd;
+}
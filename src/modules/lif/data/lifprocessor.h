@@ -0,0 +1,68 @@
+#ifndef LIFPROCESSOR_H
+#define LIFPROCESSOR_H
+
+#include <QMutex>
+#include <QVector>
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include <modules/lif/data/liftrace.h>
+
+/*!
+ * \brief Integrates the traces of a delay/laser grid
+ *
+ * process() integrates every grid point on the global thread pool and blocks until done, so it
+ * should be run off the GUI thread. The LIF and reference integrals are cached per grid point,
+ * keyed on the point's index and the revision of its trace. LifStorage gives each stored cell a
+ * revision that only changes when the cell is written, so traces read back from storage match
+ * their cache entries. On the next call, unchanged traces are only integrated again
+ * for a channel whose settings changed: moving the LIF gate does not touch the reference
+ * channel and vice versa, and nothing is recomputed if the settings are the same.
+ *
+ * update() integrates a single trace (e.g., the one being acquired) and refreshes its cache
+ * entry if the settings match those of the last process() call. It may be called while
+ * process() is running on another thread.
+ */
+class LifProcessor
+{
+public:
+    using TraceFunction = std::function<LifTrace(int,int)>;
+
+    LifProcessor();
+
+    void reset(int delayPoints, int laserPoints);
+
+    /*!
+     * \brief Integrates all traces
+     * \param s Processing settings
+     * \param f Returns the trace at (delay index, laser index)
+     * \return QVector<double> Integrals; the value for (di,li) is at li + di*laserPoints
+     */
+    QVector<double> process(const LifTrace::LifProcSettings &s, TraceFunction f);
+    double update(const LifTrace &t, const LifTrace::LifProcSettings &s);
+
+    //number of single-channel gate integrations performed so far
+    quint64 integrations() const { return d_integrations.load(std::memory_order_relaxed); }
+
+private:
+    struct Entry {
+        quint64 revision{0};
+        bool valid{false};
+        double lifInt{0.0};
+        double refInt{0.0};
+    };
+
+    mutable QMutex d_mutex;
+    int d_delayPoints{0}, d_laserPoints{0};
+    std::vector<Entry> d_entries;
+    LifTrace::LifProcSettings d_settings;
+    bool d_hasSettings{false};
+    std::atomic<quint64> d_integrations{0};
+
+    static bool sameFilter(const LifTrace::LifProcSettings &a, const LifTrace::LifProcSettings &b);
+    static bool sameLif(const LifTrace::LifProcSettings &a, const LifTrace::LifProcSettings &b);
+    static bool sameRef(const LifTrace::LifProcSettings &a, const LifTrace::LifProcSettings &b);
+};
+
+#endif // LIFPROCESSOR_H
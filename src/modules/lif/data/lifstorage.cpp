@@ -1,106 +1,72 @@
 #include "lifstorage.h"
 
 #include <data/storage/blackchirpcsv.h>
+#include <data/storage/settingsstorage.h>
+#include <modules/lif/data/lifcubefile.h>
 
+#include <algorithm>
 #include <QMutexLocker>
 #include <QSaveFile>
+#include <QtConcurrent/QtConcurrent>
 
 LifStorage::LifStorage(int dp, int lp, int num, QString path)
-    : DataStorageBase(num,path), d_delayPoints{dp}, d_laserPoints{lp}
+    : DataStorageBase(num,path), d_delayPoints{dp}, d_laserPoints{lp},
+      d_cellRevisions(static_cast<std::size_t>(qMax(0,dp*lp)),0)
 {
 }
 
 LifStorage::~LifStorage()
 {
+    flush();
 }
 
 void LifStorage::advance()
 {
-
+    //the finished trace is written in the background so that the next point can begin right
+    //away. Until it reaches the cube, getLifTrace finds it in d_pending.
     QMutexLocker l(pu_mutex.get());
     d_nextNew = true;
-    l.unlock();
-
-    save();
-}
-
-void LifStorage::save()
-{
-    //first, write current trace file
-    QMutexLocker l(pu_mutex.get());
-    auto i = index(d_currentTrace.delayIndex(),d_currentTrace.laserIndex());
-    auto it = d_data.emplace(i,d_currentTrace);
-    if(!it.second) //insertion not successful if key already exists
-        d_data[i] = d_currentTrace;
-
-    QDir d{BlackchirpCSV::exptDir(d_number,d_path)};
-    if(!d.cd(BC::CSV::lifDir))
-    {
-        if(!d.mkdir(BC::CSV::lifDir))
-            return;
-        if(!d.cd(BC::CSV::lifDir))
-            return;
-    }
-
-    QSaveFile dat(d.absoluteFilePath("%1.csv").arg(i));
-    if(!dat.open(QIODevice::WriteOnly|QIODevice::Text))
+    if(d_currentTrace.size() == 0)
         return;
 
-    QTextStream t(&dat);
-
-    if(d_currentTrace.hasRefData())
-    {
-        t << "lif" << BC::CSV::sep << "ref" << BC::CSV::nl;
-
-        auto lr = d_currentTrace.lifRaw();
-        auto rr = d_currentTrace.refRaw();
+    d_savedShots += d_currentTrace.shots() - d_currentSavedShots;
+    d_currentSavedShots = d_currentTrace.shots();
+    d_pending[index(d_currentTrace.delayIndex(),d_currentTrace.laserIndex())] = d_currentTrace;
 
-        for(int i=0; i<d_currentTrace.size(); i++)
-        {
-            t << BlackchirpCSV::formatInt64(lr.at(i))
-              << BC::CSV::sep
-              << BlackchirpCSV::formatInt64(rr.at(i))
-              << BC::CSV::nl;
-        }
-    }
-    else
+    if(!d_writing)
     {
-        t << "lif" << BC::CSV::nl;
-
-        auto lr = d_currentTrace.lifRaw();
-        for(int i=0; i<d_currentTrace.size(); i++)
-        {
-            t << BlackchirpCSV::formatInt64(lr.at(i))
-              << BC::CSV::nl;
-        }
+        d_writing = true;
+        QtConcurrent::run([this](){ writePending(); });
     }
+}
 
-    l.unlock();
+void LifStorage::save()
+{
+    //write the current trace into its cell of the data cube; the rest of the file is untouched
+    flush();
 
-    if(!dat.commit())
+    QMutexLocker l(pu_mutex.get());
+    if(d_currentTrace.size() == 0)
         return;
 
-    QSaveFile hdr(d.absoluteFilePath(BC::CSV::lifparams));
-    if(!hdr.open(QIODevice::WriteOnly|QIODevice::Text))
+    if(!writeToCube(d_currentTrace))
         return;
 
-    QTextStream txt(&hdr);
+    setCellRevision(index(d_currentTrace.delayIndex(),d_currentTrace.laserIndex()),d_currentTrace.revision());
 
-    BlackchirpCSV::writeLine(txt,{"lIndex","dIndex","shots","lifsize","refsize","spacing","lifymult","refymult"});
+    d_savedShots += d_currentTrace.shots() - d_currentSavedShots;
+    d_currentSavedShots = d_currentTrace.shots();
 
-    l.relock();
-    for(auto it = d_data.cbegin(); it != d_data.cend(); ++it)
-    {
-        auto &t = it->second;
-        if(t.hasRefData())
-            BlackchirpCSV::writeLine(txt,{t.laserIndex(),t.delayIndex(),t.shots(),t.size(),t.size(),t.xSpacing(),t.lifYMult(),t.refYMult()});
-        else
-            BlackchirpCSV::writeLine(txt,{t.laserIndex(),t.delayIndex(),t.shots(),t.size(),0,t.xSpacing(),t.lifYMult(),0});
-    }
-    l.unlock();
+    if(d_acquiring)
+        return;
 
-    hdr.commit();
+    //final save: unmapping hands the modified pages to the OS, and the cube is reopened
+    //read-only if traces are requested later
+    pu_cube->close();
+    l.unlock();
 
+    if(d_csvCopy)
+        exportCsv();
 }
 
 void LifStorage::start()
@@ -108,12 +74,21 @@ void LifStorage::start()
     QMutexLocker l(pu_mutex.get());
     d_acquiring = true;
     d_nextNew = true;
+
+    SettingsStorage s(BC::Key::LifStorage::key);
+    d_csvCopy = s.get(BC::Key::LifStorage::csvCopy,false);
 }
 
 void LifStorage::finish()
 {
+    flush();
+
     QMutexLocker l(pu_mutex.get());
     d_acquiring = false;
+
+    //when viewing a completed experiment, open the cube now so that completedShots is correct
+    if(!pu_cube)
+        openCube();
 }
 
 int LifStorage::currentTraceShots() const
@@ -125,17 +100,11 @@ int LifStorage::currentTraceShots() const
 int LifStorage::completedShots() const
 {
     QMutexLocker l(pu_mutex.get());
-    int out = 0;
-    for(auto it = d_data.cbegin(); it != d_data.cend(); ++it)
-        out += it->second.shots();
-
-    if(!d_acquiring)
-        return out;
+    if(!d_acquiring || d_nextNew)
+        return static_cast<int>(d_savedShots);
 
-    if(d_nextNew)
-        return out;
-
-    return out + d_currentTrace.shots();
+    //shots already in the cube for the current cell are part of d_savedShots
+    return static_cast<int>(d_savedShots + d_currentTrace.shots() - d_currentSavedShots);
 }
 
 LifTrace LifStorage::getLifTrace(int di, int li)
@@ -147,83 +116,84 @@ LifTrace LifStorage::getLifTrace(int di, int li)
     if(i == index(d_currentTrace.delayIndex(),d_currentTrace.laserIndex()))
         return d_currentTrace;
 
-    auto it = d_data.find(i);
-    if(it != d_data.end())
-        return it->second;
+    auto pit = d_pending.find(i);
+    if(pit != d_pending.end())
+        return pit->second;
 
-    if(!d_acquiring)
-    {
-        l.unlock();
-        return loadLifTrace(di,li);
-    }
+    if(openCube())
+        return pu_cube->readTrace(di,li,true,cellRevision(i));
+
+    auto it = d_legacyData.find(i);
+    if(it != d_legacyData.end())
+        return it->second;
 
     return LifTrace();
 }
 
-LifTrace LifStorage::loadLifTrace(int di, int li)
+bool LifStorage::exportCsv()
 {
-    LifTrace out;
+    flush();
+
+    QMutexLocker l(pu_mutex.get());
+    if(!openCube())
+        return false;
+
     QDir d{BlackchirpCSV::exptDir(d_number,d_path)};
-    d.cd(BC::CSV::lifDir);
+    if(!d.cd(BC::CSV::lifDir))
+        return false;
 
-    QFile hdr(d.absoluteFilePath(BC::CSV::lifparams));
-    if(!hdr.open(QIODevice::ReadOnly|QIODevice::Text))
-        return out;
+    QSaveFile hdr(d.absoluteFilePath(BC::CSV::lifparams));
+    if(!hdr.open(QIODevice::WriteOnly|QIODevice::Text))
+        return false;
 
-    bool found = false;
-    int lsize{0}, rsize{0}, shots{0};
-    double xsp{1.0}, lym{0.0}, rym{0.0};
+    QTextStream txt(&hdr);
+    BlackchirpCSV::writeLine(txt,{"lIndex","dIndex","shots","lifsize","refsize","spacing","lifymult","refymult"});
 
-    while(!hdr.atEnd())
+    for(int di=0; di<d_delayPoints; ++di)
     {
-        auto l = pu_csv->readLine(hdr);
-        if(l.size() < 8)
-            continue;
-
-        bool ok = false;
-        int lli = l.constFirst().toInt(&ok);
-        if(ok)
+        for(int li=0; li<d_laserPoints; ++li)
         {
-            int ddi = l.at(1).toInt(&ok);
-            if(ok)
+            auto tr = pu_cube->readTrace(di,li);
+            if(tr.size() == 0)
+                continue;
+
+            QSaveFile dat(d.absoluteFilePath("%1.csv").arg(index(di,li)));
+            if(!dat.open(QIODevice::WriteOnly|QIODevice::Text))
+                return false;
+
+            QTextStream t(&dat);
+            auto lr = tr.lifRaw();
+            if(tr.hasRefData())
             {
-                if(lli == li && ddi == di)
+                t << "lif" << BC::CSV::sep << "ref" << BC::CSV::nl;
+                auto rr = tr.refRaw();
+                for(int i=0; i<tr.size(); i++)
                 {
-                    found = true;
-                    shots = l.at(2).toInt();
-                    lsize = l.at(3).toInt();
-                    rsize = l.at(4).toInt();
-                    xsp = l.at(5).toDouble();
-                    lym = l.at(6).toDouble();
-                    rym = l.at(7).toDouble();
-                    break;
+                    t << BlackchirpCSV::formatInt64(lr.at(i))
+                      << BC::CSV::sep
+                      << BlackchirpCSV::formatInt64(rr.at(i))
+                      << BC::CSV::nl;
                 }
-            }
-        }
-    }
 
-    if(!found)
-        return out;
+                BlackchirpCSV::writeLine(txt,{li,di,tr.shots(),tr.size(),tr.size(),tr.xSpacing(),tr.lifYMult(),tr.refYMult()});
+            }
+            else
+            {
+                t << "lif" << BC::CSV::nl;
+                for(int i=0; i<tr.size(); i++)
+                    t << BlackchirpCSV::formatInt64(lr.at(i)) << BC::CSV::nl;
 
-    auto idx = index(di,li);
-    QFile dat(d.absoluteFilePath("%1.csv").arg(idx));
-    if(!dat.open(QIODevice::ReadOnly|QIODevice::Text))
-        return out;
+                BlackchirpCSV::writeLine(txt,{li,di,tr.shots(),tr.size(),0,tr.xSpacing(),tr.lifYMult(),0});
+            }
 
-    QVector<qint64> lifData(lsize), refData(rsize);
-    auto l = pu_csv->readLine(dat); //read first line which contains titles
-    for(int i=0; i<lsize; i++)
-    {
-        l = pu_csv->readLine(dat);
-        lifData[i] = l.constFirst().toString().toLongLong(nullptr,36);
-        if(i<rsize && l.size() == 2)
-            refData[i] = l.at(1).toString().toLongLong(nullptr,36);
+            t.flush();
+            if(!dat.commit())
+                return false;
+        }
     }
 
-    out = LifTrace(di,li,lifData,refData,shots,xsp,lym,rym);
-    QMutexLocker lock(pu_mutex.get());
-    d_data.emplace(idx,out);
-    return out;
+    txt.flush();
+    return hdr.commit();
 }
 
 void LifStorage::addTrace(const LifTrace t)
@@ -231,15 +201,28 @@ void LifStorage::addTrace(const LifTrace t)
     QMutexLocker l(pu_mutex.get());
     if(d_nextNew)
     {
-        auto idx = index(t.delayIndex(),t.laserIndex());
-        auto it = d_data.find(idx);
-        if(it != d_data.end())
+        //revisiting a cell on a later sweep continues from the stored trace
+        LifTrace prev;
+        auto pit = d_pending.find(index(t.delayIndex(),t.laserIndex()));
+        if(pit != d_pending.end())
+            prev = pit->second;
+        else if(pu_cube && pu_cube->isOpen())
         {
-            d_currentTrace = it->second;
+            auto i = index(t.delayIndex(),t.laserIndex());
+            prev = pu_cube->readTrace(t.delayIndex(),t.laserIndex(),true,cellRevision(i));
+        }
+
+        if(prev.size() == t.size() && prev.hasRefData() == t.hasRefData())
+        {
+            d_currentTrace = prev;
             d_currentTrace.add(t);
+            d_currentSavedShots = prev.shots();
         }
         else
+        {
             d_currentTrace = t;
+            d_currentSavedShots = 0;
+        }
 
         d_nextNew = false;
     }
@@ -247,6 +230,28 @@ void LifStorage::addTrace(const LifTrace t)
         d_currentTrace.add(t);
 }
 
+void LifStorage::addWaveform(const LifDigitizerConfig &c, const QVector<qint8> b, int di, int li)
+{
+    //after the first waveform for a point, new waveforms are decoded straight into the current trace
+    QMutexLocker l(pu_mutex.get());
+    if(!d_nextNew)
+    {
+        d_currentTrace.addWaveform(c,b);
+        return;
+    }
+    l.unlock();
+
+    addTrace(LifTrace(c,b,di,li));
+}
+
+void LifStorage::flush()
+{
+    //waits until all traces passed to advance() are in the cube
+    QMutexLocker l(pu_mutex.get());
+    while(d_writing)
+        d_writeDone.wait(pu_mutex.get());
+}
+
 void LifStorage::writeProcessingSettings(const LifTrace::LifProcSettings &c)
 {
     using namespace BC::Key::LifStorage;
@@ -300,7 +305,224 @@ bool LifStorage::readProcessingSettings(LifTrace::LifProcSettings &out)
     return true;
 }
 
+quint64 LifStorage::cellRevision(int i)
+{
+    //pu_mutex must be held by the caller
+    //a cell gets a revision when it is written; cells from a cube opened from disk get one
+    //the first time they are read. Either way, reading the cell again returns the same revision.
+    if(i < 0 || i >= static_cast<int>(d_cellRevisions.size()))
+        return 0;
+
+    auto &r = d_cellRevisions[static_cast<std::size_t>(i)];
+    if(r == 0)
+        r = LifTrace::newRevision();
+
+    return r;
+}
+
+void LifStorage::setCellRevision(int i, quint64 rev)
+{
+    //pu_mutex must be held by the caller
+    if(i >= 0 && i < static_cast<int>(d_cellRevisions.size()))
+        d_cellRevisions[static_cast<std::size_t>(i)] = rev;
+}
+
 int LifStorage::index(int dp, int lp) const
 {
     return dp*d_laserPoints + lp;
 }
+
+QString LifStorage::cubePath() const
+{
+    QDir d{BlackchirpCSV::exptDir(d_number,d_path)};
+    return d.absoluteFilePath(QString("%1/%2").arg(BC::CSV::lifDir,BC::CSV::lifCube));
+}
+
+bool LifStorage::openCube()
+{
+    //pu_mutex must be held by the caller
+    if(pu_cube && pu_cube->isOpen())
+        return true;
+
+    //during acquisition the cube is created by the first save
+    if(d_acquiring)
+        return false;
+
+    if(!pu_cube)
+        pu_cube = std::make_unique<LifCubeFile>();
+
+    if(!pu_cube->open(cubePath()))
+    {
+        //experiments recorded before the cube was introduced are converted once
+        if(d_legacyData.empty() && !loadLegacyData())
+            return false;
+        if(!pu_cube->open(cubePath()))
+            return false;
+    }
+
+    d_savedShots = pu_cube->totalShots();
+    return true;
+}
+
+bool LifStorage::createCube(const LifTrace &t)
+{
+    QDir d{BlackchirpCSV::exptDir(d_number,d_path)};
+    if(!d.cd(BC::CSV::lifDir))
+    {
+        if(!d.mkdir(BC::CSV::lifDir))
+            return false;
+    }
+
+    if(!pu_cube)
+        pu_cube = std::make_unique<LifCubeFile>();
+
+    //an existing cube (e.g., from a save after finish) is reused if its layout matches
+    if(pu_cube->open(cubePath(),true))
+    {
+        auto &l = pu_cube->layout();
+        if(l.delayPoints == d_delayPoints && l.laserPoints == d_laserPoints
+                && l.recordLength == t.size() && l.refEnabled == t.hasRefData())
+            return true;
+    }
+
+    LifCubeFile::Layout l;
+    l.delayPoints = d_delayPoints;
+    l.laserPoints = d_laserPoints;
+    l.recordLength = t.size();
+    l.refEnabled = t.hasRefData();
+    l.xSpacing = t.xSpacing();
+    l.lifYMult = t.lifYMult();
+    l.refYMult = t.refYMult();
+
+    //every cell of a new cube is empty
+    std::fill(d_cellRevisions.begin(),d_cellRevisions.end(),0);
+    return pu_cube->create(cubePath(),l);
+}
+
+bool LifStorage::writeToCube(const LifTrace &t)
+{
+    //pu_mutex must be held by the caller
+    if(!pu_cube || !pu_cube->isWritable())
+    {
+        if(!createCube(t))
+            return false;
+    }
+
+    return pu_cube->writeTrace(t);
+}
+
+void LifStorage::writePending()
+{
+    //runs on the global thread pool. The copy into the mapped file is made without holding
+    //pu_mutex: each trace stays in d_pending until it is written, so readers never see a
+    //partially written cell, and the cube is only created or closed with the mutex held.
+    QMutexLocker l(pu_mutex.get());
+    while(!d_pending.empty())
+    {
+        auto it = d_pending.begin();
+        auto idx = it->first;
+        auto t = it->second;
+
+        if(!pu_cube || !pu_cube->isWritable())
+            createCube(t);
+        auto cube = pu_cube.get();
+        l.unlock();
+
+        bool ok = cube && cube->isWritable() && cube->writeTrace(t);
+
+        l.relock();
+        if(ok)
+            setCellRevision(idx,t.revision());
+
+        //a newer trace for the same cell may have been queued during the write
+        it = d_pending.find(idx);
+        if(it != d_pending.end() && it->second.revision() == t.revision())
+            d_pending.erase(it);
+    }
+
+    d_writing = false;
+    d_writeDone.wakeAll();
+}
+
+bool LifStorage::loadLegacyData()
+{
+    //pu_mutex must be held by the caller
+    QDir d{BlackchirpCSV::exptDir(d_number,d_path)};
+    if(!d.cd(BC::CSV::lifDir))
+        return false;
+
+    QFile hdr(d.absoluteFilePath(BC::CSV::lifparams));
+    if(!hdr.open(QIODevice::ReadOnly|QIODevice::Text))
+        return false;
+
+    //lifparams.csv is parsed once, then each trace file is read
+    while(!hdr.atEnd())
+    {
+        auto l = pu_csv->readLine(hdr);
+        if(l.size() < 8)
+            continue;
+
+        bool ok = false;
+        int li = l.constFirst().toInt(&ok);
+        if(!ok)
+            continue;
+        int di = l.at(1).toInt(&ok);
+        if(!ok)
+            continue;
+
+        auto shots = l.at(2).toInt();
+        auto lsize = l.at(3).toInt();
+        auto rsize = l.at(4).toInt();
+
+        QFile dat(d.absoluteFilePath("%1.csv").arg(index(di,li)));
+        if(!dat.open(QIODevice::ReadOnly|QIODevice::Text))
+            continue;
+
+        QVector<qint64> lifData(lsize), refData(rsize);
+        auto line = pu_csv->readLine(dat); //read first line which contains titles
+        for(int i=0; i<lsize; i++)
+        {
+            line = pu_csv->readLine(dat);
+            if(line.isEmpty())
+                break;
+            lifData[i] = line.constFirst().toString().toLongLong(nullptr,36);
+            if(i<rsize && line.size() == 2)
+                refData[i] = line.at(1).toString().toLongLong(nullptr,36);
+        }
+
+        d_legacyData.emplace(index(di,li),LifTrace(di,li,lifData,refData,shots,l.at(5).toDouble(),l.at(6).toDouble(),l.at(7).toDouble()));
+    }
+
+    if(d_legacyData.empty())
+        return false;
+
+    //write the cube alongside the CSV files; if the directory is read-only, the traces are
+    //served from memory instead
+    auto &first = d_legacyData.cbegin()->second;
+    if(!createCube(first))
+    {
+        pu_cube->close();
+        return false;
+    }
+
+    bool ok = true;
+    for(auto it = d_legacyData.cbegin(); it != d_legacyData.cend(); ++it)
+    {
+        if(pu_cube->writeTrace(it->second))
+            setCellRevision(it->first,it->second.revision());
+        else
+            ok = false;
+    }
+    pu_cube->close();
+
+    //traces whose size differs from the first cannot be stored in the cube
+    if(!ok)
+    {
+        QFile::remove(cubePath());
+        return false;
+    }
+
+    d_legacyData.clear();
+
+    return true;
+}
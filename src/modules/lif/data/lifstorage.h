@@ -2,15 +2,20 @@
 #define LIFSTORAGE_H
 
 #include <memory>
+#include <vector>
 #include <QDateTime>
 #include <QMutex>
+#include <QWaitCondition>
 
 #include <data/storage/datastoragebase.h>
 #include <modules/lif/data/liftrace.h>
 
 class BlackchirpCSV;
+class LifCubeFile;
 
 namespace BC::Key::LifStorage {
+static const QString key{"LifStorage"};
+static const QString csvCopy{"csvCopy"};
 static const QString lifGateStart("LifGateStartPoint");
 static const QString lifGateEnd("LifGateEndPoint");
 static const QString refGateStart("RefGateStartPoint");
@@ -39,20 +44,36 @@ public:
 
     LifTrace getLifTrace(int di, int li);
     LifTrace currentLifTrace() const { return d_currentTrace; };
-    LifTrace loadLifTrace(int di, int li);
-    void writeLifTrace(const LifTrace t);
+    bool exportCsv();
 
     void addTrace(const LifTrace t);
+    void addWaveform(const LifDigitizerConfig &c, const QVector<qint8> b, int di, int li);
+    void flush();
 
     void writeProcessingSettings(const LifTrace::LifProcSettings &c);
     bool readProcessingSettings(LifTrace::LifProcSettings &out);
 
 
 private:
-    bool d_acquiring{false}, d_nextNew{true};
-    std::map<int,LifTrace> d_data;
+    bool d_acquiring{false}, d_nextNew{true}, d_csvCopy{false};
+    std::unique_ptr<LifCubeFile> pu_cube;
+    std::map<int,LifTrace> d_legacyData;
+    std::map<int,LifTrace> d_pending;
+    std::vector<quint64> d_cellRevisions;
+    bool d_writing{false};
+    QWaitCondition d_writeDone;
     LifTrace d_currentTrace;
-
+    qint64 d_savedShots{0};
+    int d_currentSavedShots{0};
+
+    QString cubePath() const;
+    bool openCube();
+    bool createCube(const LifTrace &t);
+    bool loadLegacyData();
+    bool writeToCube(const LifTrace &t);
+    void writePending();
+    quint64 cellRevision(int i);
+    void setCellRevision(int i, quint64 rev);
 
     int index(int dp, int lp) const;
 
@@ -1,7 +1,130 @@
 #include <modules/lif/data/liftrace.h>
-#include <QtEndian>
 
 #include <data/analysis/analysis.h>
+#include <data/analysis/cpuaverager.h>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+//every new or modified trace gets a distinct revision, so cached results can be matched to the data
+static std::atomic<quint64> s_nextRevision{1};
+
+static quint64 nextRevision()
+{
+    return s_nextRevision.fetch_add(1,std::memory_order_relaxed);
+}
+
+template<typename T>
+static void lowPass(const T *in, int n, double alpha, double *out)
+{
+    //the filter is recursive, so each point depends on the one before it
+    if(n < 1)
+        return;
+
+    out[0] = static_cast<double>(in[0]);
+    for(int i=1; i<n; ++i)
+        out[i] = alpha*out[i-1] + (1.0-alpha)*static_cast<double>(in[i]);
+}
+
+static double savGolPoint(const double *y, int n, const double *c, int win, int i)
+{
+    int halfWin = win/2;
+    double val = 0.0;
+    if(i >= halfWin && i+halfWin < n)
+    {
+        //interior points: a plain dot product
+        const double *yy = y + i - halfWin;
+        for(int j=0; j<win; ++j)
+            val += c[j]*yy[j];
+        return val;
+    }
+
+    //near the ends, points outside the data are reflected as in Analysis::savGolSmooth
+    for(int j=0; j<win; ++j)
+    {
+        int k = i+j-halfWin;
+        if(k < 0)
+            val += c[j]*y[-k];
+        else if(k >= n)
+            val += c[j]*y[i-j-halfWin];
+        else
+            val += c[j]*y[k];
+    }
+    return val;
+}
+
+template<int bpp>
+static void deinterleave(const char *src, int n, char *a, char *b)
+{
+    for(int i=0; i<n; ++i)
+    {
+        memcpy(a + i*bpp,src + 2*i*bpp,bpp);
+        memcpy(b + i*bpp,src + (2*i+1)*bpp,bpp);
+    }
+}
+
+static bool decodeAdd(const LifDigitizerConfig &c, const QVector<qint8> &b, qint64 *lif, qint64 *ref)
+{
+    //adds one waveform to the raw sums using the CpuAverager kernels. Interleaved channels are
+    //first split into a scratch buffer so that each channel is contiguous.
+    int channels = c.d_refEnabled ? 2 : 1;
+    int bpp = c.d_bytesPerPoint;
+    int n = c.d_recordLength;
+    if(n < 1 || b.size() < static_cast<qint64>(channels)*n*bpp)
+        return false;
+
+    //the averager is set up once per thread and digitizer layout, since initialize() detects the
+    //CPU features and plans the chunks
+    struct Decoder {
+        int channels{0};
+        int n{0};
+        int bpp{0};
+        bool bigEndian{false};
+        bool ok{false};
+        CpuAverager avg;
+    };
+    thread_local Decoder dec;
+
+    bool bigEndian = c.d_byteOrder == DigitizerConfig::BigEndian;
+    if(dec.channels != channels || dec.n != n || dec.bpp != bpp || dec.bigEndian != bigEndian)
+    {
+        dec.channels = channels;
+        dec.n = n;
+        dec.bpp = bpp;
+        dec.bigEndian = bigEndian;
+        dec.ok = dec.avg.initialize(channels,n,bpp,bigEndian,1);
+    }
+    if(!dec.ok)
+        return false;
+    auto &avg = dec.avg;
+
+    auto src = reinterpret_cast<const char*>(b.constData());
+    if(channels == 2 && c.d_channelOrder == LifDigitizerConfig::Interleaved)
+    {
+        thread_local std::vector<char> scratch;
+        scratch.resize(2*n*bpp);
+        auto l = scratch.data();
+        auto r = l + n*bpp;
+        switch(bpp) {
+        case 1:
+            deinterleave<1>(src,n,l,r);
+            break;
+        case 2:
+            deinterleave<2>(src,n,l,r);
+            break;
+        default:
+            deinterleave<4>(src,n,l,r);
+            break;
+        }
+        src = scratch.data();
+    }
+
+    avg.parseRecord(src,lif,0);
+    if(channels == 2)
+        avg.parseRecord(src,ref,1);
+
+    return true;
+}
 
 LifTrace::LifTrace() : p_data(new LifTraceData)
 {
@@ -19,68 +142,15 @@ LifTrace::LifTrace(const LifDigitizerConfig &c, const QVector<qint8> b, int dInd
     p_data->laserIndex = lIndex;
 
     p_data->lifData.resize(c.d_recordLength);
-    int incr = c.d_bytesPerPoint;
-    int refoffset = c.d_recordLength;
-    if(c.d_refEnabled && (c.d_channelOrder == LifDigitizerConfig::Interleaved))
-    {
-        incr = 2*c.d_bytesPerPoint;
-        refoffset = c.d_bytesPerPoint;
-    }
-
-    for(int i=0; i<incr*c.d_recordLength; i+=incr)
-    {
-        qint64 dat = 0;
-        if(c.d_bytesPerPoint == 1)
-        {
-            auto y = b.at(i);
-            dat = static_cast<qint64>(y);
-        }
-        else
-        {
-            auto y1 = static_cast<quint8>(b.at(2*i));
-            auto y2 = static_cast<quint8>(b.at(2*i + 1));
-            qint16 y = 0;
-            y |= y1;
-            y |= (y2 << 8);
-            if(c.d_byteOrder == DigitizerConfig::BigEndian)
-                y = qFromBigEndian(y);
-            else
-                y = qFromLittleEndian(y);
-            dat = static_cast<qint64>(y);
-        }
-        p_data->lifData[i/incr] = dat;
-    }
     if(c.d_refEnabled)
-    {
         p_data->refData.resize(c.d_recordLength);
-        qint64 dat = 0;
-        for(int i=c.d_bytesPerPoint*refoffset; i<refoffset+incr*c.d_recordLength; i+=incr)
-        {
-            if(c.d_bytesPerPoint == 1)
-            {
-                char y = b.at(i);
-                dat = static_cast<qint64>(y);
-            }
-            else
-            {
-                auto y1 = static_cast<quint8>(b.at(2*i));
-                auto y2 = static_cast<quint8>(b.at(2*i + 1));
-                qint16 y = 0;
-                y |= y1;
-                y |= (y2 << 8);
-                if(c.d_byteOrder == DigitizerConfig::BigEndian)
-                    y = qFromBigEndian(y);
-                else
-                    y = qFromLittleEndian(y);
-                dat = static_cast<qint64>(y);
-            }
-            p_data->refData[(i-c.d_bytesPerPoint*refoffset)/incr] = dat;
-        }
-    }
+
+    decodeAdd(c,b,p_data->lifData.data(),c.d_refEnabled ? p_data->refData.data() : nullptr);
     p_data->shots = c.d_numAverages;
+    p_data->revision = nextRevision();
 }
 
-LifTrace::LifTrace(int di, int li, QVector<qint64> ld, QVector<qint64> rd, int shots, double xsp, double lym, double rym) : p_data(new LifTraceData)
+LifTrace::LifTrace(int di, int li, QVector<qint64> ld, QVector<qint64> rd, int shots, double xsp, double lym, double rym, quint64 rev) : p_data(new LifTraceData)
 {
     p_data->delayIndex = di;
     p_data->laserIndex = li;
@@ -90,6 +160,8 @@ LifTrace::LifTrace(int di, int li, QVector<qint64> ld, QVector<qint64> rd, int s
     p_data->xSpacing = xsp;
     p_data->lifYMult = lym;
     p_data->refYMult = rym;
+    //stored traces keep the revision they were written with, so reading them again hits the cache
+    p_data->revision = rev > 0 ? rev : nextRevision();
 }
 
 LifTrace::LifTrace(const LifTrace &other) : p_data(other.p_data)
@@ -105,46 +177,120 @@ LifTrace &LifTrace::operator=(const LifTrace &other)
 
 double LifTrace::integrate(const LifProcSettings &s) const
 {
-    //validate ranges (sort of; if ranges are bad this will return 0);
-    //lif start must be in range of data
-    auto ls = qBound(0,s.lifGateStart,p_data->lifData.size()-2);
-    //lif end must be greater than start and in range of data
-    auto le = qBound(ls+1,s.lifGateEnd,p_data->lifData.size()-1);
+    return normalizedIntegral(lifIntegral(s),refIntegral(s));
+}
 
-    //do trapezoidal integration in integer/point space.
-    //each segment has a width of 1 unit, and the area is (y_i + y_{i+1})/2
-    //(think of it as end points have weight of 1, middle points have weight 2)
-    //add up all y_i + y_{i+1}, then divide by 2 at the end
+double LifTrace::lifIntegral(const LifProcSettings &s) const
+{
+    auto scale = p_data->lifYMult;
+    if(p_data->shots > 1)
+        scale /= static_cast<double>(p_data->shots);
 
-    auto l = lifToXY(s);
+    return gateIntegral(p_data->lifData,s.lifGateStart,s.lifGateEnd,scale,s);
+}
 
+double LifTrace::refIntegral(const LifProcSettings &s) const
+{
+    if(!hasRefData())
+        return 0.0;
 
-    double sum = 0.0;
-    for(int i = ls; i<le-1; i++)
-        sum += l.at(i).y() + l.at(i+1).y();
+    auto scale = p_data->refYMult;
+    if(p_data->shots > 1)
+        scale /= static_cast<double>(p_data->shots);
 
-    auto lifInt = sum/2.0;
+    return gateIntegral(p_data->refData,s.refGateStart,s.refGateEnd,scale,s);
+}
 
-    //if no reference; just return raw integral
-    if(!hasRefData())
+double LifTrace::normalizedIntegral(double lifInt, double refInt)
+{
+    //if there is no reference, refInt is 0 and the raw integral is returned
+    //don't divide by 0!
+    if(qFuzzyCompare(1.0,1.0+refInt))
         return lifInt;
+    else
+        return lifInt/refInt;
+}
 
-    auto r = refToXY(s);
+quint64 LifTrace::newRevision()
+{
+    return nextRevision();
+}
 
-    auto rs = qBound(0,s.refGateStart,p_data->refData.size()-2);
-    auto re = qBound(rs+1,s.refGateEnd,p_data->refData.size()-1);
+quint64 LifTrace::revision() const
+{
+    return p_data->revision;
+}
 
-    sum = 0.0;
-    for(int i = rs; i<re-1; i++)
-        sum += r.at(i).y() + r.at(i+1).y();
+double LifTrace::gateIntegral(const QVector<qint64> &d, int gateStart, int gateEnd, double scale, const LifProcSettings &s)
+{
+    //validate ranges (sort of; if ranges are bad this will return 0);
+    //start must be in range of data
+    auto n = d.size();
+    auto gs = qBound(0,gateStart,n-2);
+    //end must be greater than start and in range of data
+    auto ge = qBound(gs+1,gateEnd,n-1);
 
-    double refInt = sum/2.0;
+    //do trapezoidal integration in integer/point space.
+    //each segment has a width of 1 unit, and the area is (y_i + y_{i+1})/2
+    //so points gs and ge-1 have a weight of 1, and the points between them have a weight of 2.
+    //The filters are linear, so the scale factor is applied to the integral at the end
+    auto first = gs;
+    auto last = ge-1;
+    if(last <= first)
+        return 0.0;
 
-    //don't divide by 0!
-    if(qFuzzyCompare(1.0,1.0+refInt))
-        return lifInt;
+    bool lp = s.lowPassAlpha > 1e-5;
+    if(!lp && !s.savGolEnabled)
+    {
+        //no filtering: sum the raw integers directly
+        const qint64 *y = d.constData();
+        qint64 sum = 0;
+        for(int i=first+1; i<last; ++i)
+            sum += y[i];
+        return scale*(static_cast<double>(2*sum + y[first] + y[last]))/2.0;
+    }
+
+    //the low pass filter runs from the start of the trace, and Sav-Gol needs up to half a window
+    //past the end of the gate; nothing beyond that is computed
+    QVector<double> kernel;
+    int hi = last+1;
+    if(s.savGolEnabled)
+    {
+        kernel = Analysis::savGolKernel(s.savGolWin,s.savGolPoly);
+        hi = qMin(n,last + kernel.size()/2 + 1);
+    }
+
+    thread_local std::vector<double> buf;
+    if(static_cast<int>(buf.size()) < hi)
+        buf.resize(hi);
+    double *y = buf.data();
+
+    if(lp)
+        lowPass(d.constData(),hi,s.lowPassAlpha,y);
     else
-        return lifInt/refInt;
+    {
+        for(int i=0; i<hi; ++i)
+            y[i] = static_cast<double>(d.at(i));
+    }
+
+    double sum = 0.0;
+    if(s.savGolEnabled)
+    {
+        const double *c = kernel.constData();
+        int win = kernel.size();
+        //savGolPoint only reads indices below hi when n is larger than hi
+        for(int i=first+1; i<last; ++i)
+            sum += savGolPoint(y,n,c,win,i);
+        sum = 2.0*sum + savGolPoint(y,n,c,win,first) + savGolPoint(y,n,c,win,last);
+    }
+    else
+    {
+        for(int i=first+1; i<last; ++i)
+            sum += y[i];
+        sum = 2.0*sum + y[first] + y[last];
+    }
+
+    return scale*sum/2.0;
 }
 
 int LifTrace::delayIndex() const
@@ -247,16 +393,37 @@ void LifTrace::add(const LifTrace &other)
     if(other.size() != size())
         return;
 
-    auto l = other.lifRaw();
-    auto r = other.refRaw();
-
-    for(int i=0; i<p_data->lifData.size(); i++)
-        p_data->lifData[i] += l.at(i);
+    //hoist the pointers so that the loops do not check for detaching on every element
+    const int n = size();
+    auto l = other.p_data->lifData.constData();
+    auto ld = p_data->lifData.data();
+    for(int i=0; i<n; i++)
+        ld[i] += l[i];
 
-    for(int i=0; i<p_data->refData.size(); i++)
-        p_data->refData[i] += r.at(i);
+    if(hasRefData() && other.hasRefData())
+    {
+        auto r = other.p_data->refData.constData();
+        auto rd = p_data->refData.data();
+        for(int i=0; i<n; i++)
+            rd[i] += r[i];
+    }
 
     p_data->shots += other.shots();
+    p_data->revision = nextRevision();
+}
+
+bool LifTrace::addWaveform(const LifDigitizerConfig &c, const QVector<qint8> &b)
+{
+    //decodes a new waveform directly into the sums, equivalent to add(LifTrace(c,b,...))
+    if(c.d_recordLength != size() || c.d_refEnabled != hasRefData())
+        return false;
+
+    if(!decodeAdd(c,b,p_data->lifData.data(),c.d_refEnabled ? p_data->refData.data() : nullptr))
+        return false;
+
+    p_data->shots += c.d_numAverages;
+    p_data->revision = nextRevision();
+    return true;
 }
 
 void LifTrace::rollAvg(const LifTrace &other, int numShots)
@@ -267,16 +434,29 @@ void LifTrace::rollAvg(const LifTrace &other, int numShots)
         add(other);
     else
     {
-        auto l = other.lifRaw();
-        auto r = other.refRaw();
+        if(other.size() != size())
+            return;
 
-        for(int i=0; i<p_data->lifData.size(); i++)
-            p_data->lifData[i] = Analysis::intRoundClosest(numShots*(p_data->lifData.at(i)+l.at(i)),numShots+1);
+        //same rounding as intRoundClosest, without a division per point
+        Analysis::RoundClosestDivider div(numShots+1);
+        const qint64 ns = numShots;
+        const int n = size();
 
-        for(int i=0; i<p_data->refData.size(); i++)
-            p_data->refData[i] = Analysis::intRoundClosest(numShots*(p_data->refData.at(i)+r.at(i)),numShots+1);
+        auto l = other.p_data->lifData.constData();
+        auto ld = p_data->lifData.data();
+        for(int i=0; i<n; i++)
+            ld[i] = div(ns*(ld[i]+l[i]));
+
+        if(hasRefData() && other.hasRefData())
+        {
+            auto r = other.p_data->refData.constData();
+            auto rd = p_data->refData.data();
+            for(int i=0; i<n; i++)
+                rd[i] = div(ns*(rd[i]+r[i]));
+        }
 
         p_data->shots = numShots;
+        p_data->revision = nextRevision();
     }
 }
 
@@ -285,15 +465,14 @@ QVector<QPointF> LifTrace::processXY(const QVector<double> d, const LifProcSetti
     //low-pass first, then Sav-Gol
     auto ynew = d;
     if(s.lowPassAlpha > 1e-5)
-    {
-        for(int i=1; i<ynew.size(); i++)
-            ynew[i] = s.lowPassAlpha*ynew.at(i-1) + (1-s.lowPassAlpha)*ynew.at(i);
-    }
+        lowPass(d.constData(),d.size(),s.lowPassAlpha,ynew.data());
 
     if(s.savGolEnabled)
     {
-        auto coefs = Analysis::calcSavGolCoefs(s.savGolWin,s.savGolPoly);
-        ynew = Analysis::savGolSmooth(coefs,0,ynew,xSpacingns());
+        auto kernel = Analysis::savGolKernel(s.savGolWin,s.savGolPoly);
+        auto y = ynew;
+        for(int i=0; i<ynew.size(); i++)
+            ynew[i] = savGolPoint(y.constData(),y.size(),kernel.constData(),kernel.size(),i);
     }
 
     QVector<QPointF> out;
@@ -15,7 +15,7 @@ class LifTrace
 public:
     LifTrace();
     explicit LifTrace(const LifDigitizerConfig &c, const QVector<qint8> b, int dIndex, int lIndex);
-    explicit LifTrace(int di, int li, QVector<qint64> ld, QVector<qint64> rd, int shots, double xsp, double lym, double rym);
+    explicit LifTrace(int di, int li, QVector<qint64> ld, QVector<qint64> rd, int shots, double xsp, double lym, double rym, quint64 rev = 0);
     LifTrace(const LifTrace &other);
     LifTrace &operator=(const LifTrace &other);
     ~LifTrace() = default;
@@ -32,6 +32,11 @@ public:
     };
 
     double integrate(const LifProcSettings &s) const;
+    double lifIntegral(const LifProcSettings &s) const;
+    double refIntegral(const LifProcSettings &s) const;
+    static double normalizedIntegral(double lifInt, double refInt);
+    static quint64 newRevision();
+    quint64 revision() const;
     int delayIndex() const;
     int laserIndex() const;
     QVector<QPointF> lifToXY(const LifProcSettings &s) const;
@@ -49,11 +54,13 @@ public:
 
 
     void add(const LifTrace &other);
+    bool addWaveform(const LifDigitizerConfig &c, const QVector<qint8> &b);
     void rollAvg(const LifTrace &other, int numShots);
 
 private:
     QSharedDataPointer<LifTraceData> p_data;
     QVector<QPointF> processXY(const QVector<double> d, const LifProcSettings &s) const;
+    static double gateIntegral(const QVector<qint64> &d, int gateStart, int gateEnd, double scale, const LifProcSettings &s);
 
 
 };
@@ -65,6 +72,7 @@ public:
     int delayIndex{-1}, laserIndex{-1};
     QVector<qint64> lifData, refData;
     int shots{0};
+    quint64 revision{0};
 };
 
 #endif // LIFTRACE_H
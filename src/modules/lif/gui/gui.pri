@@ -9,6 +9,8 @@ HEADERS += \
     $$PWD/liflaserwidget.h \
     $$PWD/lifprocessingwidget.h \
     $$PWD/lifsliceplot.h \
+    $$PWD/lifspectrogramdata.h \
+    $$PWD/lifspectrogramitem.h \
     $$PWD/lifspectrogramplot.h \
     $$PWD/liftraceplot.h \
     $$PWD/wizardlifconfigpage.h
@@ -20,6 +22,8 @@ SOURCES += \
     $$PWD/liflaserwidget.cpp \
     $$PWD/lifprocessingwidget.cpp \
     $$PWD/lifsliceplot.cpp \
+    $$PWD/lifspectrogramdata.cpp \
+    $$PWD/lifspectrogramitem.cpp \
     $$PWD/lifspectrogramplot.cpp \
     $$PWD/liftraceplot.cpp \
     $$PWD/wizardlifconfigpage.cpp
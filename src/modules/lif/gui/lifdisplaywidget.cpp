@@ -3,6 +3,7 @@
 #include <QHBoxLayout>
 #include <QVBoxLayout>
 #include <QGroupBox>
+#include <QtConcurrent/QtConcurrent>
 
 #include <data/storage/settingsstorage.h>
 #include <modules/lif/gui/lifsliceplot.h>
@@ -42,6 +43,9 @@ LifDisplayWidget::LifDisplayWidget(QWidget *parent) :
     pgb->setLayout(pvbl);
     pvbl->addWidget(p_procWidget);
 
+    p_reprocWatcher = new QFutureWatcher<QVector<double>>(this);
+    connect(p_reprocWatcher,&QFutureWatcher<QVector<double>>::finished,this,&LifDisplayWidget::reprocessComplete);
+
     connect(p_spectrogramPlot,&LifSpectrogramPlot::laserSlice,this,&LifDisplayWidget::changeLaserSlice);
     connect(p_spectrogramPlot,&LifSpectrogramPlot::delaySlice,this,&LifDisplayWidget::changeDelaySlice);
 
@@ -63,6 +67,7 @@ LifDisplayWidget::LifDisplayWidget(QWidget *parent) :
 
 LifDisplayWidget::~LifDisplayWidget()
 {
+    p_reprocWatcher->waitForFinished();
 }
 
 void LifDisplayWidget::prepareForExperiment(const Experiment &e)
@@ -74,6 +79,12 @@ void LifDisplayWidget::prepareForExperiment(const Experiment &e)
     p_procWidget->setEnabled(false);
     d_currentIntegratedData.clear();
 
+    //a reprocess of the previous experiment may still be running
+    p_reprocWatcher->waitForFinished();
+    d_reprocBusy = false;
+    d_reprocPending = false;
+    p_spectrogramPlot->canvas()->unsetCursor();
+
     d_dString = QString("Delay: %1 ")+BC::Unit::us;
     d_lString = QString("Laser: %1 ");
     auto it = e.d_hardware.find(BC::Key::LifLaser::key);
@@ -94,6 +105,7 @@ void LifDisplayWidget::prepareForExperiment(const Experiment &e)
         d_delayReverse = e.lifConfig()->d_delayStepUs < 0.0;
         d_laserReverse = e.lifConfig()->d_laserPosStep < 0.0;
         d_currentIntegratedData.resize(e.lifConfig()->d_delayPoints*e.lifConfig()->d_laserPosPoints);
+        d_processor.reset(e.lifConfig()->d_delayPoints,e.lifConfig()->d_laserPosPoints);
     }
     else
     {
@@ -126,12 +138,15 @@ void LifDisplayWidget::updatePoint()
         li = lp-li-1;
 
     //3. Integrate and store integral in matrix
-    auto d = t.integrate(p_procWidget->getSettings());
+    auto d = d_processor.update(t,p_procWidget->getSettings());
     d_currentIntegratedData[li + di*lp] = d;
 
-    //4. Update spectrogram and spectrogram indices
-    p_spectrogramPlot->updateData(d_currentIntegratedData,lp);
-    p_spectrogramPlot->setLiveIndices(di,li);
+    //a reprocess in progress may have read this trace before it changed
+    if(d_reprocBusy)
+        d_reprocPending = true;
+
+    //4. Update the spectrogram cell and live indices
+    p_spectrogramPlot->updatePoint(di,li,d);
 
     //5. Update plots if spectrogram index matches appropriate current trace index
     auto cdi = p_spectrogramPlot->currentDelayIndex();
@@ -176,43 +191,78 @@ void LifDisplayWidget::changeDelaySlice(int li)
 
 void LifDisplayWidget::reprocess()
 {
-    auto lp = ps_lifStorage->d_laserPoints;
-    auto dp = ps_lifStorage->d_delayPoints;
-    d_currentIntegratedData = QVector<double>(dp*lp);
+    if(!ps_lifStorage)
+        return;
+
+    //integration runs on a worker thread. If asked again in the meantime, go again when it
+    //finishes; traces whose data and settings are unchanged are not integrated a second time
+    if(d_reprocBusy)
+    {
+        d_reprocPending = true;
+        return;
+    }
+
+    d_reprocBusy = true;
+    d_reprocPending = false;
+    p_spectrogramPlot->canvas()->setCursor(QCursor(Qt::BusyCursor));
 
     auto ps = p_procWidget->getSettings();
-    for(int li=0; li<lp; li++)
+    auto st = ps_lifStorage;
+    p_reprocWatcher->setFuture(QtConcurrent::run([this,ps,st](){
+        return d_processor.process(ps,[st](int di, int li){ return st->getLifTrace(di,li); });
+    }));
+}
+
+void LifDisplayWidget::reprocessComplete()
+{
+    if(!d_reprocBusy)
+        return;
+
+    d_reprocBusy = false;
+    p_spectrogramPlot->canvas()->unsetCursor();
+    if(!ps_lifStorage)
+        return;
+
+    auto lp = ps_lifStorage->d_laserPoints;
+    auto dp = ps_lifStorage->d_delayPoints;
+    auto r = p_reprocWatcher->result();
+    //a result for a different grid is stale; it is discarded, but a pending request still runs
+    if(r.size() == dp*lp)
     {
-        auto mli = li;
-        if(d_laserReverse)
-            mli = lp-li-1;
-        for(int di=0; di<dp; di++)
+        d_currentIntegratedData = QVector<double>(dp*lp);
+        for(int li=0; li<lp; li++)
         {
-            auto mdi = di;
-            if(d_delayReverse)
-                mdi = dp-di-1;
-
-            auto t = ps_lifStorage->getLifTrace(di,li);
-            auto d = t.integrate(ps);
-            d_currentIntegratedData[mli+mdi*lp] = d;
+            auto mli = li;
+            if(d_laserReverse)
+                mli = lp-li-1;
+            for(int di=0; di<dp; di++)
+            {
+                auto mdi = di;
+                if(d_delayReverse)
+                    mdi = dp-di-1;
+
+                d_currentIntegratedData[mli+mdi*lp] = r.at(li+di*lp);
+            }
         }
-    }
 
-    p_spectrogramPlot->updateData(d_currentIntegratedData,lp);
+        p_spectrogramPlot->updateData(d_currentIntegratedData,lp);
 
-    auto cdi = p_spectrogramPlot->currentDelayIndex();
-    auto cli = p_spectrogramPlot->currentLaserIndex();
+        auto cdi = p_spectrogramPlot->currentDelayIndex();
+        auto cli = p_spectrogramPlot->currentLaserIndex();
 
-    p_laserSlicePlot->setData(laserSlice(cdi),d_dString.arg(p_spectrogramPlot->delayVal(cdi),0,'f',3));
-    p_delaySlicePlot->setData(delaySlice(cli),d_lString.arg(p_spectrogramPlot->laserVal(cli),0,'f',d_lDec));
+        p_laserSlicePlot->setData(laserSlice(cdi),d_dString.arg(p_spectrogramPlot->delayVal(cdi),0,'f',3));
+        p_delaySlicePlot->setData(delaySlice(cli),d_lString.arg(p_spectrogramPlot->laserVal(cli),0,'f',d_lDec));
 
-    if(d_delayReverse)
-        cdi = dp - cdi -1;
-    if(d_laserReverse)
-        cli = lp - cli -1;
-    auto lt = ps_lifStorage->getLifTrace(cdi,cli);
-    p_lifTracePlot->setTrace(lt);
+        if(d_delayReverse)
+            cdi = dp - cdi -1;
+        if(d_laserReverse)
+            cli = lp - cli -1;
+        auto lt = ps_lifStorage->getLifTrace(cdi,cli);
+        p_lifTracePlot->setTrace(lt);
+    }
 
+    if(d_reprocPending)
+        reprocess();
 }
 
 void LifDisplayWidget::resetProc()
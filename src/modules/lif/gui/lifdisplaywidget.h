@@ -4,9 +4,11 @@
 #include <QWidget>
 
 #include <QVector>
+#include <QFutureWatcher>
 #include <memory.h>
 
 #include <data/experiment/experiment.h>
+#include <modules/lif/data/lifprocessor.h>
 
 class LifSlicePlot;
 class LifTracePlot;
@@ -44,6 +46,9 @@ private:
     std::shared_ptr<LifStorage> ps_lifStorage;
     bool d_delayReverse{false}, d_laserReverse{false};
     QVector<double> d_currentIntegratedData;
+    LifProcessor d_processor;
+    QFutureWatcher<QVector<double>> *p_reprocWatcher;
+    bool d_reprocBusy{false}, d_reprocPending{false};
 
     LifSlicePlot *p_delaySlicePlot, *p_laserSlicePlot;
     LifTracePlot *p_lifTracePlot;
@@ -54,6 +59,7 @@ private:
     QString d_lString;
     int d_lDec{2};
 
+    void reprocessComplete();
 
 };
 
@@ -0,0 +1,77 @@
+#include "lifspectrogramdata.h"
+
+LifSpectrogramData::LifSpectrogramData() : QwtMatrixRasterData()
+{
+}
+
+void LifSpectrogramData::setMatrix(const QVector<double> &values, int numColumns)
+{
+    setValueMatrix(values,numColumns);
+    rescan();
+    d_dirty.clear();
+    d_allDirty = true;
+}
+
+bool LifSpectrogramData::setCell(int row, int col, double value)
+{
+    //returns true if the z range changed
+    if(row < 0 || col < 0 || row >= numRows() || col >= numColumns())
+        return false;
+
+    auto idx = row*numColumns() + col;
+    auto old = valueMatrix().at(idx);
+    if(old == value)
+        return false;
+
+    setValue(row,col,value);
+
+    if(!d_allDirty)
+    {
+        if(static_cast<int>(d_dirty.size()) > valueMatrix().size()/4)
+        {
+            d_dirty.clear();
+            d_allDirty = true;
+        }
+        else
+            d_dirty.push_back(idx);
+    }
+
+    auto zMin = d_zMin, zMax = d_zMax;
+    //0 is always in range, so only a nonzero extreme moving inward requires a rescan
+    if((old == d_zMax && old > 0.0 && value < old) || (old == d_zMin && old < 0.0 && value > old))
+        rescan();
+    else
+    {
+        d_zMin = qMin(d_zMin,value);
+        d_zMax = qMax(d_zMax,value);
+    }
+
+    return zMin != d_zMin || zMax != d_zMax;
+}
+
+QwtInterval LifSpectrogramData::zRange() const
+{
+    return QwtInterval(d_zMin,d_zMax);
+}
+
+bool LifSpectrogramData::takeDirty(std::vector<int> &out)
+{
+    //returns true if the whole raster must be redrawn
+    bool all = d_allDirty;
+    out.clear();
+    out.swap(d_dirty);
+    d_allDirty = false;
+    return all;
+}
+
+void LifSpectrogramData::rescan()
+{
+    d_zMin = 0.0;
+    d_zMax = 0.0;
+    auto &m = valueMatrix();
+    for(int i=0; i<m.size(); i++)
+    {
+        d_zMin = qMin(d_zMin,m.at(i));
+        d_zMax = qMax(d_zMax,m.at(i));
+    }
+}
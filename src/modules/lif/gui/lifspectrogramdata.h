@@ -0,0 +1,37 @@
+#ifndef LIFSPECTROGRAMDATA_H
+#define LIFSPECTROGRAMDATA_H
+
+#include <qwt6/qwt_matrix_raster_data.h>
+
+#include <vector>
+
+/*!
+ * \brief Raster data for the LIF spectrogram that supports single-cell updates
+ *
+ * setCell() changes one value in place and keeps the running z range (which always includes 0,
+ * matching the behavior of a full rescan) up to date. The range only has to be recomputed from
+ * scratch when the cell holding the current minimum or maximum moves inward.
+ *
+ * Cells changed since the last call to takeDirty() are recorded so that LifSpectrogramItem can
+ * repaint only the affected part of its cached image. If a large fraction of the grid changes,
+ * or the whole matrix is replaced, the entire raster is reported as dirty instead.
+ */
+class LifSpectrogramData : public QwtMatrixRasterData
+{
+public:
+    LifSpectrogramData();
+
+    void setMatrix(const QVector<double> &values, int numColumns);
+    bool setCell(int row, int col, double value);
+    QwtInterval zRange() const;
+    bool takeDirty(std::vector<int> &out);
+
+private:
+    double d_zMin{0.0}, d_zMax{0.0};
+    bool d_allDirty{true};
+    std::vector<int> d_dirty;
+
+    void rescan();
+};
+
+#endif // LIFSPECTROGRAMDATA_H
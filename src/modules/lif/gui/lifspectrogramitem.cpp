@@ -0,0 +1,82 @@
+#include "lifspectrogramitem.h"
+
+#include <modules/lif/gui/lifspectrogramdata.h>
+
+#include <qwt6/qwt_color_map.h>
+#include <math.h>
+
+LifSpectrogramItem::LifSpectrogramItem() : QwtPlotSpectrogram()
+{
+}
+
+void LifSpectrogramItem::setSpectrogramData(LifSpectrogramData *d)
+{
+    p_data = d;
+    d_cache = QImage();
+    setData(d);
+}
+
+QImage LifSpectrogramItem::renderImage(const QwtScaleMap &xMap, const QwtScaleMap &yMap, const QRectF &area, const QSize &imageSize) const
+{
+    if(!p_data)
+        return QwtPlotSpectrogram::renderImage(xMap,yMap,area,imageSize);
+
+    CacheKey k{xMap.s1(),xMap.s2(),xMap.p1(),xMap.p2(),
+               yMap.s1(),yMap.s2(),yMap.p1(),yMap.p2(),
+               area,imageSize,p_data->interval(Qt::ZAxis)};
+
+    bool all = p_data->takeDirty(d_dirty);
+    auto cm = colorMap();
+    if(all || d_cache.isNull() || !(k == d_cacheKey) || !cm || cm->format() != QwtColorMap::RGB
+            || d_cache.format() != QImage::Format_ARGB32)
+    {
+        d_cache = QwtPlotSpectrogram::renderImage(xMap,yMap,area,imageSize);
+        d_cacheKey = k;
+        return d_cache;
+    }
+
+    //same pixel loop as QwtPlotSpectrogram::renderTile, restricted to the dirty cells
+    auto range = k.z;
+    auto bounds = d_cache.rect();
+    for(auto idx : d_dirty)
+    {
+        auto r = cellRect(idx,xMap,yMap).intersected(bounds);
+        for(int y=r.top(); y<=r.bottom(); y++)
+        {
+            const double ty = yMap.invTransform(y);
+            auto line = reinterpret_cast<QRgb*>(d_cache.scanLine(y)) + r.left();
+            for(int x=r.left(); x<=r.right(); x++)
+                *line++ = cm->rgb(range,p_data->value(xMap.invTransform(x),ty));
+        }
+    }
+
+    return d_cache;
+}
+
+QRect LifSpectrogramItem::cellRect(int idx, const QwtScaleMap &xMap, const QwtScaleMap &yMap) const
+{
+    //with bilinear interpolation, a cell affects everything between its neighbors' centers
+    auto cols = p_data->numColumns();
+    auto rows = p_data->numRows();
+    auto xi = p_data->interval(Qt::XAxis);
+    auto yi = p_data->interval(Qt::YAxis);
+    auto dx = xi.width()/static_cast<double>(cols);
+    auto dy = yi.width()/static_cast<double>(rows);
+    auto col = idx%cols;
+    auto row = idx/cols;
+
+    auto px1 = xMap.transform(xi.minValue() + (col-1)*dx);
+    auto px2 = xMap.transform(xi.minValue() + (col+2)*dx);
+    auto py1 = yMap.transform(yi.minValue() + (row-1)*dy);
+    auto py2 = yMap.transform(yi.minValue() + (row+2)*dy);
+
+    return QRect(QPoint(static_cast<int>(floor(qMin(px1,px2)))-1,static_cast<int>(floor(qMin(py1,py2)))-1),
+                 QPoint(static_cast<int>(ceil(qMax(px1,px2)))+1,static_cast<int>(ceil(qMax(py1,py2)))+1));
+}
+
+bool LifSpectrogramItem::CacheKey::operator==(const CacheKey &other) const
+{
+    return xs1 == other.xs1 && xs2 == other.xs2 && xp1 == other.xp1 && xp2 == other.xp2
+            && ys1 == other.ys1 && ys2 == other.ys2 && yp1 == other.yp1 && yp2 == other.yp2
+            && area == other.area && size == other.size && z == other.z;
+}
@@ -0,0 +1,53 @@
+#ifndef LIFSPECTROGRAMITEM_H
+#define LIFSPECTROGRAMITEM_H
+
+#include <qwt6/qwt_plot_spectrogram.h>
+#include <qwt6/qwt_scale_map.h>
+#include <qwt6/qwt_interval.h>
+
+#include <QImage>
+#include <vector>
+
+class LifSpectrogramData;
+
+/*!
+ * \brief Spectrogram item that keeps its rendered image between replots
+ *
+ * QwtPlotSpectrogram renders every pixel of the raster each time the plot is replotted. This
+ * item keeps the last image, and as long as the scale maps, image size, and z range are
+ * unchanged it only re-renders the pixels influenced by the cells that LifSpectrogramData
+ * reports as dirty. Because of bilinear interpolation, that is the region spanned by the
+ * neighboring cell centers. Anything else (zooming, resizing, a new z range) renders the full
+ * image as before.
+ */
+class LifSpectrogramItem : public QwtPlotSpectrogram
+{
+public:
+    LifSpectrogramItem();
+
+    void setSpectrogramData(LifSpectrogramData *d);
+
+protected:
+    QImage renderImage(const QwtScaleMap &xMap, const QwtScaleMap &yMap, const QRectF &area, const QSize &imageSize) const override;
+
+private:
+    LifSpectrogramData *p_data{nullptr};
+
+    struct CacheKey {
+        double xs1{0.0}, xs2{0.0}, xp1{0.0}, xp2{0.0};
+        double ys1{0.0}, ys2{0.0}, yp1{0.0}, yp2{0.0};
+        QRectF area;
+        QSize size;
+        QwtInterval z;
+
+        bool operator==(const CacheKey &other) const;
+    };
+
+    mutable QImage d_cache;
+    mutable CacheKey d_cacheKey;
+    mutable std::vector<int> d_dirty;
+
+    QRect cellRect(int idx, const QwtScaleMap &xMap, const QwtScaleMap &yMap) const;
+};
+
+#endif // LIFSPECTROGRAMITEM_H
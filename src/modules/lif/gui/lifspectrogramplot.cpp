@@ -5,9 +5,9 @@
 #include <math.h>
 
 #include <modules/lif/hardware/liflaser/liflaser.h>
+#include <modules/lif/gui/lifspectrogramdata.h>
+#include <modules/lif/gui/lifspectrogramitem.h>
 
-#include <qwt6/qwt_plot_spectrogram.h>
-#include <qwt6/qwt_matrix_raster_data.h>
 #include <qwt6/qwt_color_map.h>
 #include <qwt6/qwt_scale_widget.h>
 #include <qwt6/qwt_plot_marker.h>
@@ -25,7 +25,7 @@ LifSpectrogramPlot::LifSpectrogramPlot(QWidget *parent) :
     setPlotAxisTitle(QwtPlot::xBottom,
                  QString("Laser Postiion (")+s.get<QString>(BC::Key::LifLaser::units,"nm")+QString(")"));
 
-    p_spectrogram = new QwtPlotSpectrogram();
+    p_spectrogram = new LifSpectrogramItem();
     p_spectrogram->setDisplayMode(QwtPlotSpectrogram::ImageMode);
     p_spectrogram->setDisplayMode(QwtPlotSpectrogram::ContourMode,false);
     p_spectrogram->setRenderHint(QwtPlotItem::RenderAntialiased);
@@ -72,7 +72,7 @@ void LifSpectrogramPlot::clear()
 {
     if(p_spectrogramData != nullptr)
     {
-        p_spectrogram->setData(nullptr);
+        p_spectrogram->setSpectrogramData(nullptr);
         p_spectrogramData = nullptr;
     }
 
@@ -104,8 +104,8 @@ void LifSpectrogramPlot::prepareForExperiment(const LifConfig &c)
 
     QVector<double> specDat;
     specDat.resize(c.d_delayPoints*c.d_laserPosPoints);
-    p_spectrogramData = new QwtMatrixRasterData;
-    p_spectrogramData->setValueMatrix(specDat,c.d_laserPosPoints);
+    p_spectrogramData = new LifSpectrogramData;
+    p_spectrogramData->setMatrix(specDat,c.d_laserPosPoints);
 
     auto delayRange = c.delayRange();
     auto laserRange = c.laserRange();
@@ -140,7 +140,7 @@ void LifSpectrogramPlot::prepareForExperiment(const LifConfig &c)
         p_laserMarker->setXValue(laserRange.first);
     }
 
-    p_spectrogram->setData(p_spectrogramData);
+    p_spectrogram->setSpectrogramData(p_spectrogramData);
     p_spectrogram->attach(this);
 
 
@@ -152,24 +152,43 @@ void LifSpectrogramPlot::updateData(const QVector<double> d, int numCols)
     if(d.size() < 2)
         return;
 
-    double zMin = 0.0, zMax = 0.0;
-    for(int i=0; i<d.size(); i++)
+    p_spectrogramData->setMatrix(d,numCols);
+    updateZRange();
+    replot();
+
+}
+
+void LifSpectrogramPlot::updatePoint(int di, int li, double value)
+{
+    //only the changed cell is written, and the color scale is rebuilt only if the range moved
+    if(!p_spectrogramData || p_spectrogramData->valueMatrix().size() < 2)
+        return;
+
+    if(p_spectrogramData->setCell(di,li,value))
+        updateZRange();
+
+    d_liveDelayIndex = di;
+    d_liveLaserIndex = li;
+    if(d_live)
     {
-        zMin = qMin(zMin,d.at(i));
-        zMax = qMax(zMax,d.at(i));
+        moveDelayCursor(di);
+        moveLaserCursor(li);
     }
-    p_spectrogramData->setInterval(Qt::ZAxis,QwtInterval(zMin,zMax));
+
+    replot();
+}
+
+void LifSpectrogramPlot::updateZRange()
+{
+    auto z = p_spectrogramData->zRange();
+    p_spectrogramData->setInterval(Qt::ZAxis,z);
 
     QwtLinearColorMap *map = new QwtLinearColorMap(QColor(0x02,0x28,0x51),QColor(0xff,0xdf,0x00));
 
     QwtScaleWidget *rightAxis = axisWidget( QwtPlot::yRight );
-    rightAxis->setColorMap(QwtInterval(zMin,zMax),map);
-
-    p_spectrogramData->setValueMatrix(d,numCols);
-    p_spectrogram->setData(p_spectrogramData);
-    overrideAxisAutoScaleRange(QwtPlot::yRight,zMin,zMax);
-    replot();
+    rightAxis->setColorMap(z,map);
 
+    overrideAxisAutoScaleRange(QwtPlot::yRight,z.minValue(),z.maxValue());
 }
 
 void LifSpectrogramPlot::setLiveIndices(int di, int li)
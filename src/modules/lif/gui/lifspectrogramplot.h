@@ -5,8 +5,8 @@
 
 #include <modules/lif/data/lifconfig.h>
 
-class QwtPlotSpectrogram;
-class QwtMatrixRasterData;
+class LifSpectrogramItem;
+class LifSpectrogramData;
 class QwtPlotMarker;
 class QMouseEvent;
 
@@ -24,6 +24,7 @@ public:
     void clear();
     void prepareForExperiment(const LifConfig &c);
     void updateData(const QVector<double> d, int numCols);
+    void updatePoint(int di, int li, double value);
     void setLiveIndices(int di, int li);
 
     void setZMax(double d);
@@ -52,8 +53,8 @@ signals:
     void delaySlice(int freqIndex);
 
 private:
-    QwtMatrixRasterData *p_spectrogramData;
-    QwtPlotSpectrogram *p_spectrogram;
+    LifSpectrogramData *p_spectrogramData;
+    LifSpectrogramItem *p_spectrogram;
     QwtPlotMarker *p_delayMarker, *p_laserMarker;
     bool d_enabled, d_live{true};
     bool d_delayDragging, d_freqDragging, d_grabDelay, d_grabFreq;
@@ -61,6 +62,7 @@ private:
 
     double d_dMin, d_ddx, d_lMin, d_ldx;
 
+    void updateZRange();
 
     // ZoomPanPlot interface
 protected:
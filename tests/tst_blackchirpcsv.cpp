@@ -1,6 +1,8 @@
 #include <QtTest>
 
 #include <src/data/storage/blackchirpcsv.h>
+#include <src/data/storage/fidbinaryfile.h>
+#include <src/data/storage/fidindexfile.h>
 
 class BlackchirpCSVTest : public QObject
 {
@@ -19,8 +21,41 @@ private slots:
     void testExportY();
     void testExportYMulitple();
     void testFidConversion();
+    void testBinaryFid_data();
+    void testBinaryFid();
+    void testFidIndex();
+    void benchmarkFidFormats_data();
+    void benchmarkFidFormats();
+
+private:
+    FidList makeFidList(int numFids, int size);
 };
 
+FidList BlackchirpCSVTest::makeFidList(int numFids, int size)
+{
+    //sum of a few damped sinusoids plus noise, scaled as if 1000 shots were summed
+    Fid tmpl;
+    tmpl.setShots(1000);
+    tmpl.setSpacing(2e-11);
+
+    FidList out;
+    for(int i=0; i<numFids; ++i)
+    {
+        QVector<qint64> d(size);
+        for(int j=0; j<size; ++j)
+        {
+            double t = j*2e-11;
+            double v = 40.0*exp(-t/2e-6)*sin(2*M_PI*3.1e9*t) + 25.0*exp(-t/1e-6)*sin(2*M_PI*7.7e9*t + i);
+            d[j] = static_cast<qint64>(1000.0*v) + QRandomGenerator::global()->bounded(-500,500);
+        }
+        Fid f = tmpl;
+        f.setData(d);
+        out << f;
+    }
+
+    return out;
+}
+
 void BlackchirpCSVTest::initTestCase()
 {
 
@@ -210,6 +245,197 @@ void BlackchirpCSVTest::testFidConversion()
 
 }
 
+void BlackchirpCSVTest::testBinaryFid_data()
+{
+    QTest::addColumn<int>("level");
+
+    QTest::newRow("raw") << 0;
+    QTest::newRow("compressed") << 1;
+}
+
+void BlackchirpCSVTest::testBinaryFid()
+{
+    QFETCH(int,level);
+
+    Fid tmpl;
+    tmpl.setShots(123);
+    tmpl.setSpacing(2e-11);
+
+    FidList l;
+    for(int i=0; i<3; ++i)
+    {
+        QVector<qint64> d(1000 + 37*i);
+        for(int j=0; j<d.size(); ++j)
+            d[j] = (static_cast<qint64>(j)*(i+1)*0x1234567) * (j%2 ? -1 : 1);
+
+        Fid f = tmpl;
+        f.setData(d);
+        l << f;
+    }
+
+    QTemporaryFile f;
+    QVERIFY(f.open());
+    QVERIFY(FidBinaryFile::write(f,l,true,level));
+    f.close();
+
+    QString err;
+    auto out = FidBinaryFile::read(f,tmpl,true,&err);
+    QCOMPARE(err,QString(""));
+    QCOMPARE(out.size(),l.size());
+    for(int i=0; i<l.size(); ++i)
+    {
+        QCOMPARE(out.at(i).shots(),tmpl.shots());
+        QCOMPARE(out.at(i).size(),l.constLast().size());
+        QCOMPARE(out.at(i).rawData().mid(0,l.at(i).size()),l.at(i).rawData());
+        for(int j=l.at(i).size(); j<out.at(i).size(); ++j)
+            QCOMPARE(out.at(i).valueRaw(j),Q_INT64_C(0));
+    }
+    f.close();
+
+    //flip a bit in the data and make sure the checksum (or the decoder) catches it
+    QVERIFY(f.open());
+    auto pos = level > 0 ? f.size() - 5 : FidBinaryFile::headerSize + 8*500 + 3;
+    f.seek(pos);
+    char c = 0;
+    f.getChar(&c);
+    f.seek(pos);
+    f.putChar(c ^ 0x10);
+    f.close();
+
+    QVERIFY(FidBinaryFile::read(f,tmpl,true,&err).isEmpty());
+    QVERIFY(!err.isEmpty());
+    f.close();
+    if(level == 0)
+        QCOMPARE(FidBinaryFile::read(f,tmpl,false).size(),l.size());
+}
+
+void BlackchirpCSVTest::testFidIndex()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    auto path = dir.filePath(BC::CSV::fidIndex);
+
+    //records may be written in any order; gaps are reported as missing
+    QVector<int> order{3,0,5};
+    for(auto i : order)
+    {
+        FidIndexFile::Record r;
+        r.fidTemplate.setSpacing(2e-11);
+        r.fidTemplate.setProbeFreq(40960.0 + 250.0*i);
+        r.fidTemplate.setVMult(0.0009765625);
+        r.fidTemplate.setShots(100 + i);
+        r.fidTemplate.setSideband(RfConfig::LowerSideband);
+        r.size = 500000 + i;
+        r.binary = i != 0;
+        QVERIFY(FidIndexFile::writeRecord(path,i,r));
+    }
+
+    QCOMPARE(FidIndexFile::count(path),6);
+    for(int i=0; i<6; ++i)
+    {
+        FidIndexFile::Record r;
+        bool ok = FidIndexFile::readRecord(path,i,r);
+        QCOMPARE(ok,order.contains(i));
+        if(!ok)
+            continue;
+
+        QCOMPARE(r.fidTemplate.spacing(),2e-11);
+        QCOMPARE(r.fidTemplate.probeFreq(),40960.0 + 250.0*i);
+        QCOMPARE(r.fidTemplate.shots(),static_cast<quint64>(100 + i));
+        QCOMPARE(r.fidTemplate.sideband(),RfConfig::LowerSideband);
+        QCOMPARE(r.size,500000 + i);
+        QCOMPARE(r.fileName(i),i == 0 ? QString("0.csv") : QString("%1.%2").arg(i).arg(BC::CSV::fidBinExt));
+    }
+    FidIndexFile::Record r;
+    QVERIFY(!FidIndexFile::readRecord(path,6,r));
+
+    //overwriting a record touches only that record
+    QVERIFY(FidIndexFile::readRecord(path,3,r));
+    r.fidTemplate.setShots(1000);
+    QVERIFY(FidIndexFile::writeRecord(path,3,r));
+    QVERIFY(FidIndexFile::readRecord(path,3,r));
+    QCOMPARE(r.fidTemplate.shots(),Q_UINT64_C(1000));
+    QVERIFY(FidIndexFile::readRecord(path,5,r));
+    QCOMPARE(r.fidTemplate.shots(),Q_UINT64_C(105));
+}
+
+void BlackchirpCSVTest::benchmarkFidFormats_data()
+{
+    QTest::addColumn<int>("format");
+
+    QTest::newRow("csv") << 0;
+    QTest::newRow("binary") << 1;
+    QTest::newRow("compressed") << 2;
+}
+
+void BlackchirpCSVTest::benchmarkFidFormats()
+{
+    QFETCH(int,format);
+
+    int numFids = 4, size = 750000;
+    auto l = makeFidList(numFids,size);
+    double mb = numFids*size*sizeof(qint64)/1e6;
+
+    QByteArray csv;
+    QBuffer cb(&csv);
+    cb.open(QIODevice::WriteOnly|QIODevice::Text);
+    BlackchirpCSV::writeFidList(cb,l);
+    cb.close();
+
+    QTemporaryFile f;
+    QElapsedTimer timer;
+    qint64 writeNs = 0, readNs = 0, bytes = 0;
+    QBENCHMARK {
+        QVERIFY(f.open());
+        f.resize(0);
+        timer.start();
+        if(format == 0)
+            BlackchirpCSV::writeFidList(f,l);
+        else
+            QVERIFY(FidBinaryFile::write(f,l,true,format == 2 ? 1 : 0));
+        f.flush();
+        writeNs = timer.nsecsElapsed();
+        bytes = f.size();
+        f.close();
+
+        timer.start();
+        FidList out;
+        if(format == 0)
+        {
+            //equivalent to FidStorageBase::loadFidList
+            QVERIFY(f.open());
+            BlackchirpCSV csvReader;
+            csvReader.readLine(f);
+            QVector<QVector<qint64>> data(numFids);
+            while(!f.atEnd())
+            {
+                auto sl = csvReader.readFidLine(f);
+                for(int j=0; j<sl.size() && j<numFids; ++j)
+                    data[j].append(sl.at(j));
+            }
+            f.close();
+            for(auto &d : data)
+            {
+                out << l.constFirst();
+                out.last().setData(d);
+            }
+        }
+        else
+        {
+            out = FidBinaryFile::read(f,l.constFirst());
+            f.close();
+        }
+        readNs = timer.nsecsElapsed();
+        QCOMPARE(out.size(),numFids);
+        QCOMPARE(out.constLast().rawData(),l.constLast().rawData());
+    }
+
+    QTextStream(stdout) << QString("\n%1: %2 MB on disk (%3x smaller than CSV), write %4 MB/s, read %5 MB/s\n")
+                           .arg(QTest::currentDataTag()).arg(bytes/1e6,0,'f',2)
+                           .arg(static_cast<double>(csv.size())/bytes,0,'f',2)
+                           .arg(mb/(writeNs/1e9),0,'f',1).arg(mb/(readNs/1e9),0,'f',1);
+}
+
 QTEST_MAIN(BlackchirpCSVTest)
 
 #include "tst_blackchirpcsv.moc"
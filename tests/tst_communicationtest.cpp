@@ -0,0 +1,168 @@
+#include <QtTest>
+
+#include <src/hardware/core/communication/virtualinstrument.h>
+#include <src/hardware/core/communication/blockdataparser.h>
+
+//answers queries itself, like protocols that have no QIODevice
+class CustomProtocol : public VirtualInstrument
+{
+public:
+    CustomProtocol() : VirtualInstrument("custom") {}
+    QByteArray queryCmd(QString cmd, bool suppressError = false) override {
+        Q_UNUSED(suppressError)
+        return QByteArray("r") + cmd.trimmed().toLatin1();
+    }
+};
+
+class CommunicationTest : public QObject
+{
+    Q_OBJECT
+public:
+    CommunicationTest() {};
+    ~CommunicationTest() {};
+
+private slots:
+    void testQueryBatch();
+    void testBatchWithoutTerminator();
+    void testBatchWithoutDevice();
+    void testBlockDataParser();
+    void benchmarkChannelReadback_data();
+    void benchmarkChannelReadback();
+
+private:
+    QStringList makeQueries(int n) const;
+};
+
+QStringList CommunicationTest::makeQueries(int n) const
+{
+    QStringList out;
+    for(int i=0; i<n; ++i)
+        out << QString(":PULSE%1:WIDTH?\n").arg(i+1);
+    return out;
+}
+
+void CommunicationTest::testQueryBatch()
+{
+    VirtualInstrument v("test");
+    v.simulateLatency(2,"\n",[](const QByteArray &msg){ return QByteArray("r") + msg; });
+    v.setMaxBatchSize(8);
+
+    auto cmds = makeQueries(20);
+
+    //one exchange per query
+    auto rt = v.roundTrips();
+    QList<QByteArray> seq;
+    for(auto &c : cmds)
+        seq << v.queryCmd(c);
+    QCOMPARE(v.roundTrips()-rt,20ull);
+
+    //one exchange per batch of 8, with the responses in order
+    rt = v.roundTrips();
+    auto batch = v.queryBatch(cmds);
+    QCOMPARE(v.roundTrips()-rt,3ull);
+    QCOMPARE(batch.size(),cmds.size());
+    QCOMPARE(batch,seq);
+    for(int i=0; i<cmds.size(); ++i)
+        QCOMPARE(batch.at(i),QByteArray("r") + cmds.at(i).trimmed().toLatin1());
+}
+
+void CommunicationTest::testBatchWithoutTerminator()
+{
+    VirtualInstrument v("test");
+    v.simulateLatency(0);
+
+    //responses cannot be split without a terminator, so each query is sent by itself
+    v.setReadOptions(100,false);
+    auto cmds = makeQueries(4);
+    auto rt = v.roundTrips();
+    auto r = v.queryBatch(cmds);
+    QCOMPARE(r.size(),4);
+    QCOMPARE(v.roundTrips()-rt,4ull);
+}
+
+void CommunicationTest::testBatchWithoutDevice()
+{
+    CustomProtocol p;
+    auto cmds = makeQueries(5);
+    auto r = p.queryBatch(cmds);
+    QCOMPARE(r.size(),cmds.size());
+    for(int i=0; i<cmds.size(); ++i)
+        QCOMPARE(r.at(i),QByteArray("r") + cmds.at(i).trimmed().toLatin1());
+}
+
+void CommunicationTest::testBlockDataParser()
+{
+    QByteArray wfm(1000,Qt::Uninitialized);
+    for(int i=0; i<wfm.size(); ++i)
+        wfm[i] = static_cast<char>(i%251);
+
+    //junk, a block with the wrong length, then two good blocks
+    QByteArray stream("junk\n#3999");
+    stream.append(wfm.left(999)).append("\n");
+    for(int i=0; i<2; ++i)
+        stream.append("#41000").append(wfm).append("\n");
+
+    QByteArray data;
+    QBuffer buf(&data);
+    buf.open(QIODevice::ReadWrite);
+
+    BlockDataParser p(wfm.size());
+    int allocs = 0;
+    auto alloc = [&allocs](int n){ allocs++; return QByteArray(n,Qt::Uninitialized); };
+
+    //feed the stream in small pieces as if it were arriving from a socket
+    QList<QByteArray> blocks;
+    QByteArray out;
+    for(int pos = 0; pos < stream.size(); pos += 37)
+    {
+        auto rpos = buf.pos();
+        buf.seek(data.size());
+        buf.write(stream.mid(pos,37));
+        buf.seek(rpos);
+        while(p.read(&buf,out,alloc))
+            blocks.append(out);
+    }
+
+    QCOMPARE(blocks.size(),2);
+    QCOMPARE(blocks.at(0),wfm);
+    QCOMPARE(blocks.at(1),wfm);
+    QCOMPARE(allocs,2);
+    QVERIFY(p.resyncs() >= 1);
+    QVERIFY(!p.inBlock());
+    QVERIFY(buf.atEnd());
+}
+
+void CommunicationTest::benchmarkChannelReadback_data()
+{
+    QTest::addColumn<bool>("batched");
+
+    QTest::newRow("sequential") << false;
+    QTest::newRow("batched") << true;
+}
+
+void CommunicationTest::benchmarkChannelReadback()
+{
+    QFETCH(bool,batched);
+
+    //8 queries, as when reading back one pulse generator channel, over a 2 ms link
+    VirtualInstrument v("test");
+    v.simulateLatency(2);
+    auto cmds = makeQueries(8);
+
+    QList<QByteArray> r;
+    QBENCHMARK {
+        if(batched)
+            r = v.queryBatch(cmds);
+        else
+        {
+            r.clear();
+            for(auto &c : cmds)
+                r << v.queryCmd(c);
+        }
+    }
+    QCOMPARE(r.size(),8);
+}
+
+QTEST_MAIN(CommunicationTest)
+
+#include "tst_communicationtest.moc"
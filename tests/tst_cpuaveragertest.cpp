@@ -0,0 +1,406 @@
+#include <QtTest>
+#include <QtEndian>
+
+#include <src/data/analysis/cpuaverager.h>
+#include <src/data/analysis/analysis.h>
+#include <src/data/storage/fidsinglestorage.h>
+
+class CpuAveragerTest : public QObject
+{
+    Q_OBJECT
+public:
+    CpuAveragerTest() {};
+    ~CpuAveragerTest() {};
+
+private slots:
+    void testParseAndAdd_data();
+    void testParseAndAdd();
+    void testParseAndRollAvg_data();
+    void testParseAndRollAvg();
+    void testBusyPool();
+    void testAddFidsInPlace();
+    void benchmarkParseAndAdd_data();
+    void benchmarkParseAndAdd();
+    void testFidArena();
+    void benchmarkShotDecode_data();
+    void benchmarkShotDecode();
+
+private:
+    QByteArray makeShot(int numRecords, int recordLength, int bpp);
+    FidList referenceParse(const QByteArray b, int numRecords, int recordLength, int bpp, bool bigEndian, quint64 inc, quint8 bitShift);
+    void addBackendRows();
+};
+
+QByteArray CpuAveragerTest::makeShot(int numRecords, int recordLength, int bpp)
+{
+    QByteArray out(numRecords*recordLength*bpp,'\0');
+    for(int i=0; i<out.size(); ++i)
+        out[i] = static_cast<char>(QRandomGenerator::global()->bounded(256));
+
+    return out;
+}
+
+FidList CpuAveragerTest::referenceParse(const QByteArray b, int numRecords, int recordLength, int bpp, bool bigEndian, quint64 inc, quint8 bitShift)
+{
+    //straightforward decode, equivalent to FtmwConfig::parseWaveform
+    FidList out;
+    for(int j=0; j<numRecords; ++j)
+    {
+        QVector<qint64> d(recordLength);
+        for(int i=0; i<recordLength; ++i)
+        {
+            qint64 dat = 0;
+            auto idx = bpp*(j*recordLength+i);
+            if(bpp == 1)
+                dat = static_cast<qint8>(b.at(idx));
+            else if(bpp == 2)
+            {
+                quint16 y = 0;
+                for(int k=0; k<2; ++k)
+                    y |= static_cast<quint16>(static_cast<quint8>(b.at(idx+(bigEndian ? 1-k : k)))) << (8*k);
+                dat = static_cast<qint16>(y);
+            }
+            else
+            {
+                quint32 y = 0;
+                for(int k=0; k<4; ++k)
+                    y |= static_cast<quint32>(static_cast<quint8>(b.at(idx+(bigEndian ? 3-k : k)))) << (8*k);
+                dat = static_cast<qint32>(y);
+            }
+            d[i] = (dat*static_cast<qint64>(inc)) << bitShift;
+        }
+
+        Fid f;
+        f.setData(d);
+        f.setShots(inc);
+        out.append(f);
+    }
+
+    return out;
+}
+
+void CpuAveragerTest::addBackendRows()
+{
+    QList<CpuAverager::Backend> backends{CpuAverager::Scalar, CpuAverager::SSE41, CpuAverager::AVX2};
+    for(auto b : backends)
+    {
+        if(!CpuAverager::isAvailable(b))
+            continue;
+
+        for(int bpp : {1,2,4})
+        {
+            for(bool be : {false,true})
+            {
+                if(bpp == 1 && be)
+                    continue;
+
+                auto name = QString("%1 %2 byte %3").arg(CpuAverager::backendName(b)).arg(bpp).arg(be ? "BE" : "LE");
+                QTest::newRow(name.toLatin1().constData()) << static_cast<int>(b) << bpp << be;
+            }
+        }
+    }
+}
+
+void CpuAveragerTest::testParseAndAdd_data()
+{
+    QTest::addColumn<int>("backend");
+    QTest::addColumn<int>("bpp");
+    QTest::addColumn<bool>("bigEndian");
+
+    addBackendRows();
+}
+
+void CpuAveragerTest::testParseAndAdd()
+{
+    QFETCH(int,backend);
+    QFETCH(int,bpp);
+    QFETCH(bool,bigEndian);
+
+    int nr = 3, rl = 1037;
+    quint64 inc = 20;
+    QList<int> shifts{0,3,-2,0,5,-7};
+
+    CpuAverager avg;
+    QVERIFY(avg.initialize(nr,rl,bpp,bigEndian,inc,0,static_cast<CpuAverager::Backend>(backend)));
+    QCOMPARE(static_cast<int>(avg.backend()),backend);
+
+    //force several chunks per record so that the pool is used
+    avg.setChunkPoints(128);
+
+    FidList sum, ref;
+    for(auto shift : shifts)
+    {
+        auto shot = makeShot(nr,rl,bpp);
+        QVERIFY(avg.parseAndAdd(shot.constData(),shot.size(),sum,Fid(),shift));
+
+        auto l = referenceParse(shot,nr,rl,bpp,bigEndian,inc,0);
+        if(ref.isEmpty())
+            ref = l;
+        else
+        {
+            for(int i=0; i<ref.size(); ++i)
+                ref[i].add(l.at(i),shift);
+        }
+    }
+
+    QCOMPARE(sum.size(),ref.size());
+    for(int i=0; i<ref.size(); ++i)
+    {
+        QCOMPARE(sum.at(i).shots(),ref.at(i).shots());
+        QCOMPARE(sum.at(i).rawData(),ref.at(i).rawData());
+    }
+
+    //short buffers must be rejected
+    auto shot = makeShot(nr,rl,bpp);
+    QCOMPARE(avg.parseAndAdd(shot.constData(),shot.size()-1,sum,Fid()),false);
+}
+
+void CpuAveragerTest::testParseAndRollAvg_data()
+{
+    QTest::addColumn<int>("backend");
+    QTest::addColumn<int>("bpp");
+    QTest::addColumn<bool>("bigEndian");
+
+    addBackendRows();
+}
+
+void CpuAveragerTest::testParseAndRollAvg()
+{
+    QFETCH(int,backend);
+    QFETCH(int,bpp);
+    QFETCH(bool,bigEndian);
+
+    int nr = 2, rl = 515;
+    quint64 inc = 1, target = 5;
+    quint8 bitShift = 8;
+
+    CpuAverager avg;
+    QVERIFY(avg.initialize(nr,rl,bpp,bigEndian,inc,bitShift,static_cast<CpuAverager::Backend>(backend)));
+    avg.setChunkPoints(100);
+
+    FidList sum, ref;
+    for(int n=0; n<12; ++n)
+    {
+        int shift = (n%3)-1;
+        auto shot = makeShot(nr,rl,bpp);
+        QVERIFY(avg.parseAndRollAvg(shot.constData(),shot.size(),sum,Fid(),target,shift));
+
+        auto l = referenceParse(shot,nr,rl,bpp,bigEndian,inc,bitShift);
+        if(ref.isEmpty())
+            ref = l;
+        else
+        {
+            for(int i=0; i<ref.size(); ++i)
+                ref[i].rollingAverage(l.at(i),target,shift);
+        }
+    }
+
+    for(int i=0; i<ref.size(); ++i)
+    {
+        QCOMPARE(sum.at(i).shots(),target);
+        QCOMPARE(sum.at(i).rawData(),ref.at(i).rawData());
+    }
+}
+
+void CpuAveragerTest::testBusyPool()
+{
+    int nr = 2, rl = 4096;
+    CpuAverager avg;
+    QVERIFY(avg.initialize(nr,rl,1,false,1,0));
+    avg.setChunkPoints(128);
+
+    //every pool thread waits on a lock held by the caller, as when a storage
+    //object is locked while a shot is added
+    auto pool = Analysis::workerPool();
+    int threads = pool->maxThreadCount();
+    QMutex m;
+    QSemaphore blocked;
+    m.lock();
+    for(int i=0; i<threads; ++i)
+        pool->start([&m,&blocked](){ blocked.release(); QMutexLocker l(&m); });
+    blocked.acquire(threads);
+
+    FidList sum;
+    auto shot = makeShot(nr,rl,1);
+    QVERIFY(avg.parseAndAdd(shot.constData(),shot.size(),sum,Fid()));
+    m.unlock();
+    pool->waitForDone();
+
+    auto ref = referenceParse(shot,nr,rl,1,false,1,0);
+    QCOMPARE(sum.size(),ref.size());
+    for(int i=0; i<ref.size(); ++i)
+        QCOMPARE(sum.at(i).rawData(),ref.at(i).rawData());
+}
+
+void CpuAveragerTest::testAddFidsInPlace()
+{
+    int nr = 4, rl = 10000;
+    FidSingleStorage st(nr,-1);
+
+    FidList shot;
+    for(int i=0; i<nr; ++i)
+    {
+        Fid f;
+        f.setData(QVector<qint64>(rl,1));
+        f.setShots(1);
+        shot.append(f);
+    }
+
+    //the first add stores the shot itself; the second detaches the sum from it once
+    QVERIFY(st.addFids(shot));
+    QVERIFY(st.addFids(shot));
+
+    QVector<const qint64*> addr;
+    {
+        auto l = st.getCurrentFidList();
+        for(auto &f : l)
+            addr << f.rawSpan().data();
+    }
+
+    CpuAverager avg;
+    QVERIFY(avg.initialize(nr,rl,1,false,1,0));
+    QByteArray raw(nr*rl,'\1');
+
+    //later adds merge into the stored records without copying them
+    auto before = Analysis::payloadCopies();
+    for(int i=0; i<5; ++i)
+    {
+        QVERIFY(st.addFids(shot));
+        QVERIFY(st.addFids(raw,avg,Fid()));
+    }
+    QCOMPARE(Analysis::payloadCopies(),before);
+
+    auto l = st.getCurrentFidList();
+    QCOMPARE(l.size(),nr);
+    for(int i=0; i<nr; ++i)
+    {
+        QCOMPARE(l.at(i).rawSpan().data(),addr.at(i));
+        QCOMPARE(l.at(i).shots(),Q_UINT64_C(12));
+        QCOMPARE(l.at(i).atRaw(rl-1),Q_INT64_C(12));
+    }
+    QCOMPARE(st.currentSegmentShots(),Q_UINT64_C(12));
+
+    //a mismatched shot is rejected and leaves the sum intact
+    QVERIFY(!st.addFids(shot.mid(0,nr-1)));
+    QCOMPARE(st.getCurrentFidList().constFirst().rawSpan().data(),addr.constFirst());
+}
+
+void CpuAveragerTest::benchmarkParseAndAdd_data()
+{
+    QTest::addColumn<int>("backend");
+    QTest::addColumn<int>("bpp");
+    QTest::addColumn<bool>("bigEndian");
+
+    addBackendRows();
+}
+
+void CpuAveragerTest::benchmarkParseAndAdd()
+{
+    QFETCH(int,backend);
+    QFETCH(int,bpp);
+    QFETCH(bool,bigEndian);
+
+    int nr = 1, rl = 750000;
+    CpuAverager avg;
+    QVERIFY(avg.initialize(nr,rl,bpp,bigEndian,1,0,static_cast<CpuAverager::Backend>(backend)));
+
+    auto shot = makeShot(nr,rl,bpp);
+    FidList sum;
+    avg.parseAndAdd(shot.constData(),shot.size(),sum,Fid());
+
+    QBENCHMARK {
+        avg.parseAndAdd(shot.constData(),shot.size(),sum,Fid(),1);
+    }
+}
+
+void CpuAveragerTest::testFidArena()
+{
+    int nr = 4, rl = 1000;
+    Fid t;
+    t.setProbeFreq(11000.0);
+    t.setSpacing(2e-11);
+
+    FidArena a;
+    auto l = a.next(t,nr,rl);
+    QCOMPARE(l.size(),nr);
+    QCOMPARE(l.constFirst().size(),rl);
+    QCOMPARE(l.constFirst().probeFreq(),11000.0);
+    QCOMPARE(a.allocations(),static_cast<quint64>(nr));
+
+    //released buffers are reused
+    l.clear();
+    for(int i=0; i<10; ++i)
+    {
+        auto &n = a.next(t,nr,rl);
+        n[0].rawDataPtr()[0] = i;
+    }
+    QCOMPARE(a.allocations(),static_cast<quint64>(nr));
+
+    //a record that is still held elsewhere is replaced rather than overwritten
+    auto held = a.next(t,nr,rl).constFirst();
+    auto v = held.atRaw(0);
+    a.next(t,nr,rl)[0].rawDataPtr()[0] = v+1;
+    QCOMPARE(held.atRaw(0),v);
+    QCOMPARE(a.allocations(),static_cast<quint64>(nr+1));
+}
+
+void CpuAveragerTest::benchmarkShotDecode_data()
+{
+    QTest::addColumn<bool>("useArena");
+
+    QTest::newRow("new FidList") << false;
+    QTest::newRow("arena") << true;
+}
+
+void CpuAveragerTest::benchmarkShotDecode()
+{
+    QFETCH(bool,useArena);
+
+    //FastFrame-like shot: many short records, decoded and summed one shot at a time.
+    //Both rows use the same decoder as FtmwConfig::parseWaveform, so only the buffer handling differs
+    int nr = 100, rl = 2000, bpp = 2;
+    auto shot = makeShot(nr,rl,bpp);
+    FidArena arena;
+    Fid t;
+    FidList sum = referenceParse(shot,nr,rl,bpp,false,1,0);
+
+    auto decode = [&](Fid &f, int j){
+        auto p = reinterpret_cast<const uchar*>(shot.constData()) + static_cast<qint64>(j)*rl*bpp;
+        auto d = f.rawDataPtr();
+        for(int i=0; i<rl; ++i)
+            d[i] = static_cast<qint64>(qFromLittleEndian<qint16>(p+2*i));
+        f.setShots(1);
+    };
+
+    QBENCHMARK {
+        if(useArena)
+        {
+            auto &l = arena.next(t,nr,rl);
+            for(int j=0; j<nr; ++j)
+                decode(l[j],j);
+            for(int j=0; j<nr; ++j)
+                sum[j] += l.at(j);
+        }
+        else
+        {
+            //as parseWaveform did before the arena: a new buffer for every record of every shot
+            FidList l;
+            for(int j=0; j<nr; ++j)
+            {
+                Fid f = t;
+                f.setData(QVector<qint64>(rl));
+                decode(f,j);
+                l.append(f);
+            }
+            for(int j=0; j<nr; ++j)
+                sum[j] += l.at(j);
+        }
+    }
+
+    if(useArena)
+        QCOMPARE(arena.allocations(),static_cast<quint64>(nr));
+}
+
+QTEST_MAIN(CpuAveragerTest)
+
+#include "tst_cpuaveragertest.moc"
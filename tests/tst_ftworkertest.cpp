@@ -0,0 +1,275 @@
+#include <QtTest>
+
+#include <src/data/analysis/ftworker.h>
+#include <src/data/analysis/analysis.h>
+
+class FtWorkerTest : public QObject
+{
+    Q_OBJECT
+public:
+    FtWorkerTest() {};
+    ~FtWorkerTest() {};
+
+private slots:
+    void testFilterFid();
+    void testSpectrumPeak_data();
+    void testSpectrumPeak();
+    void testCachedFT();
+    void testSidebands();
+    void testNoPayloadCopies();
+    void benchmarkDoFT_data();
+    void benchmarkDoFT();
+    void benchmarkCachedFT_data();
+    void benchmarkCachedFT();
+
+private:
+    Fid makeFid(int size, double freqMHz, RfConfig::Sideband sb = RfConfig::UpperSideband);
+    FtWorker::FidProcessingSettings defaultSettings() const;
+};
+
+Fid FtWorkerTest::makeFid(int size, double freqMHz, RfConfig::Sideband sb)
+{
+    //damped sinusoid with a DC offset and noise, summed over 100 shots
+    Fid out;
+    out.setShots(100);
+    out.setSpacing(2e-11);
+    out.setVMult(1e-3);
+    out.setProbeFreq(10000.0);
+    out.setSideband(sb);
+
+    QVector<qint64> d(size);
+    for(int i=0; i<size; ++i)
+    {
+        double t = i*2e-11;
+        double v = 200.0 + 1000.0*exp(-t/5e-6)*sin(2*M_PI*freqMHz*1e6*t);
+        d[i] = static_cast<qint64>(100.0*v) + QRandomGenerator::global()->bounded(-50,50);
+    }
+    out.setData(d);
+
+    return out;
+}
+
+FtWorker::FidProcessingSettings FtWorkerTest::defaultSettings() const
+{
+    return { 0.0, 0.0, 0, true, FtWorker::FtmV, 0.0, FtWorker::None, FftBackend::Gsl };
+}
+
+void FtWorkerTest::testFilterFid()
+{
+    FtWorker w;
+    auto fid = makeFid(10000,1234.0);
+    auto s = defaultSettings();
+    s.startUs = 0.02;
+    s.endUs = 0.15;
+
+    auto r = w.filterFid(fid,s);
+    QCOMPARE(r.fid.size(),fid.size());
+
+    //reference: truncate, then remove the mean of the retained points
+    auto ref = fid.toVector();
+    int si = static_cast<int>(floor(s.startUs*1e-6/fid.spacing()));
+    int ei = static_cast<int>(ceil(s.endUs*1e-6/fid.spacing()));
+    double avg = 0.0;
+    for(int i=si; i<=ei; ++i)
+        avg += ref.at(i);
+    avg /= static_cast<double>(ei-si+1);
+
+    for(int i=0; i<ref.size(); ++i)
+    {
+        double expected = (i >= si && i <= ei) ? ref.at(i) - avg : 0.0;
+        QVERIFY(qAbs(r.fid.at(i) - expected) < 1e-9);
+    }
+    QVERIFY(r.min < 0.0);
+    QVERIFY(r.max > 0.0);
+
+    //zero padding rounds up to a power of 2
+    s.zeroPadFactor = 1;
+    QCOMPARE(w.filterFid(fid,s).fid.size(),32768);
+}
+
+void FtWorkerTest::testSpectrumPeak_data()
+{
+    QTest::addColumn<int>("sideband");
+    QTest::addColumn<bool>("dsb");
+
+    QTest::newRow("upper") << static_cast<int>(RfConfig::UpperSideband) << false;
+    QTest::newRow("lower") << static_cast<int>(RfConfig::LowerSideband) << false;
+    QTest::newRow("double") << static_cast<int>(RfConfig::UpperSideband) << true;
+}
+
+void FtWorkerTest::testSpectrumPeak()
+{
+    QFETCH(int,sideband);
+    QFETCH(bool,dsb);
+
+    FtWorker w;
+    auto sb = static_cast<RfConfig::Sideband>(sideband);
+    auto fid = makeFid(65536,2500.0,sb);
+    auto s = defaultSettings();
+    s.windowFunction = FtWorker::Hanning;
+
+    auto ft = w.doFT(fid,s,-1,dsb);
+    QCOMPARE(ft.size(),dsb ? 65536 : 32769);
+
+    int maxIdx = 0;
+    for(int i=1; i<ft.size(); ++i)
+    {
+        if(ft.at(i) > ft.at(maxIdx))
+            maxIdx = i;
+    }
+
+    //peak is 2500 MHz away from the LO, on the appropriate side unless both are shown
+    double offset = ft.xAt(maxIdx) - fid.probeFreq();
+    QVERIFY(qAbs(qAbs(offset) - 2500.0) < 2.0*ft.xSpacing());
+    if(!dsb)
+        QCOMPARE(offset > 0.0, sb == RfConfig::UpperSideband);
+    QCOMPARE(ft.yMax(),ft.at(maxIdx));
+    QCOMPARE(ft.yMin(),0.0);
+}
+
+void FtWorkerTest::testCachedFT()
+{
+    FtWorker w;
+    auto s = defaultSettings();
+    s.windowFunction = FtWorker::Hanning;
+    s.zeroPadFactor = 1;
+
+    auto batch = makeFid(20000,1234.0);
+    auto fid = batch;
+    for(int i=0; i<5; ++i)
+    {
+        if(i == 3)
+        {
+            //a settings change must not reuse the cached spectrum
+            s.startUs = 0.05;
+            s.units = FtWorker::FtuV;
+        }
+
+        auto c = w.cachedFT(fid,s,0);
+        auto full = w.doFT(fid,s);
+        QCOMPARE(c.size(),full.size());
+        QCOMPARE(c.yData(),full.yData());
+        QCOMPARE(c.yMax(),full.yMax());
+
+        //unchanged input reuses the previous spectrum
+        auto again = w.cachedFT(fid,s,0);
+        QCOMPARE(again.yData().constData(),c.yData().constData());
+
+        fid.add(batch,0);
+    }
+}
+
+void FtWorkerTest::testSidebands()
+{
+    FtWorker w;
+    auto s = defaultSettings();
+    FtWorker::SidebandProcessingData d;
+    d.totalFids = 8;
+    d.minOffset = 0.0;
+    d.maxOffset = 1e9;
+    auto fid = makeFid(4096,2500.0);
+    auto ref = w.doFT(fid,s);
+
+    //identical segments merge to the same spectrum
+    auto ft = w.processSidebands(d,s,[fid](int){ return fid; });
+    QCOMPARE(ft.size(),ref.size());
+    QCOMPARE(ft.shots(),fid.shots()*8);
+    for(int i=1; i<ref.size(); ++i)
+        QVERIFY(qAbs(ft.at(i) - ref.at(i)) <= 1e-9*ref.yMax());
+
+    //stepping the LO extends the merged range
+    ft = w.processSidebands(d,s,[fid](int i){
+        auto f = fid;
+        f.setProbeFreq(fid.probeFreq() + 1000.0*i);
+        return f;
+    });
+    QVERIFY(qAbs(ft.minFreqMHz() - ref.minFreqMHz()) < ref.xSpacing());
+    QVERIFY(qAbs(ft.maxFreqMHz() - (ref.maxFreqMHz() + 7000.0)) < ref.xSpacing());
+
+    //a cancelled request produces nothing
+    d.cancel = std::make_shared<std::atomic<bool>>(true);
+    QVERIFY(w.processSidebands(d,s,[fid](int){ return fid; }).isEmpty());
+}
+
+void FtWorkerTest::testNoPayloadCopies()
+{
+    FtWorker w;
+    auto fid = makeFid(65536,2500.0);
+    auto s = defaultSettings();
+    s.windowFunction = FtWorker::Hanning;
+
+    //spans view the shared data in place
+    auto raw = fid.rawSpan();
+    QCOMPARE(raw.data(),fid.rawData().constData());
+    QCOMPARE(raw.size(),fid.size());
+
+    auto before = Analysis::payloadCopies();
+    auto ft = w.doFT(fid,s);
+    auto y = ft.ySpan();
+    QCOMPARE(y.data(),ft.yData().constData());
+    QCOMPARE(Analysis::payloadCopies(),before);
+
+    fid.toVector();
+    QCOMPARE(Analysis::payloadCopies(),before+1);
+}
+
+void FtWorkerTest::benchmarkDoFT_data()
+{
+    QTest::addColumn<int>("size");
+
+    QTest::newRow("100k") << 100000;
+    QTest::newRow("750k") << 750000;
+    QTest::newRow("4M") << 4000000;
+}
+
+void FtWorkerTest::benchmarkDoFT()
+{
+    QFETCH(int,size);
+
+    FtWorker w;
+    auto fid = makeFid(size,2500.0);
+    auto s = defaultSettings();
+    s.windowFunction = FtWorker::BlackmanHarris;
+    s.zeroPadFactor = 1;
+
+    Ft ft;
+    QBENCHMARK {
+        ft = w.doFT(fid,s);
+    }
+    QVERIFY(!ft.isEmpty());
+}
+
+void FtWorkerTest::benchmarkCachedFT_data()
+{
+    QTest::addColumn<bool>("cached");
+    QTest::addColumn<bool>("changed");
+
+    QTest::newRow("doFT") << false << true;
+    QTest::newRow("cached changed") << true << true;
+    QTest::newRow("cached unchanged") << true << false;
+}
+
+void FtWorkerTest::benchmarkCachedFT()
+{
+    QFETCH(bool,cached);
+    QFETCH(bool,changed);
+
+    //a live update: a batch of shots is added to the sum before each FT
+    FtWorker w;
+    auto batch = makeFid(750000,2500.0);
+    auto fid = batch;
+    auto s = defaultSettings();
+    s.windowFunction = FtWorker::BlackmanHarris;
+
+    Ft ft;
+    QBENCHMARK {
+        if(changed)
+            fid.add(batch,0);
+        ft = cached ? w.cachedFT(fid,s,0) : w.doFT(fid,s,0);
+    }
+    QVERIFY(!ft.isEmpty());
+}
+
+QTEST_MAIN(FtWorkerTest)
+
+#include "tst_ftworkertest.moc"
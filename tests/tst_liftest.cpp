@@ -0,0 +1,502 @@
+#include <QtTest>
+
+#include <src/modules/lif/data/liftrace.h>
+#include <src/modules/lif/data/lifprocessor.h>
+#include <src/modules/lif/data/lifcubefile.h>
+#include <src/modules/lif/data/lifstorage.h>
+#include <src/data/storage/settingsstorage.h>
+#include <src/data/analysis/analysis.h>
+
+class LifTest : public QObject
+{
+    Q_OBJECT
+public:
+    LifTest() {};
+    ~LifTest() {};
+
+private slots:
+    void testIntegrate_data();
+    void testIntegrate();
+    void testSavGolKernel();
+    void testProcessorCache();
+    void testCubeFile();
+    void testDecode_data();
+    void testDecode();
+    void testRollAvg();
+    void benchmarkDecode_data();
+    void benchmarkDecode();
+
+private:
+    LifTrace makeTrace(int di, int li, int size, bool ref) const;
+    double reference(const LifTrace &t, const LifTrace::LifProcSettings &s) const;
+    LifDigitizerConfig makeConfig(int bpp, bool bigEndian, bool ref, bool interleaved) const;
+    QVector<qint8> makeWaveform(const LifDigitizerConfig &c) const;
+    QVector<qint64> referenceDecode(const QVector<qint8> &b, const LifDigitizerConfig &c, int channel) const;
+};
+
+LifTrace LifTest::makeTrace(int di, int li, int size, bool ref) const
+{
+    //gaussian pulse on a baseline with noise, summed over 10 shots
+    QVector<qint64> l(size), r;
+    if(ref)
+        r.resize(size);
+    for(int i=0; i<size; ++i)
+    {
+        double x = (i - size/3.0)/(size/20.0);
+        l[i] = static_cast<qint64>(10.0*(20.0 + 100.0*exp(-x*x))) + QRandomGenerator::global()->bounded(-30,30);
+        if(ref)
+            r[i] = static_cast<qint64>(10.0*(5.0 + 50.0*exp(-x*x/4.0))) + QRandomGenerator::global()->bounded(-30,30);
+    }
+
+    return LifTrace(di,li,l,r,10,1e-9,2e-3,5e-3);
+}
+
+double LifTest::reference(const LifTrace &t, const LifTrace::LifProcSettings &s) const
+{
+    //the original algorithm: process the whole scaled trace, then integrate the gate
+    auto process = [&s,&t](const QVector<qint64> &raw, double mult){
+        QVector<double> y(raw.size());
+        for(int i=0; i<raw.size(); ++i)
+            y[i] = static_cast<double>(raw.at(i))*mult/static_cast<double>(t.shots());
+        if(s.lowPassAlpha > 1e-5)
+        {
+            for(int i=1; i<y.size(); ++i)
+                y[i] = s.lowPassAlpha*y.at(i-1) + (1-s.lowPassAlpha)*y.at(i);
+        }
+        if(s.savGolEnabled)
+            y = Analysis::savGolSmooth(Analysis::calcSavGolCoefs(s.savGolWin,s.savGolPoly),0,y,t.xSpacingns());
+        return y;
+    };
+
+    auto integrate = [](const QVector<double> &y, int gs, int ge){
+        auto ls = qBound(0,gs,y.size()-2);
+        auto le = qBound(ls+1,ge,y.size()-1);
+        double sum = 0.0;
+        for(int i=ls; i<le-1; ++i)
+            sum += y.at(i) + y.at(i+1);
+        return sum/2.0;
+    };
+
+    auto lifInt = integrate(process(t.lifRaw(),t.lifYMult()),s.lifGateStart,s.lifGateEnd);
+    if(!t.hasRefData())
+        return lifInt;
+
+    auto refInt = integrate(process(t.refRaw(),t.refYMult()),s.refGateStart,s.refGateEnd);
+    if(qFuzzyCompare(1.0,1.0+refInt))
+        return lifInt;
+    return lifInt/refInt;
+}
+
+void LifTest::testIntegrate_data()
+{
+    QTest::addColumn<bool>("ref");
+    QTest::addColumn<double>("alpha");
+    QTest::addColumn<bool>("savGol");
+    QTest::addColumn<int>("gateStart");
+    QTest::addColumn<int>("gateEnd");
+
+    QTest::newRow("raw") << false << 0.0 << false << 200 << 500;
+    QTest::newRow("lowpass") << false << 0.3 << false << 200 << 500;
+    QTest::newRow("savgol") << false << 0.0 << true << 200 << 500;
+    QTest::newRow("both") << false << 0.3 << true << 200 << 500;
+    QTest::newRow("ref") << true << 0.3 << true << 200 << 500;
+    QTest::newRow("start edge") << true << 0.0 << true << 0 << 10;
+    QTest::newRow("end edge") << true << 0.2 << true << 990 << 2000;
+    QTest::newRow("out of range") << true << 0.0 << false << -10 << -5;
+}
+
+void LifTest::testIntegrate()
+{
+    QFETCH(bool,ref);
+    QFETCH(double,alpha);
+    QFETCH(bool,savGol);
+    QFETCH(int,gateStart);
+    QFETCH(int,gateEnd);
+
+    auto t = makeTrace(0,0,1000,ref);
+    LifTrace::LifProcSettings s{gateStart,gateEnd,gateStart+50,gateEnd+50,alpha,savGol,11,3};
+
+    auto expected = reference(t,s);
+    auto val = t.integrate(s);
+    QVERIFY(qAbs(val - expected) <= 1e-9*qMax(1.0,qAbs(expected)));
+
+    //the displayed trace uses the same filters
+    auto xy = t.lifToXY(s);
+    QCOMPARE(xy.size(),t.size());
+}
+
+void LifTest::testSavGolKernel()
+{
+    auto c = Analysis::calcSavGolCoefs(15,4);
+    auto k = Analysis::savGolKernel(15,4);
+    QCOMPARE(k.size(),15);
+    for(int i=0; i<k.size(); ++i)
+        QCOMPARE(k.at(i),c(i,0));
+
+    //cached kernels share their data
+    QCOMPARE(Analysis::savGolKernel(15,4).constData(),k.constData());
+}
+
+void LifTest::testProcessorCache()
+{
+    const int dp = 4, lp = 5;
+    QVector<LifTrace> traces;
+    for(int di=0; di<dp; ++di)
+    {
+        for(int li=0; li<lp; ++li)
+            traces.append(makeTrace(di,li,500,true));
+    }
+    auto f = [&traces](int di, int li){ return traces.at(di*lp + li); };
+
+    LifProcessor p;
+    p.reset(dp,lp);
+    LifTrace::LifProcSettings s{100,200,150,250,0.2,true,11,3};
+
+    auto out = p.process(s,f);
+    QCOMPARE(out.size(),dp*lp);
+    QCOMPARE(p.integrations(),2ull*dp*lp);
+    for(int i=0; i<out.size(); ++i)
+        QCOMPARE(out.at(i),traces.at(i).integrate(s));
+
+    //nothing changed
+    auto n = p.integrations();
+    QCOMPARE(p.process(s,f),out);
+    QCOMPARE(p.integrations(),n);
+
+    //moving the LIF gate leaves the reference integrals alone
+    s.lifGateEnd = 220;
+    out = p.process(s,f);
+    QCOMPARE(p.integrations(),n+dp*lp);
+    for(int i=0; i<out.size(); ++i)
+        QCOMPARE(out.at(i),traces.at(i).integrate(s));
+
+    //a changed trace is integrated again
+    n = p.integrations();
+    traces[7].add(makeTrace(1,2,500,true));
+    out = p.process(s,f);
+    QCOMPARE(p.integrations(),n+2);
+    QCOMPARE(out.at(7),traces.at(7).integrate(s));
+
+    //a live update with the same settings refreshes the cache
+    traces[3].add(makeTrace(0,3,500,true));
+    QCOMPARE(p.update(traces.at(3),s),traces.at(3).integrate(s));
+    n = p.integrations();
+    p.process(s,f);
+    QCOMPARE(p.integrations(),n);
+
+    //changing the filter invalidates everything
+    s.savGolWin = 15;
+    p.process(s,f);
+    QCOMPARE(p.integrations(),n+2*dp*lp);
+
+    //traces written through LifStorage keep their revision when they are read back
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVERIFY(QDir(dir.path()).mkpath(QString("%1/0/0/1").arg(BC::Key::exptDir)));
+    {
+        LifStorage st(dp,lp,1,dir.path());
+        st.start();
+        for(auto &t : traces)
+        {
+            st.addTrace(t);
+            st.advance();
+        }
+        st.finish();
+
+        QCOMPARE(st.getLifTrace(1,2).revision(),st.getLifTrace(1,2).revision());
+
+        auto sf = [&st](int di, int li){ return st.getLifTrace(di,li); };
+        p.reset(dp,lp);
+        out = p.process(s,sf);
+        QCOMPARE(p.integrations(),n+4*dp*lp);
+        for(int i=0; i<out.size(); ++i)
+            QCOMPARE(out.at(i),traces.at(i).integrate(s));
+
+        n = p.integrations();
+        QCOMPARE(p.process(s,sf),out);
+        QCOMPARE(p.integrations(),n);
+    }
+
+    //the same holds for a cube opened from disk
+    LifStorage st(dp,lp,1,dir.path());
+    st.finish();
+    auto sf = [&st](int di, int li){ return st.getLifTrace(di,li); };
+    p.reset(dp,lp);
+    out = p.process(s,sf);
+    QCOMPARE(p.integrations(),n+2*dp*lp);
+    n = p.integrations();
+    QCOMPARE(p.process(s,sf),out);
+    QCOMPARE(p.integrations(),n);
+}
+
+void LifTest::testCubeFile()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    auto path = dir.filePath("lifdata.bclif");
+
+    LifCubeFile::Layout l;
+    l.delayPoints = 3;
+    l.laserPoints = 4;
+    l.recordLength = 500;
+    l.refEnabled = true;
+    l.xSpacing = 1e-9;
+    l.lifYMult = 2e-3;
+    l.refYMult = 5e-3;
+
+    LifCubeFile c;
+    QVERIFY(c.create(path,l));
+    QCOMPARE(c.totalShots(),0ll);
+    QCOMPARE(c.readTrace(1,2).size(),0);
+
+    auto a = makeTrace(1,2,500,true);
+    auto b = makeTrace(2,0,500,true);
+    QVERIFY(c.writeTrace(a));
+    QVERIFY(c.writeTrace(b));
+    QVERIFY(!c.writeTrace(makeTrace(0,0,400,true)));
+    QVERIFY(!c.writeTrace(makeTrace(3,0,500,true)));
+
+    //a revisited cell is overwritten in place
+    a.add(makeTrace(1,2,500,true));
+    QVERIFY(c.writeTrace(a));
+    QCOMPARE(c.shots(1,2),20ll);
+    QCOMPARE(c.totalShots(),30ll);
+    c.close();
+
+    QVERIFY(c.open(path));
+    QVERIFY(!c.isWritable());
+    QCOMPARE(c.layout().recordLength,500);
+    QCOMPARE(c.layout().refYMult,5e-3);
+    auto r = c.readTrace(1,2);
+    QCOMPARE(r.lifRaw(),a.lifRaw());
+    QCOMPARE(r.refRaw(),a.refRaw());
+    QCOMPARE(r.shots(),a.shots());
+    QCOMPARE(r.lifYMult(),a.lifYMult());
+    QCOMPARE(c.readTrace(2,0).lifRaw(),b.lifRaw());
+
+    //a trace read with a revision keeps it, so repeated reads look unchanged to the processor
+    QCOMPARE(c.readTrace(1,2,true,a.revision()).revision(),a.revision());
+    QCOMPARE(c.readTrace(1,2,true,a.revision()).revision(),c.readTrace(1,2,true,a.revision()).revision());
+    c.close();
+
+    //a damaged cell fails its checksum and reads as missing
+    QFile f(path);
+    QVERIFY(f.open(QIODevice::ReadWrite));
+    auto off = LifCubeFile::headerSize + 12*LifCubeFile::cellRecordSize + 2*500*8*(1*4+2) + 16;
+    QVERIFY(f.seek(off));
+    QCOMPARE(f.write("x",1),1);
+    f.close();
+
+    QVERIFY(c.open(path));
+    QCOMPARE(c.readTrace(1,2).size(),0);
+    QCOMPARE(c.readTrace(1,2,false).size(),500);
+    QCOMPARE(c.readTrace(2,0).lifRaw(),b.lifRaw());
+}
+
+LifDigitizerConfig LifTest::makeConfig(int bpp, bool bigEndian, bool ref, bool interleaved) const
+{
+    LifDigitizerConfig c;
+    c.d_recordLength = 1001;
+    c.d_bytesPerPoint = bpp;
+    c.d_byteOrder = bigEndian ? DigitizerConfig::BigEndian : DigitizerConfig::LittleEndian;
+    c.d_refEnabled = ref;
+    c.d_channelOrder = interleaved ? LifDigitizerConfig::Interleaved : LifDigitizerConfig::Sequential;
+    c.d_numAverages = 4;
+    return c;
+}
+
+QVector<qint8> LifTest::makeWaveform(const LifDigitizerConfig &c) const
+{
+    QVector<qint8> out(c.d_recordLength*c.d_bytesPerPoint*(c.d_refEnabled ? 2 : 1));
+    for(int i=0; i<out.size(); ++i)
+        out[i] = static_cast<qint8>(QRandomGenerator::global()->bounded(256));
+
+    return out;
+}
+
+QVector<qint64> LifTest::referenceDecode(const QVector<qint8> &b, const LifDigitizerConfig &c, int channel) const
+{
+    //one sample at a time, in either channel order
+    QVector<qint64> out(c.d_recordLength);
+    bool interleaved = c.d_refEnabled && c.d_channelOrder == LifDigitizerConfig::Interleaved;
+    for(int i=0; i<c.d_recordLength; ++i)
+    {
+        int idx = interleaved ? 2*i + channel : channel*c.d_recordLength + i;
+        int off = idx*c.d_bytesPerPoint;
+        if(c.d_bytesPerPoint == 1)
+            out[i] = b.at(off);
+        else
+        {
+            auto lo = static_cast<quint8>(b.at(off));
+            auto hi = static_cast<quint8>(b.at(off+1));
+            if(c.d_byteOrder == DigitizerConfig::BigEndian)
+                qSwap(lo,hi);
+            out[i] = static_cast<qint16>(static_cast<quint16>((hi << 8) | lo));
+        }
+    }
+
+    return out;
+}
+
+void LifTest::testDecode_data()
+{
+    QTest::addColumn<int>("bpp");
+    QTest::addColumn<bool>("bigEndian");
+    QTest::addColumn<bool>("ref");
+    QTest::addColumn<bool>("interleaved");
+
+    for(int bpp : {1,2})
+    {
+        for(bool be : {false,true})
+        {
+            if(bpp == 1 && be)
+                continue;
+
+            auto name = QString("%1 byte%2").arg(bpp).arg(be ? " BE" : "");
+            QTest::newRow(QString("%1 lif only").arg(name).toLatin1().constData()) << bpp << be << false << true;
+            QTest::newRow(QString("%1 sequential").arg(name).toLatin1().constData()) << bpp << be << true << false;
+            QTest::newRow(QString("%1 interleaved").arg(name).toLatin1().constData()) << bpp << be << true << true;
+        }
+    }
+}
+
+void LifTest::testDecode()
+{
+    QFETCH(int,bpp);
+    QFETCH(bool,bigEndian);
+    QFETCH(bool,ref);
+    QFETCH(bool,interleaved);
+
+    auto c = makeConfig(bpp,bigEndian,ref,interleaved);
+    auto w1 = makeWaveform(c);
+    auto w2 = makeWaveform(c);
+
+    LifTrace t(c,w1,1,2);
+    QCOMPARE(t.size(),c.d_recordLength);
+    QCOMPARE(t.hasRefData(),ref);
+    QCOMPARE(t.shots(),4);
+    QCOMPARE(t.lifRaw(),referenceDecode(w1,c,0));
+    if(ref)
+        QCOMPARE(t.refRaw(),referenceDecode(w1,c,1));
+
+    //decoding straight into the sums matches adding a separately decoded trace
+    auto u = t;
+    auto rev = t.revision();
+    QVERIFY(u.addWaveform(c,w2));
+    t.add(LifTrace(c,w2,1,2));
+    QCOMPARE(u.lifRaw(),t.lifRaw());
+    QCOMPARE(u.refRaw(),t.refRaw());
+    QCOMPARE(u.shots(),8);
+    QVERIFY(u.revision() != rev);
+
+    auto l = referenceDecode(w1,c,0);
+    auto l2 = referenceDecode(w2,c,0);
+    for(int i=0; i<l.size(); ++i)
+        QCOMPARE(u.lifRaw().at(i),l.at(i)+l2.at(i));
+
+    //a waveform that does not match the trace is rejected
+    auto c2 = makeConfig(bpp,bigEndian,!ref,interleaved);
+    QVERIFY(!u.addWaveform(c2,makeWaveform(c2)));
+    w2.resize(w2.size()/2);
+    QVERIFY(!u.addWaveform(c,w2));
+    QCOMPARE(u.shots(),8);
+}
+
+void LifTest::testRollAvg()
+{
+    //the rolling average must round exactly as intRoundClosest does
+    auto t = makeTrace(0,0,2000,true);
+    auto ref = t;
+    for(int n=0; n<25; ++n)
+    {
+        auto s = makeTrace(0,0,2000,true);
+        auto l = ref.lifRaw(), r = ref.refRaw();
+        auto sl = s.lifRaw(), sr = s.refRaw();
+        int numShots = 15;
+        if(ref.shots() + s.shots() > numShots)
+        {
+            for(int i=0; i<l.size(); ++i)
+            {
+                l[i] = Analysis::intRoundClosest(numShots*(l.at(i)+sl.at(i)),numShots+1);
+                r[i] = Analysis::intRoundClosest(numShots*(r.at(i)+sr.at(i)),numShots+1);
+            }
+            ref = LifTrace(0,0,l,r,numShots,1e-9,2e-3,5e-3);
+        }
+        else
+            ref.add(s);
+
+        t.rollAvg(s,numShots);
+        QCOMPARE(t.lifRaw(),ref.lifRaw());
+        QCOMPARE(t.refRaw(),ref.refRaw());
+        QCOMPARE(t.shots(),ref.shots());
+    }
+
+    //large and negative numerators
+    for(qint64 d : {1ll,2ll,7ll,1000ll,65537ll})
+    {
+        Analysis::RoundClosestDivider div(d);
+        for(int i=0; i<100000; ++i)
+        {
+            qint64 n = static_cast<qint64>(QRandomGenerator::global()->generate64() >> QRandomGenerator::global()->bounded(2,63));
+            if(i%2)
+                n = -n;
+            QCOMPARE(div(n),Analysis::intRoundClosest(n,d));
+
+            //exact halves
+            auto m = (n >> 20)*d + d/2;
+            QCOMPARE(div(m),Analysis::intRoundClosest(m,d));
+        }
+    }
+}
+
+void LifTest::benchmarkDecode_data()
+{
+    QTest::addColumn<bool>("legacy");
+    QTest::addColumn<int>("bpp");
+    QTest::addColumn<bool>("interleaved");
+
+    //the previous per-sample decode is only valid for 1 byte per point
+    QTest::newRow("legacy 1 byte interleaved") << true << 1 << true;
+    QTest::newRow("legacy 1 byte sequential") << true << 1 << false;
+    QTest::newRow("1 byte interleaved") << false << 1 << true;
+    QTest::newRow("1 byte sequential") << false << 1 << false;
+    QTest::newRow("2 byte interleaved") << false << 2 << true;
+    QTest::newRow("2 byte sequential") << false << 2 << false;
+}
+
+void LifTest::benchmarkDecode()
+{
+    QFETCH(bool,legacy);
+    QFETCH(int,bpp);
+    QFETCH(bool,interleaved);
+
+    auto c = makeConfig(bpp,false,true,interleaved);
+    c.d_recordLength = 10000;
+    auto w = makeWaveform(c);
+    LifTrace sum(c,w,0,0);
+
+    if(!legacy)
+    {
+        QBENCHMARK {
+            sum.addWaveform(c,w);
+        }
+        return;
+    }
+
+    //the decode and add that the LifTrace constructor and LifTrace::add used to perform
+    QBENCHMARK {
+        QVector<qint64> l(c.d_recordLength), r(c.d_recordLength);
+        int incr = interleaved ? 2 : 1;
+        int refoffset = interleaved ? 1 : c.d_recordLength;
+        for(int i=0; i<incr*c.d_recordLength; i+=incr)
+            l[i/incr] = static_cast<qint64>(w.at(i));
+        for(int i=refoffset; i<refoffset+incr*c.d_recordLength; i+=incr)
+            r[(i-refoffset)/incr] = static_cast<qint64>(w.at(i));
+
+        sum.add(LifTrace(0,0,l,r,c.d_numAverages,1.0,1.0,1.0));
+    }
+}
+
+QTEST_MAIN(LifTest)
+
+#include "tst_liftest.moc"
@@ -0,0 +1,78 @@
+#include <QtTest>
+
+#include <src/acquisition/shotqueue.h>
+#include <src/data/experiment/digitizerconfig.h>
+
+class ShotQueueTest : public QObject
+{
+    Q_OBJECT
+public:
+    ShotQueueTest() {};
+    ~ShotQueueTest() {};
+
+private slots:
+    void testEffectivePolicy_data();
+    void testEffectivePolicy();
+    void testScoredOverflow();
+
+private:
+    DigitizerConfig makeConfig() const;
+};
+
+DigitizerConfig ShotQueueTest::makeConfig() const
+{
+    DigitizerConfig c("ShotQueueTest");
+    c.d_numRecords = 1;
+    c.d_recordLength = 100;
+    c.d_bytesPerPoint = 1;
+    return c;
+}
+
+void ShotQueueTest::testEffectivePolicy_data()
+{
+    QTest::addColumn<int>("policy");
+    QTest::addColumn<bool>("chirpScoring");
+    QTest::addColumn<bool>("phaseCorrection");
+    QTest::addColumn<int>("expected");
+
+    QTest::newRow("coalesce") << (int)ShotQueue::Coalesce << false << false << (int)ShotQueue::Coalesce;
+    QTest::newRow("coalesce scored") << (int)ShotQueue::Coalesce << true << false << (int)ShotQueue::DropOldest;
+    QTest::newRow("coalesce phase") << (int)ShotQueue::Coalesce << false << true << (int)ShotQueue::DropOldest;
+    QTest::newRow("coalesce both") << (int)ShotQueue::Coalesce << true << true << (int)ShotQueue::DropOldest;
+    QTest::newRow("block scored") << (int)ShotQueue::Block << true << true << (int)ShotQueue::Block;
+    QTest::newRow("drop scored") << (int)ShotQueue::DropOldest << true << true << (int)ShotQueue::DropOldest;
+}
+
+void ShotQueueTest::testEffectivePolicy()
+{
+    QFETCH(int,policy);
+    QFETCH(bool,chirpScoring);
+    QFETCH(bool,phaseCorrection);
+    QFETCH(int,expected);
+
+    QCOMPARE((int)ShotQueue::effectivePolicy(static_cast<ShotQueue::Policy>(policy),chirpScoring,phaseCorrection),expected);
+}
+
+void ShotQueueTest::testScoredOverflow()
+{
+    //with chirp scoring on, an overflowing queue drops shots instead of summing them unscored
+    auto c = makeConfig();
+    ShotQueue q;
+    QVERIFY(q.reset(c,0,2,ShotQueue::effectivePolicy(ShotQueue::Coalesce,true,false)));
+    QCOMPARE(q.policy(),ShotQueue::DropOldest);
+
+    QByteArray b(100,'\1');
+    for(int i=0; i<5; ++i)
+        QVERIFY(q.push(b));
+
+    QCOMPARE(q.size(),2);
+    QCOMPARE(q.droppedShots(),3ull);
+    QCOMPARE(q.coalescedShots(),0ull);
+
+    FidList l;
+    QVERIFY(!q.takeCoalesced(l));
+}
+
+QTEST_MAIN(ShotQueueTest)
+
+#include "tst_shotqueuetest.moc"